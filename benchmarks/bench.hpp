@@ -0,0 +1,183 @@
+// lightweight timing harness for the quaternion benchmarks
+#ifndef QUATERNION_BENCH_HPP
+#define QUATERNION_BENCH_HPP
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace quat11 {
+namespace bench {
+
+/** keep the compiler from optimizing a value away*/
+template <class T> inline void do_not_optimize(const T &v) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(v) : "memory");
+#else
+  const volatile T *p = &v;
+  (void)*p;
+#endif
+}
+
+/** time stamp counter, 0 where there is none*/
+inline std::uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct options {
+  unsigned int warmup;
+  unsigned int runs;
+  options() : warmup(3), runs(31) {}
+};
+
+struct result {
+  std::string name;
+  std::string type;
+  std::size_t ops;
+  double min_ns;
+  double median_ns;
+  double p90_ns;
+  double p99_ns;
+  double mean_ns;
+  double cycles;
+};
+/** a measured quantity that is not a timing, e.g. an error*/
+struct metric {
+  std::string name;
+  std::string type;
+  double value;
+};
+
+/** nearest rank percentile of sorted samples*/
+inline double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  std::size_t rank =
+      static_cast<std::size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+  if (rank >= sorted.size())
+    rank = sorted.size() - 1;
+  return sorted[rank];
+}
+
+class suite {
+public:
+  suite(const std::string &name, options opts = options())
+      : name_(name), opts_(opts) {}
+
+  /**
+    Run fn, which performs ops operations, warmup times untimed and
+    then runs times timed. Statistics are per operation.
+   */
+  template <class Fn>
+  void run(const std::string &name, const std::string &type, std::size_t ops,
+           Fn fn) {
+    for (unsigned int i = 0; i < opts_.warmup; i++)
+      fn();
+    std::vector<double> ns;
+    std::vector<double> cs;
+    ns.reserve(opts_.runs);
+    cs.reserve(opts_.runs);
+    for (unsigned int i = 0; i < opts_.runs; i++) {
+      auto start = std::chrono::steady_clock::now();
+      std::uint64_t c0 = cycles();
+      fn();
+      std::uint64_t c1 = cycles();
+      auto end = std::chrono::steady_clock::now();
+      double d = std::chrono::duration<double, std::nano>(end - start).count();
+      ns.push_back(d / static_cast<double>(ops));
+      cs.push_back(static_cast<double>(c1 - c0) / static_cast<double>(ops));
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(cs.begin(), cs.end());
+    result r;
+    r.name = name;
+    r.type = type;
+    r.ops = ops;
+    r.min_ns = ns.front();
+    r.median_ns = percentile(ns, 50.0);
+    r.p90_ns = percentile(ns, 90.0);
+    r.p99_ns = percentile(ns, 99.0);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < ns.size(); i++)
+      sum += ns[i];
+    r.mean_ns = sum / static_cast<double>(ns.size());
+    r.cycles = percentile(cs, 50.0);
+    results_.push_back(r);
+    std::cerr << name_ << " " << type << " " << name << " " << r.median_ns
+              << " ns/op " << r.cycles << " cycles/op" << std::endl;
+  }
+
+  /** record a value next to the timings, e.g. the error of a method*/
+  void record(const std::string &name, const std::string &type, double value) {
+    metric m;
+    m.name = name;
+    m.type = type;
+    m.value = value;
+    metrics_.push_back(m);
+    std::cerr << name_ << " " << type << " " << name << " " << value
+              << std::endl;
+  }
+  const std::vector<result> &results() const { return results_; }
+
+  void write_json(std::ostream &out) const {
+    out << "{\"suite\": \"" << name_ << "\", \"warmup\": " << opts_.warmup
+        << ", \"runs\": " << opts_.runs << ", \"results\": [";
+    for (std::size_t i = 0; i < results_.size(); i++) {
+      const result &r = results_[i];
+      out << (i == 0 ? "" : ",") << "\n  {\"name\": \"" << r.name
+          << "\", \"type\": \"" << r.type << "\", \"ops\": " << r.ops
+          << ", \"min_ns\": " << r.min_ns << ", \"median_ns\": " << r.median_ns
+          << ", \"p90_ns\": " << r.p90_ns << ", \"p99_ns\": " << r.p99_ns
+          << ", \"mean_ns\": " << r.mean_ns << ", \"cycles\": " << r.cycles
+          << "}";
+    }
+    out << "\n]";
+    if (!metrics_.empty()) {
+      out << ", \"metrics\": [";
+      for (std::size_t i = 0; i < metrics_.size(); i++) {
+        const metric &m = metrics_[i];
+        out << (i == 0 ? "" : ",") << "\n  {\"name\": \"" << m.name
+            << "\", \"type\": \"" << m.type << "\", \"value\": " << m.value
+            << "}";
+      }
+      out << "\n]";
+    }
+    out << "}" << std::endl;
+  }
+
+  /** JSON goes to the file given as first argument or to stdout*/
+  int finish(int argc, const char *argv[]) const {
+    if (argc > 1) {
+      std::ofstream f(argv[1]);
+      if (!f)
+        return 1;
+      write_json(f);
+      return 0;
+    }
+    write_json(std::cout);
+    return 0;
+  }
+
+private:
+  std::string name_;
+  options opts_;
+  std::vector<result> results_;
+  std::vector<metric> metrics_;
+};
+
+} // namespace bench
+} // namespace quat11
+
+#endif
@@ -0,0 +1,11 @@
+// benchmarks for the header only quaternion
+#include "../quaternion.hpp"
+
+#include "quat_benchs.cpp"
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion.hpp");
+  quat_benchs<float>(s, "float");
+  quat_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,12 @@
+// benchmarks for the quaternion.h build linked against the quaternion
+// library
+#include "../quaternion.h"
+
+#include "quat_benchs.cpp"
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion.h");
+  quat_benchs<float>(s, "float");
+  quat_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,63 @@
+// per frame scratch batches from the heap against an arena
+#include "../quaternion_allocator.hpp"
+#include "../quaternion_batch.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t SMALL = 1024;
+static const std::size_t LARGE = 65536;
+
+/** one frame: three scratch batches, a product and a relative pass*/
+template <class Batch>
+void frame(std::size_t n, const typename Batch::allocator_type &alloc) {
+  typedef typename Batch::allocator_type::value_type T;
+  Batch a(n, alloc), b(n, alloc), out(n, alloc);
+  for (unsigned int k = 0; k < 4; k++) {
+    T *pa = a.data(k);
+    T *pb = b.data(k);
+    for (std::size_t i = 0; i < n; i++) {
+      pa[i] = static_cast<T>(1 + k) + static_cast<T>(i % 7);
+      pb[i] = static_cast<T>(4 - k) - static_cast<T>(i % 5);
+    }
+  }
+  a.hamilton_product(b, out);
+  out.relative(a, out);
+  bench::do_not_optimize(out.data(0)[n - 1]);
+}
+
+template <class T>
+void allocator_benchs(bench::suite &s, const char *type, std::size_t n,
+                      const std::string &size) {
+  typedef quaternion_batch<T> heap_batch;
+  typedef quaternion_batch<T, arena_allocator<T>> arena_batch;
+  quaternion_arena arena(3 * 4 * n * sizeof(T) + 12 * QUATERNION_CACHE_LINE);
+
+  s.run("alloc_only_heap_" + size, type, 1, [&]() {
+    heap_batch a(n), b(n), out(n);
+    bench::do_not_optimize(out.data(0));
+  });
+  s.run("alloc_only_arena_" + size, type, 1, [&]() {
+    {
+      arena_allocator<T> alloc(arena);
+      arena_batch a(n, alloc), b(n, alloc), out(n, alloc);
+      bench::do_not_optimize(out.data(0));
+    }
+    arena.reset();
+  });
+  s.run("frame_heap_" + size, type, 1,
+        [&]() { frame<heap_batch>(n, std::allocator<T>()); });
+  s.run("frame_arena_" + size, type, 1, [&]() {
+    frame<arena_batch>(n, arena_allocator<T>(arena));
+    arena.reset();
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_allocator.hpp");
+  allocator_benchs<float>(s, "float", SMALL, "1k");
+  allocator_benchs<float>(s, "float", LARGE, "64k");
+  allocator_benchs<double>(s, "double", SMALL, "1k");
+  allocator_benchs<double>(s, "double", LARGE, "64k");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,85 @@
+// structure of arrays batches against loops over quaternion<T>
+#include "../quaternion_batch.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <numeric>
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void batch_benchs(bench::suite &s, const char *type) {
+  std::vector<quaternion<T>> qs;
+  std::vector<quaternion<T>> ps;
+  quaternion_batch<T> qb;
+  quaternion_batch<T> pb;
+  for (std::size_t i = 0; i < N; i++) {
+    T a = static_cast<T>(1 + (i % 7));
+    T b = static_cast<T>(1 + (i % 5)) * static_cast<T>(0.5);
+    T c = static_cast<T>(1 + (i % 3)) * static_cast<T>(0.25);
+    T d = static_cast<T>(1 + (i % 11)) * static_cast<T>(0.125);
+    qs.push_back(quaternion<T>(a, b, c, d));
+    ps.push_back(quaternion<T>(d, -c, b, -a));
+    qb.push_back(qs.back());
+    pb.push_back(ps.back());
+  }
+  std::vector<quaternion<T>> outs(N);
+  quaternion_batch<T> ob(N);
+
+  s.run("inversed_aos", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++)
+      qs[i].inversed(outs[i]);
+    bench::do_not_optimize(outs[N - 1]);
+  });
+  s.run("inversed_soa", type, N, [&]() {
+    qb.inversed(ob);
+    bench::do_not_optimize(ob.data(0)[N - 1]);
+  });
+  s.run("hamilton_product_aos", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++)
+      qs[i].hamilton_product(ps[i], outs[i]);
+    bench::do_not_optimize(outs[N - 1]);
+  });
+  s.run("hamilton_product_soa", type, N, [&]() {
+    qb.hamilton_product(pb, ob);
+    bench::do_not_optimize(ob.data(0)[N - 1]);
+  });
+  s.run("relative_aos", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++)
+      outs[i] = qs[i].inverse() * ps[i];
+    bench::do_not_optimize(outs[N - 1]);
+  });
+  s.run("relative_soa", type, N, [&]() {
+    qb.relative(pb, ob);
+    bench::do_not_optimize(ob.data(0)[N - 1]);
+  });
+  s.run("hamilton_product_std_transform", type, N, [&]() {
+    std::transform(qb.begin(), qb.end(), pb.begin(), ob.begin(),
+                   [](const quaternion<T> &a, const quaternion<T> &b) {
+                     return a * b;
+                   });
+    bench::do_not_optimize(ob.data(0)[N - 1]);
+  });
+  // unit factors so that the products stay finite
+  quaternion_batch<T> ub(N);
+  for (std::size_t i = 0; i < N; i++)
+    ub[i] = qs[i].normalize();
+  s.run("product_std_accumulate", type, N, [&]() {
+    quaternion<T> p = std::accumulate(ub.begin(), ub.end(),
+                                      quaternion<T>(1, 0, 0, 0),
+                                      hamilton_multiplies<T>());
+    bench::do_not_optimize(p);
+  });
+  s.run("reduce_product", type, N, [&]() {
+    quaternion<T> p;
+    ub.reduce_product(p);
+    bench::do_not_optimize(p);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_batch.hpp");
+  batch_benchs<float>(s, "float");
+  batch_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,39 @@
+// point cloud rotation in memory: quaternion::rotate per point and
+// the matrix kernel behind the file tool
+#include "../quaternion_cloud.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 1 << 20;
+
+template <class T> void cloud_benchs(bench::suite &s, const char *type) {
+  std::vector<T> in(3 * N), out(3 * N);
+  for (std::size_t i = 0; i < in.size(); i++)
+    in[i] = std::sin(static_cast<T>(i % 1000) * static_cast<T>(0.0063));
+  quaternion<T> q(static_cast<T>(0.9), static_cast<T>(-0.2),
+                  static_cast<T>(0.3), static_cast<T>(0.1));
+  const T t[3] = {1, 2, 3};
+
+  s.run("rotate_one_by_one", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      q.rotate(&in[3 * i], &out[3 * i]);
+      for (unsigned int k = 0; k < 3; k++)
+        out[3 * i + k] += t[k];
+    }
+    bench::do_not_optimize(out);
+  });
+  s.run("rotate_points", type, N, [&]() {
+    rotate_points(q, t, in.data(), N, out.data());
+    bench::do_not_optimize(out);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.runs = 11;
+  bench::suite s("quaternion_cloud.hpp", opts);
+  cloud_benchs<float>(s, "float");
+  cloud_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
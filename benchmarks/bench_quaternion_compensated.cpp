@@ -0,0 +1,80 @@
+// compensated float products against plain float and double, with
+// the error of each method against a double reference
+#include "../quaternion_compensated.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+static double max_error(const quaternion<double> &a,
+                        const quaternion<double> &b) {
+  double ca[4], cb[4];
+  a.scalar(ca[0]);
+  a.vector(ca + 1);
+  b.scalar(cb[0]);
+  b.vector(cb + 1);
+  double e = 0;
+  for (unsigned int k = 0; k < 4; k++)
+    e = std::fabs(ca[k] - cb[k]) > e ? std::fabs(ca[k] - cb[k]) : e;
+  return e;
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_compensated.hpp");
+  quaternion<float> step(0.99995f, 0.00577f, -0.00577f, 0.00577f);
+  quaternion<double> step_d(0.99995f, 0.00577f, -0.00577f, 0.00577f);
+  compensated_quaternion<float> comp_step(step);
+
+  s.run("chain_plain", "float", N, [&]() {
+    quaternion<float> acc(1, 0, 0, 0);
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(step, acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("chain_plain", "double", N, [&]() {
+    quaternion<double> acc(1, 0, 0, 0);
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(step_d, acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("chain_compensated", "float", N, [&]() {
+    compensated_quaternion<float> acc(quaternion<float>(1, 0, 0, 0));
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(comp_step, acc);
+    bench::do_not_optimize(acc);
+  });
+  std::vector<quaternion<float>> qs(N, step);
+  s.run("sum_plain", "float", N, [&]() {
+    quaternion<float> acc(0, 0, 0, 0);
+    for (std::size_t i = 0; i < N; i++)
+      acc.add(qs[i], acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("sum_compensated", "float", N, [&]() {
+    quaternion<float> acc;
+    compensated_sum(qs.data(), N, acc);
+    bench::do_not_optimize(acc);
+  });
+
+  // error after a million products against a double chain of the
+  // same float step
+  const std::size_t chain = 1000000;
+  quaternion<float> plain(1, 0, 0, 0);
+  quaternion<double> ref(1, 0, 0, 0);
+  compensated_quaternion<float> comp(plain);
+  for (std::size_t i = 0; i < chain; i++) {
+    plain.hamilton_product(step, plain);
+    ref.hamilton_product(step_d, ref);
+    comp.hamilton_product(comp_step, comp);
+  }
+  float pc[4];
+  plain.scalar(pc[0]);
+  plain.vector(pc + 1);
+  quaternion<double> comp_d;
+  comp.widened(comp_d);
+  s.record("chain_1e6_max_error_plain", "float",
+           max_error(quaternion<double>(pc[0], pc[1], pc[2], pc[3]), ref));
+  s.record("chain_1e6_max_error_compensated", "float", max_error(comp_d, ref));
+  return s.finish(argc, argv);
+}
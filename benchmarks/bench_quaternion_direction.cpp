@@ -0,0 +1,92 @@
+// rotations from directions: hand written user code with a branch for
+// opposite vectors, the scalar factories and the batched forms
+#include "../quaternion_direction.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 1 << 20;
+
+template <class T> void direction_benchs(bench::suite &s, const char *type) {
+  std::vector<T> a[3], b[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    a[k].resize(N);
+    b[k].resize(N);
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    T t = static_cast<T>(i % 1000) * static_cast<T>(0.0063);
+    a[0][i] = std::cos(t);
+    a[1][i] = std::sin(t);
+    a[2][i] = static_cast<T>(0.3);
+    b[0][i] = static_cast<T>(i % 3);
+    b[1][i] = std::cos(3 * t);
+    b[2][i] = std::sin(2 * t);
+  }
+  const T *ap[3] = {a[0].data(), a[1].data(), a[2].data()};
+  const T *bp[3] = {b[0].data(), b[1].data(), b[2].data()};
+  const T up[3] = {0, 0, 1};
+  std::vector<quaternion<T>> aos(N);
+
+  s.run("two_vectors_user_code", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> qa(0, a[0][i], a[1][i], a[2][i]);
+      T v[3] = {b[0][i], b[1][i], b[2][i]};
+      T c[3], d = 0;
+      qa.vector_cross(v, c);
+      qa.vector_dot(v, d);
+      T na = 0, nb = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+      qa.norm(na);
+      T w = na * nb + d;
+      quaternion<T> q(w, c[0], c[1], c[2]);
+      if (w <= std::numeric_limits<T>::epsilon() * na * nb)
+        q = quaternion<T>(0, -a[1][i], a[0][i], 0);
+      q.normalized(aos[i]);
+    }
+    bench::do_not_optimize(aos);
+  });
+  s.run("two_vectors_one_by_one", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T u[3] = {a[0][i], a[1][i], a[2][i]};
+      T v[3] = {b[0][i], b[1][i], b[2][i]};
+      unit_quaternion<T> q;
+      unit_quaternion<T>::from_two_vectors(u, v, q);
+      aos[i] = q.get();
+    }
+    bench::do_not_optimize(aos);
+  });
+  quaternion_batch<T> out;
+  s.run("two_vectors_batch", type, N, [&]() {
+    from_two_vectors(ap, bp, N, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("two_vectors_batch_4_threads", type, N, [&]() {
+    from_two_vectors(ap, bp, N, out, 4);
+    bench::do_not_optimize(out);
+  });
+  s.run("look_at_one_by_one", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T f[3] = {a[0][i], a[1][i], a[2][i]};
+      unit_quaternion<T> q;
+      unit_quaternion<T>::look_at(f, up, q);
+      aos[i] = q.get();
+    }
+    bench::do_not_optimize(aos);
+  });
+  s.run("look_at_batch", type, N, [&]() {
+    look_at(ap, up, N, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("look_at_batch_4_threads", type, N, [&]() {
+    look_at(ap, up, N, out, 4);
+    bench::do_not_optimize(out);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.runs = 11;
+  bench::suite s("quaternion_direction.hpp", opts);
+  direction_benchs<float>(s, "float");
+  direction_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,78 @@
+// fused batched distances and top-k against per pair products
+#include "../quaternion_distance.hpp"
+#include "../quaternion_random.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t SET = 65536;
+static const std::size_t ROWS = 64;
+
+template <class T> void distance_benchs(bench::suite &s, const char *type) {
+  random_rotations<T> gen(7);
+  quaternion_batch<T> set;
+  gen.generate(SET, set);
+  quaternion_batch<T> rows;
+  gen.generate(ROWS, rows, SET);
+  quaternion<T> q;
+  rows.get(0, q);
+  std::vector<quaternion<T>> aos(SET);
+  for (std::size_t i = 0; i < SET; i++)
+    set.get(i, aos[i]);
+  std::vector<T> out(SET);
+
+  s.run("pairwise_conjugate_product", type, SET, [&]() {
+    using std::acos;
+    using std::fabs;
+    quaternion<T> conj;
+    q.conjugate(conj);
+    for (std::size_t i = 0; i < SET; i++) {
+      quaternion<T> r;
+      conj.hamilton_product(aos[i], r);
+      T w;
+      r.scalar(w);
+      w = fabs(w);
+      out[i] = static_cast<T>(2) *
+               acos(w > static_cast<T>(1) ? static_cast<T>(1) : w);
+    }
+    bench::do_not_optimize(out);
+  });
+  s.run("one_vs_many_geodesic", type, SET, [&]() {
+    distances(q, set, METRIC_GEODESIC, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("one_vs_many_chordal", type, SET, [&]() {
+    distances(q, set, METRIC_CHORDAL, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("one_vs_many_cosine", type, SET, [&]() {
+    distances(q, set, METRIC_COSINE, out);
+    bench::do_not_optimize(out);
+  });
+  std::vector<T> matrix;
+  s.run("many_vs_many_cosine", type, ROWS * SET, [&]() {
+    distances(rows, set, METRIC_COSINE, matrix);
+    bench::do_not_optimize(matrix);
+  });
+  s.run("many_vs_many_cosine_4_threads", type, ROWS * SET, [&]() {
+    distances(rows, set, METRIC_COSINE, matrix, 4);
+    bench::do_not_optimize(matrix);
+  });
+  s.run("sort_all_top_10", type, SET, [&]() {
+    distances(q, set, METRIC_GEODESIC, out);
+    std::partial_sort(out.begin(), out.begin() + 10, out.end());
+    bench::do_not_optimize(out);
+  });
+  std::vector<orientation_neighbor<T>> nb;
+  s.run("nearest_k_10", type, SET, [&]() {
+    nearest_k(q, set, 10, nb);
+    bench::do_not_optimize(nb);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_distance.hpp");
+  distance_benchs<float>(s, "float");
+  distance_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,43 @@
+// throughput of Q1.30 fixed point quaternions against float
+#include "../quaternion_fixed.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void fixed_benchs(bench::suite &s, const char *type) {
+  T h = static_cast<T>(0.7071067811865476);
+  T e = static_cast<T>(0.001);
+  quaternion<T> step(static_cast<T>(0.99995), e, e, e);
+  quaternion<T> q(h, static_cast<T>(0), h, static_cast<T>(0));
+
+  s.run("hamilton_product", type, N, [&]() {
+    quaternion<T> acc = q;
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(step, acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("product_normalized", type, N, [&]() {
+    quaternion<T> acc = q;
+    for (std::size_t i = 0; i < N; i++) {
+      acc.hamilton_product(step, acc);
+      acc.normalized(acc);
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("rotate", type, N, [&]() {
+    T out[3] = {static_cast<T>(0.5), static_cast<T>(0.25),
+                static_cast<T>(0.125)};
+    for (std::size_t i = 0; i < N; i++)
+      step.rotate(out, out);
+    bench::do_not_optimize(out);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_fixed.hpp");
+  fixed_benchs<float>(s, "float");
+  fixed_benchs<q1_30>(s, "q1_30");
+  return s.finish(argc, argv);
+}
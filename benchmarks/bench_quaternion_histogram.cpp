@@ -0,0 +1,59 @@
+// orientation binning, batch pass and threaded histograms
+#include "../quaternion_histogram.hpp"
+#include "../quaternion_random.hpp"
+#include "bench.hpp"
+#include <thread>
+
+using namespace quat11;
+
+static const std::size_t N = 1 << 16;
+
+template <class T> void histogram_benchs(bench::suite &s, const char *type) {
+  so3_grid<T> g;
+  so3_grid<T>::from_resolution(16, g);
+  random_rotations<T> gen(3);
+  quaternion_batch<T> b;
+  gen.generate(N, b);
+  std::vector<std::uint32_t> bins;
+  s.run("bin_one_by_one", type, N, [&]() {
+    std::uint32_t acc = 0;
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> q;
+      b.get(i, q);
+      std::uint32_t k = 0;
+      g.bin(q, k);
+      acc += k;
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("bin_batch", type, N, [&]() {
+    g.bin(b, bins);
+    bench::do_not_optimize(bins[N - 1]);
+  });
+  so3_histogram h(g.size());
+  s.run("histogram_add", type, N, [&]() {
+    h.add(g, b);
+    bench::do_not_optimize(h);
+  });
+  const unsigned int threads = 4;
+  shared_so3_histogram total(g.size());
+  s.run("histogram_4_threads_merge", type, threads * N, [&]() {
+    std::thread workers[threads];
+    for (unsigned int t = 0; t < threads; t++) {
+      workers[t] = std::thread([&]() {
+        so3_histogram local(g.size());
+        local.add(g, b);
+        local.merge_into(total);
+      });
+    }
+    for (unsigned int t = 0; t < threads; t++)
+      workers[t].join();
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_histogram.hpp");
+  histogram_benchs<float>(s, "float");
+  histogram_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
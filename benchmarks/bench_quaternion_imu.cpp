@@ -0,0 +1,85 @@
+// Madgwick and Mahony updates, one filter at a time against the
+// structure of arrays batches, reported as filter updates per second
+#include "../quaternion_imu.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t FILTERS = 4096;
+
+/** updates per second of the last run*/
+static void record_rate(bench::suite &s, const char *name, const char *type) {
+  s.record(name, type, 1e9 / s.results().back().median_ns);
+}
+
+template <class T> void imu_benchs(bench::suite &s, const char *type) {
+  std::vector<T> g[3], a[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    g[k].resize(FILTERS);
+    a[k].resize(FILTERS);
+  }
+  for (std::size_t i = 0; i < FILTERS; i++) {
+    T t = static_cast<T>(i) * static_cast<T>(0.001);
+    g[0][i] = static_cast<T>(0.1) * t;
+    g[1][i] = static_cast<T>(-0.05);
+    g[2][i] = static_cast<T>(0.2);
+    a[0][i] = static_cast<T>(0.3);
+    a[1][i] = t;
+    a[2][i] = static_cast<T>(9.8);
+  }
+  const T *gp[3] = {g[0].data(), g[1].data(), g[2].data()};
+  const T *ap[3] = {a[0].data(), a[1].data(), a[2].data()};
+  const T dt = static_cast<T>(0.005);
+
+  std::vector<madgwick_filter<T>> ms(FILTERS);
+  s.run("madgwick_one_by_one", type, FILTERS, [&]() {
+    for (std::size_t i = 0; i < FILTERS; i++) {
+      T gi[3] = {g[0][i], g[1][i], g[2][i]};
+      T ai[3] = {a[0][i], a[1][i], a[2][i]};
+      ms[i].update(gi, ai, dt);
+    }
+    bench::do_not_optimize(ms);
+  });
+  record_rate(s, "madgwick_one_by_one_updates_per_s", type);
+  madgwick_batch<T> mb(FILTERS);
+  s.run("madgwick_batch", type, FILTERS, [&]() {
+    mb.update(gp, ap, dt);
+    bench::do_not_optimize(mb);
+  });
+  record_rate(s, "madgwick_batch_updates_per_s", type);
+  s.run("madgwick_batch_4_threads", type, FILTERS, [&]() {
+    mb.update(gp, ap, dt, 4);
+    bench::do_not_optimize(mb);
+  });
+  record_rate(s, "madgwick_batch_4_threads_updates_per_s", type);
+
+  std::vector<mahony_filter<T>> hs(FILTERS,
+                                   mahony_filter<T>(1, static_cast<T>(0.1)));
+  s.run("mahony_one_by_one", type, FILTERS, [&]() {
+    for (std::size_t i = 0; i < FILTERS; i++) {
+      T gi[3] = {g[0][i], g[1][i], g[2][i]};
+      T ai[3] = {a[0][i], a[1][i], a[2][i]};
+      hs[i].update(gi, ai, dt);
+    }
+    bench::do_not_optimize(hs);
+  });
+  record_rate(s, "mahony_one_by_one_updates_per_s", type);
+  mahony_batch<T> hb(FILTERS, 1, static_cast<T>(0.1));
+  s.run("mahony_batch", type, FILTERS, [&]() {
+    hb.update(gp, ap, dt);
+    bench::do_not_optimize(hb);
+  });
+  record_rate(s, "mahony_batch_updates_per_s", type);
+  s.run("mahony_batch_4_threads", type, FILTERS, [&]() {
+    hb.update(gp, ap, dt, 4);
+    bench::do_not_optimize(hb);
+  });
+  record_rate(s, "mahony_batch_4_threads_updates_per_s", type);
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_imu.hpp");
+  imu_benchs<float>(s, "float");
+  imu_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
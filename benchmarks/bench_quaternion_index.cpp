@@ -0,0 +1,76 @@
+// orientation index queries against a linear scan of dot products
+#include "../quaternion_index.hpp"
+#include "../quaternion_random.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t SET = 100000;
+static const std::size_t QUERIES = 256;
+
+template <class T> void index_benchs(bench::suite &s, const char *type) {
+  random_rotations<T> gen(5);
+  quaternion_batch<T> set;
+  gen.generate(SET, set);
+  quaternion_batch<T> queries;
+  gen.generate(QUERIES, queries, SET);
+  orientation_index<T> idx;
+  s.run("build_100k", type, 1, [&]() {
+    idx.build(set);
+    bench::do_not_optimize(idx);
+  });
+  s.run("linear_scan_nearest", type, QUERIES, [&]() {
+    for (std::size_t j = 0; j < QUERIES; j++) {
+      T best = static_cast<T>(-1);
+      std::size_t bi = 0;
+      for (std::size_t i = 0; i < SET; i++) {
+        T d = std::fabs(set.data(0)[i] * queries.data(0)[j] +
+                        set.data(1)[i] * queries.data(1)[j] +
+                        set.data(2)[i] * queries.data(2)[j] +
+                        set.data(3)[i] * queries.data(3)[j]);
+        if (d > best) {
+          best = d;
+          bi = i;
+        }
+      }
+      bench::do_not_optimize(bi);
+    }
+  });
+  s.run("index_nearest", type, QUERIES, [&]() {
+    for (std::size_t j = 0; j < QUERIES; j++) {
+      quaternion<T> q;
+      queries.get(j, q);
+      orientation_neighbor<T> nb;
+      idx.nearest(q, nb);
+      bench::do_not_optimize(nb);
+    }
+  });
+  s.run("index_knn_10", type, QUERIES, [&]() {
+    std::vector<orientation_neighbor<T>> out;
+    for (std::size_t j = 0; j < QUERIES; j++) {
+      quaternion<T> q;
+      queries.get(j, q);
+      idx.knn(q, 10, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("index_radius_0.1", type, QUERIES, [&]() {
+    std::vector<orientation_neighbor<T>> out;
+    for (std::size_t j = 0; j < QUERIES; j++) {
+      quaternion<T> q;
+      queries.get(j, q);
+      idx.radius(q, static_cast<T>(0.1), out);
+      bench::do_not_optimize(out);
+    }
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.warmup = 1;
+  opts.runs = 5;
+  bench::suite s("quaternion_index.hpp", opts);
+  index_benchs<float>(s, "float");
+  index_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
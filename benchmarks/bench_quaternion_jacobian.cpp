@@ -0,0 +1,119 @@
+// jacobians of rotate and log: forward mode dual numbers, one pass
+// per input, against the analytic forms
+#include "../quaternion_jacobian.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 1 << 16;
+
+namespace ad {
+/** minimal forward mode dual number, math found by adl*/
+template <class T> struct dual {
+  T v, d;
+  dual() : v(0), d(0) {}
+  explicit dual(T a, T b = 0) : v(a), d(b) {}
+};
+template <class T> dual<T> operator+(dual<T> a, dual<T> b) {
+  return dual<T>(a.v + b.v, a.d + b.d);
+}
+template <class T> dual<T> operator-(dual<T> a, dual<T> b) {
+  return dual<T>(a.v - b.v, a.d - b.d);
+}
+template <class T> dual<T> operator-(dual<T> a) { return dual<T>(-a.v, -a.d); }
+template <class T> dual<T> operator*(dual<T> a, dual<T> b) {
+  return dual<T>(a.v * b.v, a.d * b.v + a.v * b.d);
+}
+template <class T> dual<T> operator/(dual<T> a, dual<T> b) {
+  return dual<T>(a.v / b.v, (a.d * b.v - a.v * b.d) / (b.v * b.v));
+}
+template <class T> bool operator==(dual<T> a, dual<T> b) { return a.v == b.v; }
+template <class T> bool operator<(dual<T> a, dual<T> b) { return a.v < b.v; }
+template <class T> dual<T> sqrt(dual<T> a) {
+  T s = std::sqrt(a.v);
+  return dual<T>(s, a.d / (2 * s));
+}
+template <class T> dual<T> log(dual<T> a) {
+  return dual<T>(std::log(a.v), a.d / a.v);
+}
+template <class T> dual<T> atan2(dual<T> y, dual<T> x) {
+  return dual<T>(std::atan2(y.v, x.v),
+                 (x.v * y.d - y.v * x.d) / (x.v * x.v + y.v * y.v));
+}
+} // namespace ad
+
+template <class T> void jacobian_benchs(bench::suite &s, const char *type) {
+  typedef ad::dual<T> D;
+  std::vector<quaternion<T>> qs(N);
+  std::vector<T> vs(3 * N);
+  for (std::size_t i = 0; i < N; i++) {
+    T t = static_cast<T>(i % 1000) * static_cast<T>(0.0063);
+    qs[i] = quaternion<T>(std::cos(t), std::sin(t), static_cast<T>(0.3),
+                          std::sin(2 * t));
+    vs[3 * i] = std::cos(3 * t);
+    vs[3 * i + 1] = static_cast<T>(0.5);
+    vs[3 * i + 2] = std::sin(t);
+  }
+  std::vector<T> jac(16 * N);
+
+  s.run("rotate_jacobian_dual", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T c[4];
+      qs[i].scalar(c[0]);
+      qs[i].vector(c + 1);
+      for (unsigned int j = 0; j < 7; j++) {
+        D d[4], v[3], o[3];
+        for (unsigned int k = 0; k < 4; k++)
+          d[k] = D(c[k], static_cast<T>(k == j));
+        for (unsigned int k = 0; k < 3; k++)
+          v[k] = D(vs[3 * i + k], static_cast<T>(k + 4 == j));
+        quaternion<D>(d).rotate(v, o);
+        for (unsigned int k = 0; k < 3; k++)
+          jac[16 * i + 3 * j + k] = o[k].d;
+      }
+    }
+    bench::do_not_optimize(jac);
+  });
+  s.run("rotate_jacobian_analytic", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T out[3];
+      rotate_jacobian(qs[i], &vs[3 * i], out, &jac[16 * i], &jac[16 * i + 12]);
+    }
+    bench::do_not_optimize(jac);
+  });
+  s.run("log_jacobian_dual", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T c[4];
+      qs[i].scalar(c[0]);
+      qs[i].vector(c + 1);
+      for (unsigned int j = 0; j < 4; j++) {
+        D d[4], o[4];
+        for (unsigned int k = 0; k < 4; k++)
+          d[k] = D(c[k], static_cast<T>(k == j));
+        quaternion<D> l;
+        quaternion<D>(d).log(l);
+        l.scalar(o[0]);
+        l.vector(o + 1);
+        for (unsigned int k = 0; k < 4; k++)
+          jac[16 * i + 4 * k + j] = o[k].d;
+      }
+    }
+    bench::do_not_optimize(jac);
+  });
+  s.run("log_jacobian_analytic", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> l;
+      log_jacobian(qs[i], l, &jac[16 * i]);
+    }
+    bench::do_not_optimize(jac);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.runs = 11;
+  bench::suite s("quaternion_jacobian.hpp", opts);
+  jacobian_benchs<float>(s, "float");
+  jacobian_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,45 @@
+// lazily renormalized product chains against normalizing every step
+#include "../quaternion_lazy.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void lazy_benchs(bench::suite &s, const char *type) {
+  T axis[3] = {static_cast<T>(1), static_cast<T>(2), static_cast<T>(3)};
+  unit_quaternion<T> u;
+  unit_quaternion<T>::from_axis_angle(axis, static_cast<T>(0.01), u);
+  quaternion<T> step = u.get();
+  lazy_unit_quaternion<T> lazy_step(u);
+
+  s.run("chain_normalized_every_step", type, N, [&]() {
+    quaternion<T> acc(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+                      static_cast<T>(0));
+    for (std::size_t i = 0; i < N; i++) {
+      acc.hamilton_product(step, acc);
+      acc.normalized(acc);
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("chain_unnormalized", type, N, [&]() {
+    quaternion<T> acc(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+                      static_cast<T>(0));
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(step, acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("chain_lazy", type, N, [&]() {
+    lazy_unit_quaternion<T> acc;
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(lazy_step, acc);
+    bench::do_not_optimize(acc);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_lazy.hpp");
+  lazy_benchs<float>(s, "float");
+  lazy_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,67 @@
+// MEKF predict and update, one filter at a time against the structure
+// of arrays batch, reported as filter steps per second
+#include "../quaternion_mekf.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t FILTERS = 4096;
+
+/** steps per second of the last run*/
+static void record_rate(bench::suite &s, const char *name, const char *type) {
+  s.record(name, type, 1e9 / s.results().back().median_ns);
+}
+
+template <class T> void mekf_benchs(bench::suite &s, const char *type) {
+  std::vector<T> g[3], b[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    g[k].resize(FILTERS);
+    b[k].resize(FILTERS);
+  }
+  for (std::size_t i = 0; i < FILTERS; i++) {
+    T t = static_cast<T>(i) * static_cast<T>(0.001);
+    g[0][i] = static_cast<T>(0.1) * t;
+    g[1][i] = static_cast<T>(-0.05);
+    g[2][i] = static_cast<T>(0.2);
+    b[0][i] = static_cast<T>(0.3);
+    b[1][i] = t;
+    b[2][i] = static_cast<T>(9.8);
+  }
+  const T *gp[3] = {g[0].data(), g[1].data(), g[2].data()};
+  const T *bp[3] = {b[0].data(), b[1].data(), b[2].data()};
+  const T up[3] = {0, 0, 1};
+  const T dt = static_cast<T>(0.005);
+  const T sigma = static_cast<T>(0.05);
+
+  std::vector<mekf<T>> single(FILTERS);
+  s.run("predict_update_one_by_one", type, FILTERS, [&]() {
+    for (std::size_t i = 0; i < FILTERS; i++) {
+      T gi[3] = {g[0][i], g[1][i], g[2][i]};
+      T bi[3] = {b[0][i], b[1][i], b[2][i]};
+      single[i].predict(gi, dt);
+      single[i].update(bi, up, sigma);
+    }
+    bench::do_not_optimize(single);
+  });
+  record_rate(s, "one_by_one_steps_per_s", type);
+  mekf_batch<T> batch(FILTERS);
+  s.run("predict_update_batch", type, FILTERS, [&]() {
+    batch.predict(gp, dt);
+    batch.update(bp, up, sigma);
+    bench::do_not_optimize(batch);
+  });
+  record_rate(s, "batch_steps_per_s", type);
+  s.run("predict_update_batch_4_threads", type, FILTERS, [&]() {
+    batch.predict(gp, dt, 4);
+    batch.update(bp, up, sigma, 4);
+    bench::do_not_optimize(batch);
+  });
+  record_rate(s, "batch_4_threads_steps_per_s", type);
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_mekf.hpp");
+  mekf_benchs<float>(s, "float");
+  mekf_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
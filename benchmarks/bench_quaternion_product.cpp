@@ -0,0 +1,60 @@
+// many by many products: nested loops over quaternion operator* and
+// the tiled left matrix kernel
+#include "../quaternion_product.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t M = 512;
+static const std::size_t N = 512;
+
+template <class T> void product_benchs(bench::suite &s, const char *type) {
+  quaternion_batch<T> a, b, out;
+  std::vector<quaternion<T>> aa(M), ab(N), aos(M * N);
+  for (std::size_t i = 0; i < M; i++) {
+    T t = static_cast<T>(i) * static_cast<T>(0.0123);
+    aa[i] = quaternion<T>(std::cos(t), std::sin(t), static_cast<T>(0.3),
+                          std::sin(2 * t));
+    a.push_back(aa[i]);
+  }
+  for (std::size_t j = 0; j < N; j++) {
+    T t = static_cast<T>(j) * static_cast<T>(0.0071);
+    ab[j] = quaternion<T>(std::sin(t), static_cast<T>(0.5), std::cos(t),
+                          std::cos(3 * t));
+    b.push_back(ab[j]);
+  }
+
+  s.run("all_pairs_nested_loops", type, M * N, [&]() {
+    for (std::size_t i = 0; i < M; i++)
+      for (std::size_t j = 0; j < N; j++)
+        aos[i * N + j] = aa[i] * ab[j];
+    bench::do_not_optimize(aos);
+  });
+  s.run("all_pairs_product", type, M * N, [&]() {
+    all_pairs_product(a, b, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("all_pairs_product_4_threads", type, M * N, [&]() {
+    all_pairs_product(a, b, out, 4);
+    bench::do_not_optimize(out);
+  });
+  s.run("all_pairs_relative_nested_loops", type, M * N, [&]() {
+    for (std::size_t i = 0; i < M; i++)
+      for (std::size_t j = 0; j < N; j++)
+        aos[i * N + j] = aa[i].inverse() * ab[j];
+    bench::do_not_optimize(aos);
+  });
+  s.run("all_pairs_relative", type, M * N, [&]() {
+    all_pairs_relative(a, b, out);
+    bench::do_not_optimize(out);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.runs = 11;
+  bench::suite s("quaternion_product.hpp", opts);
+  product_benchs<float>(s, "float");
+  product_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
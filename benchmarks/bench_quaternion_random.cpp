@@ -0,0 +1,43 @@
+// random rotations with the batch generator against a scalar
+// std::mt19937 loop calling sin and cos
+#include "../quaternion_random.hpp"
+#include "bench.hpp"
+#include <random>
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void random_benchs(bench::suite &s, const char *type) {
+  random_rotations<T> gen(12345);
+  quaternion_batch<T> b(N);
+  std::uint64_t first = 0;
+  s.run("philox_shoemake_batch", type, N, [&]() {
+    gen.generate(N, b, first);
+    first += N;
+    bench::do_not_optimize(b.data(0)[N - 1]);
+  });
+  std::mt19937 mt(12345);
+  std::uniform_real_distribution<T> dist(static_cast<T>(0), static_cast<T>(1));
+  std::vector<quaternion<T>> qs(N);
+  s.run("mt19937_shoemake_scalar", type, N, [&]() {
+    const T two_pi = static_cast<T>(6.28318530717958647692);
+    for (std::size_t i = 0; i < N; i++) {
+      T u1 = dist(mt);
+      T u2 = dist(mt) * two_pi;
+      T u3 = dist(mt) * two_pi;
+      T a = std::sqrt(static_cast<T>(1) - u1);
+      T c = std::sqrt(u1);
+      qs[i] = quaternion<T>(c * std::cos(u3), a * std::sin(u2),
+                            a * std::cos(u2), c * std::sin(u3));
+    }
+    bench::do_not_optimize(qs[N - 1]);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_random.hpp");
+  random_benchs<float>(s, "float");
+  random_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,124 @@
+// RK4 rigid body steps: one body at a time, four separate passes over
+// the arrays per step, and the fused batch kernel
+#include "../quaternion_rigid.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t BODIES = 65536;
+
+/** body steps per second of the last run*/
+static void record_rate(bench::suite &s, const char *name, const char *type) {
+  s.record(name, type, 1e9 / s.results().back().median_ns);
+}
+
+/**
+  the stages as whole array passes, each stage writes its slopes to
+  memory and the next one reads them back
+ */
+template <class T> struct staged_bodies {
+  std::vector<T> c[4], w[3], in[3], k[4][7], s[7];
+
+  void step(const T *const tau[3], T dt) {
+    const std::size_t n = c[0].size();
+    const T a[4] = {0, dt / 2, dt / 2, dt};
+    for (unsigned int st = 0; st < 4; st++) {
+      for (std::size_t i = 0; i < n; i++) {
+        T sc[4], sw[3], dc[4], dw[3];
+        for (unsigned int j = 0; j < 4; j++)
+          sc[j] = c[j][i] + (st ? a[st] * k[st - 1][j][i] : T(0));
+        for (unsigned int j = 0; j < 3; j++)
+          sw[j] = w[j][i] + (st ? a[st] * k[st - 1][4 + j][i] : T(0));
+        const T m[3] = {in[0][i], in[1][i], in[2][i]};
+        const T inv[3] = {T(1) / m[0], T(1) / m[1], T(1) / m[2]};
+        const T t[3] = {tau[0][i], tau[1][i], tau[2][i]};
+        rigid_detail::derivative(sc, sw, m, inv, t, dc, dw);
+        for (unsigned int j = 0; j < 4; j++)
+          k[st][j][i] = dc[j];
+        for (unsigned int j = 0; j < 3; j++)
+          k[st][4 + j][i] = dw[j];
+      }
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      T v[7];
+      for (unsigned int j = 0; j < 7; j++)
+        v[j] = (j < 4 ? c[j][i] : w[j - 4][i]) +
+               dt / 6 *
+                   (k[0][j][i] + 2 * (k[1][j][i] + k[2][j][i]) + k[3][j][i]);
+      T inv = T(1) / std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] +
+                               v[3] * v[3]);
+      for (unsigned int j = 0; j < 4; j++)
+        c[j][i] = v[j] * inv;
+      for (unsigned int j = 0; j < 3; j++)
+        w[j][i] = v[4 + j];
+    }
+  }
+};
+
+template <class T> void rigid_benchs(bench::suite &s, const char *type) {
+  std::vector<T> tau[3];
+  std::vector<quaternion<T>> qs(BODIES);
+  std::vector<T> ws(3 * BODIES), is(3 * BODIES);
+  rigid_body_batch<T> batch(BODIES);
+  staged_bodies<T> staged;
+  for (unsigned int k = 0; k < 4; k++)
+    staged.c[k].resize(BODIES);
+  for (unsigned int k = 0; k < 3; k++) {
+    tau[k].resize(BODIES);
+    staged.w[k].resize(BODIES);
+    staged.in[k].resize(BODIES);
+  }
+  for (unsigned int st = 0; st < 4; st++)
+    for (unsigned int j = 0; j < 7; j++)
+      staged.k[st][j].resize(BODIES);
+  for (std::size_t i = 0; i < BODIES; i++) {
+    T f = static_cast<T>(i % 97) * static_cast<T>(0.01);
+    quaternion<T> q = quaternion<T>(1, f, -f, static_cast<T>(0.1)).normalize();
+    T w[3] = {f, static_cast<T>(1), static_cast<T>(-0.5)};
+    T in[3] = {static_cast<T>(1), static_cast<T>(2) + f, static_cast<T>(3)};
+    batch.set_body(i, q, w, in);
+    qs[i] = q;
+    q.scalar(staged.c[0][i]);
+    T v[3];
+    q.vector(v);
+    for (unsigned int k = 0; k < 3; k++) {
+      staged.c[k + 1][i] = v[k];
+      staged.w[k][i] = ws[3 * i + k] = w[k];
+      staged.in[k][i] = is[3 * i + k] = in[k];
+      tau[k][i] = static_cast<T>(0.01) * static_cast<T>(k);
+    }
+  }
+  const T *tp[3] = {tau[0].data(), tau[1].data(), tau[2].data()};
+  const T dt = static_cast<T>(0.001);
+
+  s.run("rk4_one_by_one", type, BODIES, [&]() {
+    for (std::size_t i = 0; i < BODIES; i++) {
+      T t[3] = {tau[0][i], tau[1][i], tau[2][i]};
+      rk4_step(qs[i], &ws[3 * i], &is[3 * i], t, dt);
+    }
+    bench::do_not_optimize(qs);
+  });
+  record_rate(s, "one_by_one_steps_per_s", type);
+  s.run("rk4_staged_passes", type, BODIES, [&]() {
+    staged.step(tp, dt);
+    bench::do_not_optimize(staged);
+  });
+  record_rate(s, "staged_passes_steps_per_s", type);
+  s.run("rk4_fused_batch", type, BODIES, [&]() {
+    batch.step(tp, dt);
+    bench::do_not_optimize(batch);
+  });
+  record_rate(s, "fused_batch_steps_per_s", type);
+  s.run("rk4_fused_batch_4_threads", type, BODIES, [&]() {
+    batch.step(tp, dt, 4);
+    bench::do_not_optimize(batch);
+  });
+  record_rate(s, "fused_batch_4_threads_steps_per_s", type);
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_rigid.hpp");
+  rigid_benchs<float>(s, "float");
+  rigid_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
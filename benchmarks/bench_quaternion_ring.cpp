@@ -0,0 +1,140 @@
+// lock-free rings against a mutex guarded queue, throughput and the
+// latency from push to pop under contention
+#include "../quaternion_ring.hpp"
+#include "bench.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace quat11;
+
+static const std::size_t SAMPLES = 20000;
+static const std::size_t BATCH = 16;
+
+/** the queue producers used before the rings*/
+template <class T> class locked_queue {
+public:
+  typedef orientation_sample<T> value_type;
+  std::size_t push(const value_type *v, std::size_t n) {
+    std::lock_guard<std::mutex> lock(m);
+    q.insert(q.end(), v, v + n);
+    return n;
+  }
+  std::size_t pop(value_type *out, std::size_t n) {
+    std::lock_guard<std::mutex> lock(m);
+    std::size_t k = q.size() < n ? q.size() : n;
+    std::copy(q.begin(), q.begin() + k, out);
+    q.erase(q.begin(), q.begin() + k);
+    return k;
+  }
+
+private:
+  std::mutex m;
+  std::deque<value_type> q;
+};
+
+static std::uint64_t now_ns() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/**
+  producers push SAMPLES stamped records each, one at a time and
+  yielding in between like a sensor thread, one consumer pops in
+  batches and keeps the latency of every record
+ */
+template <class Queue>
+void stream(Queue &queue, unsigned int producers,
+            std::vector<double> &latency) {
+  typedef typename Queue::value_type sample;
+  latency.clear();
+  std::vector<std::thread> threads;
+  for (unsigned int p = 0; p < producers; p++)
+    threads.push_back(std::thread([&queue]() {
+      for (std::size_t i = 0; i < SAMPLES; i++) {
+        sample s;
+        s.q = quaternion<float>(1, 0, 0, 0);
+        s.timestamp = now_ns();
+        while (queue.push(&s, 1) == 0)
+          std::this_thread::yield();
+        std::this_thread::yield();
+      }
+    }));
+  sample out[BATCH];
+  const std::size_t total = producers * SAMPLES;
+  while (latency.size() < total) {
+    std::size_t k = queue.pop(out, BATCH);
+    if (k == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::uint64_t t = now_ns();
+    for (std::size_t j = 0; j < k; j++)
+      latency.push_back(static_cast<double>(t - out[j].timestamp));
+  }
+  for (std::size_t p = 0; p < threads.size(); p++)
+    threads[p].join();
+}
+
+template <class Queue>
+void latency_bench(bench::suite &s, const std::string &name, Queue &queue,
+                   unsigned int producers) {
+  std::vector<double> latency;
+  latency.reserve(producers * SAMPLES);
+  s.run(name, "float", producers * SAMPLES,
+        [&]() { stream(queue, producers, latency); });
+  std::sort(latency.begin(), latency.end());
+  s.record(name + "_latency_p50_ns", "float", bench::percentile(latency, 50.0));
+  s.record(name + "_latency_p99_ns", "float", bench::percentile(latency, 99.0));
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.warmup = 1;
+  opts.runs = 5;
+  bench::suite s("quaternion_ring.hpp", opts);
+  {
+    // uncontended cost of moving a batch through the queue
+    spsc_ring<float> spsc(1024);
+    mpsc_ring<float> mpsc(1024);
+    locked_queue<float> locked;
+    std::vector<orientation_sample<float>> in(BATCH), out(BATCH);
+    const std::size_t rounds = 4096;
+    s.run("spsc_batch_push_pop", "float", rounds * BATCH, [&]() {
+      for (std::size_t r = 0; r < rounds; r++) {
+        spsc.push(in.data(), BATCH);
+        spsc.pop(out.data(), BATCH);
+      }
+      bench::do_not_optimize(out[0]);
+    });
+    s.run("mpsc_batch_push_pop", "float", rounds * BATCH, [&]() {
+      for (std::size_t r = 0; r < rounds; r++) {
+        mpsc.push(in.data(), BATCH);
+        mpsc.pop(out.data(), BATCH);
+      }
+      bench::do_not_optimize(out[0]);
+    });
+    s.run("mutex_batch_push_pop", "float", rounds * BATCH, [&]() {
+      for (std::size_t r = 0; r < rounds; r++) {
+        locked.push(in.data(), BATCH);
+        locked.pop(out.data(), BATCH);
+      }
+      bench::do_not_optimize(out[0]);
+    });
+  }
+  {
+    spsc_ring<float> spsc(1024);
+    locked_queue<float> locked;
+    latency_bench(s, "spsc_1_producer", spsc, 1);
+    latency_bench(s, "mutex_1_producer", locked, 1);
+  }
+  {
+    mpsc_ring<float> mpsc(1024);
+    locked_queue<float> locked;
+    latency_bench(s, "mpsc_4_producers", mpsc, 4);
+    latency_bench(s, "mutex_4_producers", locked, 4);
+  }
+  return s.finish(argc, argv);
+}
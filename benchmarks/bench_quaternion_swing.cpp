@@ -0,0 +1,98 @@
+// swing-twist joint limits: hand written user code clamping angles
+// with atan2, the scalar clamp and the batched pass over a pose
+#include "../quaternion_swing.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 1 << 18;
+
+template <class T> void swing_benchs(bench::suite &s, const char *type) {
+  std::vector<joint_limit<T>> limits(N);
+  joint_limits<T> joints;
+  quaternion_batch<T> pose;
+  pose.reserve(N);
+  for (std::size_t i = 0; i < N; i++) {
+    T t = static_cast<T>(i % 1000) * static_cast<T>(0.0063);
+    joint_limit<T> l = {{std::cos(t), std::sin(t), static_cast<T>(0.3)},
+                        static_cast<T>(-0.6),
+                        static_cast<T>(0.4),
+                        static_cast<T>(0.1) * static_cast<T>(i % 9)};
+    limits[i] = l;
+    joints.push_back(l);
+    T h = static_cast<T>(1.5) * std::sin(3 * t);
+    T v[3] = {std::sin(h) * std::cos(2 * t), std::sin(h) * std::sin(2 * t),
+              std::sin(h) * static_cast<T>(0.2)};
+    pose.push_back(quaternion<T>(std::cos(h), v[0], v[1], v[2]));
+  }
+  std::vector<quaternion<T>> aos(N);
+  for (std::size_t i = 0; i < N; i++)
+    pose.get(i, aos[i]);
+  std::vector<quaternion<T>> res(N);
+
+  s.run("clamp_user_code", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      const joint_limit<T> &l = limits[i];
+      T n = std::sqrt(l.axis[0] * l.axis[0] + l.axis[1] * l.axis[1] +
+                      l.axis[2] * l.axis[2]);
+      T d[3] = {l.axis[0] / n, l.axis[1] / n, l.axis[2] / n};
+      T w = 0, p = 0;
+      aos[i].scalar(w);
+      aos[i].vector_dot(d, p);
+      T twist = 2 * std::atan2(p, w);
+      if (twist > static_cast<T>(3.14159265358979323846))
+        twist -= static_cast<T>(6.28318530717958647692);
+      if (twist < static_cast<T>(-3.14159265358979323846))
+        twist += static_cast<T>(6.28318530717958647692);
+      quaternion<T> tq(w, p * d[0], p * d[1], p * d[2]), tn;
+      if (tq.normalized(tn) != SUCCESS)
+        tn = quaternion<T>(1, 0, 0, 0);
+      quaternion<T> sq = aos[i] * tn.conjugate();
+      T sw = 0, sv[3];
+      sq.scalar(sw);
+      sq.vector(sv);
+      T r = std::sqrt(sv[0] * sv[0] + sv[1] * sv[1] + sv[2] * sv[2]);
+      T swing = 2 * std::atan2(r, std::fabs(sw));
+      twist = std::min(std::max(twist, l.twist_min), l.twist_max);
+      if (swing > l.swing_max && r > 0) {
+        T k = std::sin(l.swing_max / 2) / r * (sw < 0 ? -1 : 1);
+        sq = quaternion<T>(std::cos(l.swing_max / 2) * (sw < 0 ? -1 : 1),
+                           sv[0] * k, sv[1] * k, sv[2] * k);
+      }
+      T c = std::cos(twist / 2), si = std::sin(twist / 2);
+      res[i] = sq * quaternion<T>(c, si * d[0], si * d[1], si * d[2]);
+    }
+    bench::do_not_optimize(res);
+  });
+  s.run("clamp_one_by_one", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++)
+      clamp_swing_twist(aos[i], limits[i], res[i]);
+    bench::do_not_optimize(res);
+  });
+  quaternion_batch<T> out, swing, twist;
+  s.run("clamp_batch", type, N, [&]() {
+    clamp_swing_twist(pose, joints, out);
+    bench::do_not_optimize(out);
+  });
+  s.run("swing_twist_one_by_one", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> a;
+      swing_twist(aos[i], limits[i].axis, a, res[i]);
+      bench::do_not_optimize(a);
+    }
+    bench::do_not_optimize(res);
+  });
+  s.run("swing_twist_batch", type, N, [&]() {
+    swing_twist(pose, joints, swing, twist);
+    bench::do_not_optimize(twist);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::options opts;
+  opts.runs = 11;
+  bench::suite s("quaternion_swing.hpp", opts);
+  swing_benchs<float>(s, "float");
+  swing_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
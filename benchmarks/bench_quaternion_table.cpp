@@ -0,0 +1,48 @@
+// rotation lookup tables against building rotations with sin and cos
+#include "../quaternion_table.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void table_benchs(bench::suite &s, const char *type) {
+  T axis[3] = {static_cast<T>(1), static_cast<T>(2), static_cast<T>(3)};
+  rotation_table<T> t;
+  rotation_table<T>::from_grid(axis, static_cast<T>(-3.14159),
+                               static_cast<T>(3.14159), 256, t);
+  std::vector<T> angles(N);
+  for (std::size_t i = 0; i < N; i++)
+    angles[i] = static_cast<T>(-3) + static_cast<T>(6) *
+                                         static_cast<T>((i * 2654435761u) % N) /
+                                         static_cast<T>(N);
+
+  s.run("from_axis_angle", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      unit_quaternion<T> u;
+      unit_quaternion<T>::from_axis_angle(axis, angles[i], u);
+      bench::do_not_optimize(u);
+    }
+  });
+  s.run("table_nearest", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> q;
+      t.nearest(angles[i], q);
+      bench::do_not_optimize(q);
+    }
+  });
+  s.run("table_slerp", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> q;
+      t.slerp(angles[i], q);
+      bench::do_not_optimize(q);
+    }
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_table.hpp");
+  table_benchs<float>(s, "float");
+  table_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
@@ -0,0 +1,69 @@
+// unit_quaternion fast paths against the general quaternion
+#include "../quaternion_unit.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 1024;
+
+template <class T> void unit_benchs(bench::suite &s, const char *type) {
+  std::vector<unit_quaternion<T>> us;
+  for (std::size_t i = 0; i < N; i++) {
+    T axis[3] = {static_cast<T>(1 + i % 3), static_cast<T>(1 + i % 5),
+                 static_cast<T>(1 + i % 7)};
+    unit_quaternion<T> u;
+    unit_quaternion<T>::from_axis_angle(axis, static_cast<T>(0.01 * i), u);
+    us.push_back(u);
+  }
+  T v[3] = {static_cast<T>(1), static_cast<T>(2), static_cast<T>(3)};
+
+  s.run("inversed_general", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> out;
+      us[i].get().inversed(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("inversed_unit", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      unit_quaternion<T> out;
+      us[i].inversed(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("normalized_general", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> out;
+      us[i].get().normalized(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("normalized_unit", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      unit_quaternion<T> out;
+      us[i].normalized(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("rotate_general", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T out[3];
+      us[i].get().rotate(v, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("rotate_unit", type, N, [&]() {
+    for (std::size_t i = 0; i < N; i++) {
+      T out[3];
+      us[i].rotate(v, out);
+      bench::do_not_optimize(out);
+    }
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion_unit.hpp");
+  unit_benchs<float>(s, "float");
+  unit_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
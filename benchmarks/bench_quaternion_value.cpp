@@ -0,0 +1,87 @@
+// flags api against value returning api in quaternion.hpp
+#include "../quaternion.hpp"
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t N = 4096;
+
+template <class T> void value_benchs(bench::suite &s, const std::string &type) {
+  T e = static_cast<T>(0.001);
+  quaternion<T> step(static_cast<T>(0.99995), e, e, e);
+  quaternion<T> q0(static_cast<T>(0.5), static_cast<T>(0.5),
+                   static_cast<T>(0.5), static_cast<T>(0.5));
+  quaternion<T> p(static_cast<T>(0), static_cast<T>(1), static_cast<T>(2),
+                  static_cast<T>(3));
+
+  s.run("product_chain_flags", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++)
+      acc.hamilton_product(step, acc);
+    bench::do_not_optimize(acc);
+  });
+  s.run("product_chain_value", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++)
+      acc = acc * step;
+    bench::do_not_optimize(acc);
+  });
+  s.run("sandwich_flags", type, N, [&]() {
+    quaternion<T> acc = p;
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> conj;
+      quaternion<T> tmp;
+      step.conjugate(conj);
+      step.hamilton_product(acc, tmp);
+      tmp.hamilton_product(conj, acc);
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("sandwich_value", type, N, [&]() {
+    quaternion<T> acc = p;
+    for (std::size_t i = 0; i < N; i++)
+      acc = step * acc * step.conjugate();
+    bench::do_not_optimize(acc);
+  });
+  s.run("expression_flags", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> tmp;
+      quaternion<T> neg;
+      acc.hamilton_product(step, tmp);
+      tmp.add(q0, tmp);
+      tmp.subtract(p, tmp);
+      tmp.product(static_cast<T>(-1), neg);
+      neg.normalized(acc);
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("expression_value", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++)
+      acc = (-(acc * step + q0 - p)).normalize();
+    bench::do_not_optimize(acc);
+  });
+  s.run("inverse_chain_flags", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++) {
+      quaternion<T> inv;
+      acc.inversed(inv);
+      inv.hamilton_product(step, acc);
+    }
+    bench::do_not_optimize(acc);
+  });
+  s.run("inverse_chain_value", type, N, [&]() {
+    quaternion<T> acc = q0;
+    for (std::size_t i = 0; i < N; i++)
+      acc = acc.inverse() * step;
+    bench::do_not_optimize(acc);
+  });
+}
+
+int main(int argc, const char *argv[]) {
+  bench::suite s("quaternion.hpp value api");
+  value_benchs<float>(s, "float");
+  value_benchs<double>(s, "double");
+  return s.finish(argc, argv);
+}
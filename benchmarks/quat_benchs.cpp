@@ -0,0 +1,333 @@
+// benchmarks for every public member of quaternion<T>, shared by
+// the header only and the explicit instantiation builds
+#include "bench.hpp"
+
+using namespace quat11;
+
+static const std::size_t BENCH_N = 1024;
+
+template <class T> struct bench_data {
+  std::vector<quaternion<T>> qs;
+  std::vector<quaternion<T>> ps;
+  std::vector<T> ts;
+  bench_data() {
+    for (std::size_t i = 0; i < BENCH_N; i++) {
+      T a = static_cast<T>(1 + (i % 7));
+      T b = static_cast<T>(1 + (i % 5)) * static_cast<T>(0.5);
+      T c = static_cast<T>(1 + (i % 3)) * static_cast<T>(0.25);
+      T d = static_cast<T>(1 + (i % 11)) * static_cast<T>(0.125);
+      qs.push_back(quaternion<T>(a, b, c, d));
+      ps.push_back(quaternion<T>(d, -c, b, -a));
+      ts.push_back(b + c);
+    }
+  }
+};
+
+template <class T> void quat_benchs(bench::suite &s, const char *type) {
+  bench_data<T> data;
+  const std::vector<quaternion<T>> &qs = data.qs;
+  const std::vector<quaternion<T>> &ps = data.ps;
+  const std::vector<T> &ts = data.ts;
+  const std::size_t n = BENCH_N;
+
+  s.run("constructor", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> q(ts[i], ts[i], ts[i], ts[i]);
+      bench::do_not_optimize(q);
+    }
+  });
+  s.run("scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out;
+      qs[i].scalar(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].vector(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("get_component", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quat_c<T> c;
+      qs[i].get_component(i % 4, c);
+      bench::do_not_optimize(c);
+    }
+  });
+  s.run("apply_scalar_vec3", type, n, [&]() {
+    auto fn = [](T a, T b) { return a * b; };
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].apply(ts[i], fn, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("apply_vec3_vec3", type, n, [&]() {
+    auto fn = [](T a, T b) { return a * b; };
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out[3];
+      qs[i].apply(t, fn, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("apply_quaternion", type, n, [&]() {
+    auto fn = [](T a, T b) { return a * b; };
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].apply(ps[i], fn, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("apply_scalar_quaternion", type, n, [&]() {
+    auto fn = [](T a, T b) { return a * b; };
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].apply(ts[i], fn, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_multiplication_scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].vector_multiplication(ts[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_addition_scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].vector_addition(ts[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_subtraction_scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].vector_subtraction(ts[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_division_scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[3];
+      qs[i].vector_division(ts[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_multiplication_vec3", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out[3];
+      qs[i].vector_multiplication(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_addition_vec3", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out[3];
+      qs[i].vector_addition(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_subtraction_vec3", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out[3];
+      qs[i].vector_subtraction(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_division_vec3", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out[3];
+      qs[i].vector_division(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_dot", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T out;
+      qs[i].vector_dot(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_dot_vec3_vec3", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], ts[i], ts[i]};
+      T v[3] = {ts[i], -ts[i], ts[i]};
+      T out;
+      qs[i].vector_dot(v, t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("vector_cross", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T t[3] = {ts[i], -ts[i], ts[i]};
+      T out[3];
+      qs[i].vector_cross(t, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("hamilton_product", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].hamilton_product(ps[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("conjugate", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].conjugate(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("normalized", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].normalized(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("inversed", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].inversed(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("rotate", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T v[3] = {ts[i], -ts[i], ts[i]};
+      T out[3];
+      qs[i].rotate(v, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("left_matrix", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[16];
+      qs[i].left_matrix(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("right_matrix", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out[16];
+      qs[i].right_matrix(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("add", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].add(ps[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("subtract", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].subtract(ps[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("product", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].product(ps[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("product_scalar", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].product(ts[i], out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("power_4", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].power(4, out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("log", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].log(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("squared", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      quaternion<T> out;
+      qs[i].squared(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("norm", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out;
+      qs[i].norm(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("magnitude", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out;
+      qs[i].magnitude(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("determinant", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out;
+      qs[i].determinant(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("det", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++) {
+      T out;
+      qs[i].det(out);
+      bench::do_not_optimize(out);
+    }
+  });
+  s.run("operator*", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i] * ps[i]);
+  });
+  s.run("operator+", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i] + ps[i]);
+  });
+  s.run("operator-", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i] - ps[i]);
+  });
+  s.run("unary_operator-", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(-qs[i]);
+  });
+  s.run("conjugate_value", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i].conjugate());
+  });
+  s.run("normalize", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i].normalize());
+  });
+  s.run("inverse", type, n, [&]() {
+    for (std::size_t i = 0; i < n; i++)
+      bench::do_not_optimize(qs[i].inverse());
+  });
+}
@@ -33,158 +33,86 @@ template <class T> QUATERNION_FLAGS quaternion<T>::vector(T v[3]) const {
   v[2] = coeffs[3];
   return SUCCESS;
 }
-template <class T>
-QUATERNION_FLAGS quaternion<T>::apply(T t, const std::function<T(T, T)> &fn,
-                                      T out[3]) const {
-  T vec[3];
-  auto res = vector(vec);
-
-  if (res != SUCCESS)
-    return res;
-
-  out[0] = fn(vec[0], t);
-  out[1] = fn(vec[1], t);
-  out[2] = fn(vec[2], t);
-  return SUCCESS;
-}
-template <class T>
-QUATERNION_FLAGS quaternion<T>::apply(T t[3], const std::function<T(T, T)> &fn,
-                                      T out[3]) const {
-  T vec[3];
-  auto res = vector(vec);
-  if (res != SUCCESS)
-    return res;
-  out[0] = fn(vec[0], t[0]);
-  out[1] = fn(vec[1], t[1]);
-  out[2] = fn(vec[2], t[2]);
-  return SUCCESS;
-}
-template <class T>
-QUATERNION_FLAGS quaternion<T>::apply(const quaternion &q,
-                                      const std::function<T(T, T)> &fn,
-                                      quaternion<T> &out) const {
-  //
-  T s = static_cast<T>(0);
-  T qs = static_cast<T>(0);
-  auto res = scalar(s);
-  if (res != SUCCESS)
-    return res;
-  res = q.scalar(qs);
-  if (res != SUCCESS)
-    return res;
-  //
-  T sresult = fn(s, qs);
-
-  T ovec[3];
-  T qvec[3];
-
-  res = q.vector(qvec);
-  if (res != SUCCESS)
-    return res;
-
-  //
-  apply(qvec, fn, ovec);
-
-  // o
-  out = quaternion(sresult, ovec);
-  return SUCCESS;
-}
-template <class T>
-QUATERNION_FLAGS quaternion<T>::apply(const T &q,
-                                      const std::function<T(T, T)> &fn,
-                                      quaternion<T> &out) const {
-  T s = static_cast<T>(0);
-  auto res = scalar(s);
-  if (res != SUCCESS)
-    return res;
-
-  // scalar result
-  T sres = fn(s, q);
-
-  T vec[3];
-  res = vector(vec);
-  if (res != SUCCESS)
-    return res;
-
-  //
-  T ovec[3];
-  ovec[0] = fn(vec[0], q);
-  ovec[1] = fn(vec[1], q);
-  ovec[2] = fn(vec[2], q);
-  //
-  out = quaternion(sres, ovec);
-  return SUCCESS;
-}
-
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_multiplication(T t, T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_MULTIPLICATION);
   auto fn = [](T thisval, T tval) { return thisval * tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_addition(T t, T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_ADDITION);
   auto fn = [](T thisval, T tval) { return thisval + tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_subtraction(T t, T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_SUBTRACTION);
   auto fn = [](T thisval, T tval) { return thisval - tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_division(T t, T out[3]) const {
-  if (t == 0)
-    return ARG_ERROR;
+  QUATERNION_COUNT(OP_VECTOR_DIVISION);
+  if (t == static_cast<T>(0))
+    return QUATERNION_COUNT_RESULT(ARG_ERROR);
   auto fn = [](T thisval, T tval) { return thisval / tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 /** arithmetic operations with a vector on vector part*/
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_multiplication(T t[3], T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_MULTIPLICATION);
   auto fn = [](T thisval, T tval) { return thisval * tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_addition(T t[3], T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_ADDITION);
 
   auto fn = [](T thisval, T tval) { return thisval + tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_subtraction(T t[3], T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_SUBTRACTION);
 
   auto fn = [](T thisval, T tval) { return thisval - tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_division(T t[3], T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_DIVISION);
   for (unsigned int i = 0; i < 3; i++) {
-    if (t[i] == 0)
-      return ARG_ERROR;
+    if (t[i] == static_cast<T>(0))
+      return QUATERNION_COUNT_RESULT(ARG_ERROR);
   }
   auto fn = [](T thisval, T tval) { return thisval / tval; };
-  return apply(t, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(t, fn, out));
 }
 /** dot product and cross product for two vec3*/
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_dot(T t[3], T &out) const {
+  QUATERNION_COUNT(OP_VECTOR_DOT);
   T v[3];
   auto res = vector(v);
   if (res != SUCCESS)
-    return res;
-  return vector_dot(v, t, out);
+    return QUATERNION_COUNT_RESULT(res);
+  return QUATERNION_COUNT_RESULT(vector_dot(v, t, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_dot(T v[3], T t[3], T &out) const {
+  QUATERNION_COUNT(OP_VECTOR_DOT);
   out = t[0] * v[0] + t[1] * v[1] + t[2] * v[2];
   return SUCCESS;
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::vector_cross(T t[3], T out[3]) const {
+  QUATERNION_COUNT(OP_VECTOR_CROSS);
   T vec[3];
   auto res = vector(vec);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   //
   out[0] = vec[1] * t[2] - vec[2] * t[1];
   out[1] = vec[2] * t[0] - vec[0] * t[2];
@@ -202,68 +130,42 @@ QUATERNION_FLAGS quaternion<T>::vector_cross(T t[3], T out[3]) const {
 template <class T>
 QUATERNION_FLAGS quaternion<T>::hamilton_product(const quaternion &q_b,
                                                  quaternion<T> &out) const {
-  // s_a, s_b, a, b
-  T s_a = static_cast<T>(0);
-  auto res = scalar(s_a);
-  if (res != SUCCESS)
-    return res;
-
-  T s_b = static_cast<T>(0);
-  res = q_b.scalar(s_b);
-  if (res != SUCCESS)
-    return res;
-
-  T a[3];
-  res = vector(a);
-  if (res != SUCCESS)
-    return res;
-
-  T b[3];
-  res = q_b.vector(b);
-  if (res != SUCCESS)
-    return res;
-
-  // s_a * s_b
-  T s_ab = s_a * s_b;
-
-  // a \cdot b
-  T a_dot_b = static_cast<T>(0);
-  res = vector_dot(a, b, a_dot_b);
-  if (res != SUCCESS)
-    return res;
-
-  // a \times b
-  T cross_ab[3];
-  res = vector_cross(b, cross_ab);
-  if (res != SUCCESS)
-    return res;
-
-  // s_a * b + s_b * a + a \times b
-  T tout[3];
-  for (unsigned int i = 0; i < 3; i++) {
-    tout[i] = s_a * b[i] + s_b * a[i] + cross_ab[i];
-  }
-  out = quaternion(s_ab - a_dot_b, tout);
+  QUATERNION_COUNT(OP_HAMILTON_PRODUCT);
+  hamilton_kernel(coeffs, q_b.coeffs, out.coeffs);
   return SUCCESS;
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::conjugate(quaternion<T> &out) const {
-  T s = static_cast<T>(0);
-  auto res = scalar(s);
-  if (res != SUCCESS)
-    return res;
-
-  T vec[3];
-  res = vector(vec);
-
-  if (res != SUCCESS)
-    return res;
-
-  res = vector_multiplication(static_cast<T>(-1), vec);
-  if (res != SUCCESS)
-    return res;
-
-  out = quaternion(s, vec);
+  QUATERNION_COUNT(OP_CONJUGATE);
+  conjugate_kernel(coeffs, out.coeffs);
+  return SUCCESS;
+}
+/**
+  \brief left product matrix, \f[q p = L(q) p\f] with p as the
+  column [s, x, y, z]. Row major.
+ */
+template <class T>
+QUATERNION_FLAGS quaternion<T>::left_matrix(T out[16]) const {
+  QUATERNION_COUNT(OP_LEFT_MATRIX);
+  const T *a = coeffs;
+  const T l[16] = {a[0], -a[1], -a[2], -a[3], a[1], a[0], -a[3], a[2],
+                   a[2], a[3],  a[0],  -a[1], a[3], -a[2], a[1], a[0]};
+  for (unsigned int k = 0; k < 16; k++)
+    out[k] = l[k];
+  return SUCCESS;
+}
+/**
+  \brief right product matrix, \f[p q = R(q) p\f] with p as the
+  column [s, x, y, z]. Row major.
+ */
+template <class T>
+QUATERNION_FLAGS quaternion<T>::right_matrix(T out[16]) const {
+  QUATERNION_COUNT(OP_RIGHT_MATRIX);
+  const T *a = coeffs;
+  const T r[16] = {a[0], -a[1], -a[2], -a[3], a[1], a[0], a[3],  -a[2],
+                   a[2], -a[3], a[0],  a[1],  a[3], a[2], -a[1], a[0]};
+  for (unsigned int k = 0; k < 16; k++)
+    out[k] = r[k];
   return SUCCESS;
 }
 /**
@@ -272,26 +174,27 @@ QUATERNION_FLAGS quaternion<T>::conjugate(quaternion<T> &out) const {
  */
 template <class T>
 QUATERNION_FLAGS quaternion<T>::normalized(quaternion<T> &out) const {
-  T nval = static_cast<T>(0);
+  QUATERNION_COUNT(OP_NORMALIZED);
+  T nval;
   auto res = norm(nval);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   T inv_mag = static_cast<T>(1.0) / nval;
 
   res = scalar(nval);
 
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
 
   T scalar_part = nval * inv_mag;
   T vs[3];
   res = vector(vs);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   res = vector_multiplication(inv_mag, vs);
 
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   out = quaternion(scalar_part, vs);
   return SUCCESS;
 }
@@ -301,33 +204,33 @@ QUATERNION_FLAGS quaternion<T>::normalized(quaternion<T> &out) const {
  */
 template <class T>
 QUATERNION_FLAGS quaternion<T>::inversed(quaternion<T> &out) const {
-  //
-  T det_out = static_cast<T>(0);
-  auto res = det(det_out);
-  if (res != SUCCESS)
-    return res;
-
-  T inv_mag2 = static_cast<T>(1.0) / det_out;
-  quaternion conj;
-
-  res = conjugate(conj);
+  QUATERNION_COUNT(OP_INVERSED);
+  inverse_kernel(coeffs, out.coeffs);
+  return SUCCESS;
+}
+/**
+  \brief rotate a vector with \f[q [0, v] q^{-1}\f] from Vince
+  2011 - Quaternions for Computer Graphics p. 104
+ */
+template <class T>
+QUATERNION_FLAGS quaternion<T>::rotate(const T v[3], T out[3]) const {
+  QUATERNION_COUNT(OP_ROTATE);
+  quaternion p(static_cast<T>(0), v[0], v[1], v[2]);
+  quaternion inv;
+  auto res = inversed(inv);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
 
-  T conj_scalar = static_cast<T>(0);
-  res = conj.scalar(conj_scalar);
+  quaternion qp;
+  res = hamilton_product(p, qp);
   if (res != SUCCESS)
-    return res;
-
-  T spart = conj_scalar * inv_mag2;
+    return QUATERNION_COUNT_RESULT(res);
 
-  T vs[3];
-  res = vector_multiplication(inv_mag2, vs);
+  quaternion qpq;
+  res = qp.hamilton_product(inv, qpq);
   if (res != SUCCESS)
-    return res;
-
-  out = quaternion(spart, vs);
-  return SUCCESS;
+    return QUATERNION_COUNT_RESULT(res);
+  return QUATERNION_COUNT_RESULT(qpq.vector(out));
 }
 /**
  \brief from Vince 2011 - Quaternions for Computer
@@ -336,8 +239,9 @@ QUATERNION_FLAGS quaternion<T>::inversed(quaternion<T> &out) const {
 template <class T>
 QUATERNION_FLAGS quaternion<T>::add(const quaternion &q,
                                     quaternion<T> &out) const {
-  auto fn = [](T thisval, T tval) { return thisval + tval; };
-  return apply(q, fn, out);
+  QUATERNION_COUNT(OP_ADD);
+  add_kernel(coeffs, q.coeffs, out.coeffs);
+  return SUCCESS;
 }
 /**
  \brief from Vince 2011 - Quaternions for Computer
@@ -346,8 +250,9 @@ QUATERNION_FLAGS quaternion<T>::add(const quaternion &q,
 template <class T>
 QUATERNION_FLAGS quaternion<T>::subtract(const quaternion &q,
                                          quaternion<T> &out) const {
-  auto fn = [](T thisval, T tval) { return thisval - tval; };
-  return apply(q, fn, out);
+  QUATERNION_COUNT(OP_SUBTRACT);
+  subtract_kernel(coeffs, q.coeffs, out.coeffs);
+  return SUCCESS;
 }
 /**
   \brief from Vince 2011 - Quaternions for Computer
@@ -356,7 +261,8 @@ QUATERNION_FLAGS quaternion<T>::subtract(const quaternion &q,
 template <class T>
 QUATERNION_FLAGS quaternion<T>::product(const quaternion &q,
                                         quaternion<T> &out) const {
-  return hamilton_product(q, out);
+  QUATERNION_COUNT(OP_PRODUCT);
+  return QUATERNION_COUNT_RESULT(hamilton_product(q, out));
 }
 /**
   \brief from Vince 2011 - Quaternions for Computer
@@ -364,12 +270,14 @@ QUATERNION_FLAGS quaternion<T>::product(const quaternion &q,
  */
 template <class T>
 QUATERNION_FLAGS quaternion<T>::product(T r, quaternion<T> &out) const {
+  QUATERNION_COUNT(OP_PRODUCT);
   auto fn = [](T thisval, T tval) { return thisval * tval; };
-  return apply(r, fn, out);
+  return QUATERNION_COUNT_RESULT(apply(r, fn, out));
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::power(unsigned int i,
                                       quaternion<T> &out) const {
+  QUATERNION_COUNT(OP_POWER);
   quaternion accumulant = *this;
   quaternion result2 = *this;
   for (unsigned int j = 1; j < i; j++) {
@@ -380,15 +288,16 @@ QUATERNION_FLAGS quaternion<T>::power(unsigned int i,
 }
 template <class T>
 QUATERNION_FLAGS quaternion<T>::squared(quaternion<T> &out) const {
+  QUATERNION_COUNT(OP_SQUARED);
   quaternion r1 = *this;
   quaternion r2 = *this;
   auto res = product(r1, out);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
 
   res = product(r2, out);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   return SUCCESS;
 }
 /**
@@ -396,28 +305,60 @@ QUATERNION_FLAGS quaternion<T>::squared(quaternion<T> &out) const {
   Graphics p. 69
  */
 template <class T> QUATERNION_FLAGS quaternion<T>::norm(T &out) const {
+  QUATERNION_COUNT(OP_NORM);
   auto res = det(out);
 
   if (res != SUCCESS)
-    return res;
-  //
+    return QUATERNION_COUNT_RESULT(res);
+  // found by argument dependent lookup for user scalar types
+  using std::sqrt;
   out = sqrt(out);
   return SUCCESS;
 }
+/**
+  \brief natural logarithm \f[[\ln |q|, \hat{v} atan2(|v|, s)]\f] of
+  q = [s, v]. ARG_ERROR for zero and for negative reals, whose
+  logarithm has no unique axis.
+ */
+template <class T>
+QUATERNION_FLAGS quaternion<T>::log(quaternion<T> &out) const {
+  QUATERNION_COUNT(OP_LOG);
+  using std::atan2;
+  using std::log;
+  using std::sqrt;
+  const T zero = static_cast<T>(0);
+  T r2 = coeffs[1] * coeffs[1] + coeffs[2] * coeffs[2] + coeffs[3] * coeffs[3];
+  T n2 = coeffs[0] * coeffs[0] + r2;
+  if (n2 == zero || (r2 == zero && coeffs[0] < zero))
+    return QUATERNION_COUNT_RESULT(ARG_ERROR);
+  // atan2(|v|, s) / |v| tends to 1 / s, no sqrt of zero for the
+  // derivatives of automatic differentiation
+  T k;
+  if (r2 == zero)
+    k = static_cast<T>(1) / coeffs[0];
+  else {
+    T r = sqrt(r2);
+    k = atan2(r, coeffs[0]) / r;
+  }
+  out = quaternion(static_cast<T>(0.5) * log(n2), coeffs[1] * k,
+                   coeffs[2] * k, coeffs[3] * k);
+  return SUCCESS;
+}
 
 /**
   \brief from Vince 2011 - Quaternions for Computer
   Graphics p. 25
  */
 template <class T> QUATERNION_FLAGS quaternion<T>::determinant(T &out) const {
-  T s = static_cast<T>(0);
+  QUATERNION_COUNT(OP_DETERMINANT);
+  T s;
   auto res = scalar(s);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
   T vec[3];
   res = vector(vec);
   if (res != SUCCESS)
-    return res;
+    return QUATERNION_COUNT_RESULT(res);
 
   T a2 = s * s;
   T b2 = vec[0] * vec[0];
@@ -436,6 +377,7 @@ template <class T> QUATERNION_FLAGS quaternion<T>::magnitude(T &out) const {
 template <class T>
 QUATERNION_FLAGS quaternion<T>::get_component(std::size_t i,
                                               quat_c<T> &c) const {
+  QUATERNION_COUNT(OP_GET_COMPONENT);
   if (i == 0) {
     quat_c<T> c_;
     c_.r = coeffs[0];
@@ -451,9 +393,116 @@ QUATERNION_FLAGS quaternion<T>::get_component(std::size_t i,
     c = quat_c<T>(K, coeffs[3]);
     return SUCCESS;
   } else {
-    return ARG_ERROR;
+    return QUATERNION_COUNT_RESULT(ARG_ERROR);
   }
 }
+/**
+  Value returning api. These share the kernels of the flags api
+  above and report no errors, so they can be chained and kept in
+  registers. Check for the zero quaternion first where it can occur:
+  normalize() and inverse() of zero give NaNs for float and double,
+  for q1_30 normalize() returns *this and inverse() returns zero.
+ */
+template <class T>
+quaternion<T> quaternion<T>::operator*(const quaternion &q) const noexcept {
+  QUATERNION_COUNT(OP_HAMILTON_PRODUCT);
+  quaternion out;
+  hamilton_kernel(coeffs, q.coeffs, out.coeffs);
+  return out;
+}
+template <class T>
+quaternion<T> quaternion<T>::operator+(const quaternion &q) const noexcept {
+  QUATERNION_COUNT(OP_ADD);
+  quaternion out;
+  add_kernel(coeffs, q.coeffs, out.coeffs);
+  return out;
+}
+template <class T>
+quaternion<T> quaternion<T>::operator-(const quaternion &q) const noexcept {
+  QUATERNION_COUNT(OP_SUBTRACT);
+  quaternion out;
+  subtract_kernel(coeffs, q.coeffs, out.coeffs);
+  return out;
+}
+template <class T> quaternion<T> quaternion<T>::operator-() const noexcept {
+  QUATERNION_COUNT(OP_NEGATE);
+  quaternion out;
+  negate_kernel(coeffs, out.coeffs);
+  return out;
+}
+template <class T> quaternion<T> quaternion<T>::conjugate() const noexcept {
+  QUATERNION_COUNT(OP_CONJUGATE);
+  quaternion out;
+  conjugate_kernel(coeffs, out.coeffs);
+  return out;
+}
+template <class T> quaternion<T> quaternion<T>::normalize() const noexcept {
+  quaternion out = *this;
+  normalized(out);
+  return out;
+}
+template <class T> quaternion<T> quaternion<T>::inverse() const noexcept {
+  QUATERNION_COUNT(OP_INVERSED);
+  quaternion out;
+  inverse_kernel(coeffs, out.coeffs);
+  return out;
+}
+
+/**
+  Kernels shared by the flags and the value api. out may alias
+  the inputs.
+ */
+template <class T>
+void quaternion<T>::hamilton_kernel(const T a[4], const T b[4],
+                                    T out[4]) noexcept {
+  // s_a s_b - a \cdot b
+  T s = a[0] * b[0] - (b[1] * a[1] + b[2] * a[2] + b[3] * a[3]);
+  // s_a b + s_b a + a \times b
+  T x = a[0] * b[1] + b[0] * a[1] + (a[2] * b[3] - a[3] * b[2]);
+  T y = a[0] * b[2] + b[0] * a[2] + (a[3] * b[1] - a[1] * b[3]);
+  T z = a[0] * b[3] + b[0] * a[3] + (a[1] * b[2] - a[2] * b[1]);
+  out[0] = s;
+  out[1] = x;
+  out[2] = y;
+  out[3] = z;
+}
+template <class T>
+void quaternion<T>::add_kernel(const T a[4], const T b[4], T out[4]) noexcept {
+  for (unsigned int i = 0; i < 4; i++)
+    out[i] = a[i] + b[i];
+}
+template <class T>
+void quaternion<T>::subtract_kernel(const T a[4], const T b[4],
+                                    T out[4]) noexcept {
+  for (unsigned int i = 0; i < 4; i++)
+    out[i] = a[i] - b[i];
+}
+template <class T>
+void quaternion<T>::negate_kernel(const T a[4], T out[4]) noexcept {
+  for (unsigned int i = 0; i < 4; i++)
+    out[i] = -a[i];
+}
+template <class T>
+void quaternion<T>::conjugate_kernel(const T a[4], T out[4]) noexcept {
+  out[0] = a[0];
+  out[1] = -a[1];
+  out[2] = -a[2];
+  out[3] = -a[3];
+}
+/** conjugate over the squared norm, in one pass*/
+template <class T>
+void quaternion<T>::inverse_kernel(const T a[4], T out[4]) noexcept {
+  T inv_mag2 = static_cast<T>(1) /
+               (a[0] * a[0] + a[1] * a[1] + a[2] * a[2] + a[3] * a[3]);
+  T s = a[0] * inv_mag2;
+  T x = -a[1] * inv_mag2;
+  T y = -a[2] * inv_mag2;
+  T z = -a[3] * inv_mag2;
+  out[0] = s;
+  out[1] = x;
+  out[2] = y;
+  out[3] = z;
+}
 template <typename T>
 std::ostream &operator<<(std::ostream &out, const quaternion<T> &q) {
   out << q.r() << " + " << q.x() << "i"
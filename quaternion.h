@@ -38,9 +38,8 @@ SOFTWARE.
 #ifndef QUATERNION_H
 #define QUATERNION_H
 
+#include <cmath>
 #include <cstdint>
-#include <functional>
-#include <math.h>
 #include <ostream>
 #include <stdio.h>
 
@@ -61,6 +60,17 @@ enum QUATERNION_BASE {
   J,           // j base for the third quaternion component
   K            // k base for the fourth quaternion component
 };
+} // namespace quat11
+
+// the counters compare against QUATERNION_FLAGS
+#ifdef QUATERNION_ENABLE_COUNTERS
+#include "quaternion_counters.hpp"
+#else
+#define QUATERNION_COUNT(op)
+#define QUATERNION_COUNT_RESULT(res) (res)
+#endif
+
+namespace quat11 {
 
 /**
   \brief Quaternion component
@@ -96,16 +106,18 @@ public:
 
   QUATERNION_FLAGS scalar(T &out) const;
   QUATERNION_FLAGS vector(T v[3]) const;
-  /** arithmetic operations with a scalar on vector part*/
-  QUATERNION_FLAGS
-  apply(T t, const std::function<T(T, T)> &fn, T out[3]) const;
-  QUATERNION_FLAGS
-  apply(T t[3], const std::function<T(T, T)> &fn, T out[3]) const;
-  QUATERNION_FLAGS
-  apply(const quaternion &q, const std::function<T(T, T)> &fn,
-        quaternion<T> &out) const;
-  QUATERNION_FLAGS
-  apply(const T &q, const std::function<T(T, T)> &fn, quaternion<T> &out) const;
+  /**
+    arithmetic operations with a scalar on vector part. fn is any
+    callable T(T, T), taken as a template so it inlines and T may be
+    an automatic differentiation scalar. Defined below the class as
+    member templates are not part of the prebuilt instances.
+   */
+  template <class Fn> QUATERNION_FLAGS apply(T t, Fn fn, T out[3]) const;
+  template <class Fn> QUATERNION_FLAGS apply(T t[3], Fn fn, T out[3]) const;
+  template <class Fn>
+  QUATERNION_FLAGS apply(const quaternion &q, Fn fn, quaternion<T> &out) const;
+  template <class Fn>
+  QUATERNION_FLAGS apply(const T &q, Fn fn, quaternion<T> &out) const;
 
   QUATERNION_FLAGS vector_multiplication(T t, T out[3]) const;
   QUATERNION_FLAGS vector_addition(T t, T out[3]) const;
@@ -131,6 +143,16 @@ public:
   QUATERNION_FLAGS
   hamilton_product(const quaternion &q_b, quaternion<T> &out) const;
   QUATERNION_FLAGS conjugate(quaternion<T> &out) const;
+  /**
+    \brief left product matrix, \f[q p = L(q) p\f] with p as the
+    column [s, x, y, z]. Row major.
+   */
+  QUATERNION_FLAGS left_matrix(T out[16]) const;
+  /**
+    \brief right product matrix, \f[p q = R(q) p\f] with p as the
+    column [s, x, y, z]. Row major.
+   */
+  QUATERNION_FLAGS right_matrix(T out[16]) const;
   /**
     \brief from Vince 2011 - Quaternions for Computer
     Graphics p. 69
@@ -141,6 +163,11 @@ public:
     Graphics p. 69
    */
   QUATERNION_FLAGS inversed(quaternion<T> &out) const;
+  /**
+    \brief rotate a vector with \f[q [0, v] q^{-1}\f] from Vince
+    2011 - Quaternions for Computer Graphics p. 104
+   */
+  QUATERNION_FLAGS rotate(const T v[3], T out[3]) const;
   /**
    \brief from Vince 2011 - Quaternions for Computer
    Graphics p. 69
@@ -168,6 +195,11 @@ public:
     Graphics p. 69
    */
   QUATERNION_FLAGS norm(T &out) const;
+  /**
+    \brief natural logarithm \f[[\ln |q|, \hat{v} atan2(|v|, s)]\f] of
+    q = [s, v]. ARG_ERROR for zero and for negative reals.
+   */
+  QUATERNION_FLAGS log(quaternion<T> &out) const;
 
   /**
     \brief from Vince 2011 - Quaternions for Computer
@@ -181,9 +213,127 @@ public:
 
   QUATERNION_FLAGS get_component(std::size_t i, quat_c<T> &c) const;
 
+  /**
+    Value returning api. These share the kernels of the flags api
+    above and report no errors, so they can be chained and kept in
+    registers. Check for the zero quaternion first where it can occur:
+    normalize() and inverse() of zero give NaNs for float and double,
+    for q1_30 normalize() returns *this and inverse() returns zero.
+   */
+  quaternion operator*(const quaternion &q) const noexcept;
+  quaternion operator+(const quaternion &q) const noexcept;
+  quaternion operator-(const quaternion &q) const noexcept;
+  quaternion operator-() const noexcept;
+  quaternion conjugate() const noexcept;
+  quaternion normalize() const noexcept;
+  quaternion inverse() const noexcept;
+
 private:
+  /**
+    Kernels shared by the flags and the value api. out may alias
+    the inputs.
+   */
+  static void hamilton_kernel(const T a[4], const T b[4], T out[4]) noexcept;
+  static void add_kernel(const T a[4], const T b[4], T out[4]) noexcept;
+  static void subtract_kernel(const T a[4], const T b[4], T out[4]) noexcept;
+  static void negate_kernel(const T a[4], T out[4]) noexcept;
+  static void conjugate_kernel(const T a[4], T out[4]) noexcept;
+  static void inverse_kernel(const T a[4], T out[4]) noexcept;
+
   T coeffs[4];
 };
+
+template <class T>
+template <class Fn>
+QUATERNION_FLAGS quaternion<T>::apply(T t, Fn fn, T out[3]) const {
+  T vec[3];
+  auto res = vector(vec);
+
+  if (res != SUCCESS)
+    return res;
+
+  out[0] = fn(vec[0], t);
+  out[1] = fn(vec[1], t);
+  out[2] = fn(vec[2], t);
+  return SUCCESS;
+}
+template <class T>
+template <class Fn>
+QUATERNION_FLAGS quaternion<T>::apply(T t[3], Fn fn, T out[3]) const {
+  T vec[3];
+  auto res = vector(vec);
+  if (res != SUCCESS)
+    return res;
+  out[0] = fn(vec[0], t[0]);
+  out[1] = fn(vec[1], t[1]);
+  out[2] = fn(vec[2], t[2]);
+  return SUCCESS;
+}
+template <class T>
+template <class Fn>
+QUATERNION_FLAGS quaternion<T>::apply(const quaternion &q, Fn fn,
+                                      quaternion<T> &out) const {
+  //
+  T s;
+  T qs;
+  auto res = scalar(s);
+  if (res != SUCCESS)
+    return res;
+  res = q.scalar(qs);
+  if (res != SUCCESS)
+    return res;
+  //
+  T sresult = fn(s, qs);
+
+  T ovec[3];
+  T qvec[3];
+
+  res = q.vector(qvec);
+  if (res != SUCCESS)
+    return res;
+
+  //
+  res = apply(qvec, fn, ovec);
+  if (res != SUCCESS)
+    return res;
+
+  // o
+  out = quaternion(sresult, ovec);
+  return SUCCESS;
+}
+template <class T>
+template <class Fn>
+QUATERNION_FLAGS quaternion<T>::apply(const T &q, Fn fn,
+                                      quaternion<T> &out) const {
+  T s;
+  auto res = scalar(s);
+  if (res != SUCCESS)
+    return res;
+
+  // scalar result
+  T sres = fn(s, q);
+
+  T vec[3];
+  res = vector(vec);
+  if (res != SUCCESS)
+    return res;
+
+  //
+  T ovec[3];
+  ovec[0] = fn(vec[0], q);
+  ovec[1] = fn(vec[1], q);
+  ovec[2] = fn(vec[2], q);
+  //
+  out = quaternion(sres, ovec);
+  return SUCCESS;
+}
+
+// instantiated once in the quaternion library (quaternion_instances.cpp),
+// define QUATERNION_NO_EXTERN_TEMPLATES to instantiate them yourself
+#ifndef QUATERNION_NO_EXTERN_TEMPLATES
+extern template class quaternion<float>;
+extern template class quaternion<double>;
+#endif
 } // namespace quat11
 
 #endif
@@ -0,0 +1,235 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_ALLOCATOR_HPP
+#define QUATERNION_ALLOCATOR_HPP
+/**
+  Allocators for quaternion containers.
+
+  aligned_allocator hands out memory aligned to Align bytes, by
+  default a cache line, so that containers of quaternion data start
+  on a line boundary. Define QUATERNION_CACHE_LINE to change the
+  default line size.
+
+  arena_allocator takes memory from a quaternion_arena, which is
+  released all at once with quaternion_arena::reset.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifndef QUATERNION_CACHE_LINE
+#define QUATERNION_CACHE_LINE 64
+#endif
+
+namespace quat11 {
+
+template <class T, std::size_t Align = QUATERNION_CACHE_LINE>
+struct aligned_allocator {
+  static_assert((Align & (Align - 1)) == 0, "Align must be a power of two");
+  typedef T value_type;
+  template <class U> struct rebind {
+    typedef aligned_allocator<U, Align> other;
+  };
+
+  aligned_allocator() noexcept {}
+  template <class U>
+  aligned_allocator(const aligned_allocator<U, Align> &) noexcept {}
+
+  /**
+    over allocate by Align plus one pointer, the original pointer
+    is kept right before the aligned block for deallocate
+   */
+  T *allocate(std::size_t n) {
+    if (n > (static_cast<std::size_t>(-1) - Align - sizeof(void *)) / sizeof(T))
+      throw std::bad_alloc();
+    void *raw = std::malloc(n * sizeof(T) + Align + sizeof(void *));
+    if (raw == nullptr)
+      throw std::bad_alloc();
+    std::uintptr_t start =
+        reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *);
+    std::uintptr_t aligned = (start + Align - 1) & ~(std::uintptr_t(Align) - 1);
+    reinterpret_cast<void **>(aligned)[-1] = raw;
+    return reinterpret_cast<T *>(aligned);
+  }
+  void deallocate(T *p, std::size_t) noexcept {
+    if (p != nullptr)
+      std::free(reinterpret_cast<void **>(p)[-1]);
+  }
+};
+
+template <class T, class U, std::size_t Align>
+bool operator==(const aligned_allocator<T, Align> &,
+                const aligned_allocator<U, Align> &) noexcept {
+  return true;
+}
+template <class T, class U, std::size_t Align>
+bool operator!=(const aligned_allocator<T, Align> &,
+                const aligned_allocator<U, Align> &) noexcept {
+  return false;
+}
+
+/**
+  \brief Bump allocator for scratch memory that lives one frame.
+
+  Every allocation starts on a cache line and only moves a pointer
+  forward, deallocation does nothing. reset hands all memory back at
+  once in constant time. Allocations that do not fit any more get
+  their own block from the heap, the next reset frees those and grows
+  the arena to the total, so from then on a frame of the same size
+  causes no heap traffic at all.
+
+  Containers using the arena have to be destroyed or cleared before
+  reset. An arena is not thread safe, use one per thread.
+ */
+class quaternion_arena {
+public:
+  explicit quaternion_arena(std::size_t bytes = 0)
+      : base(nullptr), cap(0), top(0), spilled(0) {
+    grow(bytes);
+  }
+  ~quaternion_arena() {
+    release_overflow();
+    aligned_allocator<unsigned char>().deallocate(base, cap);
+  }
+  quaternion_arena(const quaternion_arena &) = delete;
+  quaternion_arena &operator=(const quaternion_arena &) = delete;
+
+  /** bytes aligned to QUATERNION_CACHE_LINE, throws std::bad_alloc*/
+  void *allocate(std::size_t bytes) {
+    const std::size_t line = QUATERNION_CACHE_LINE;
+    if (bytes > static_cast<std::size_t>(-1) - line)
+      throw std::bad_alloc();
+    const std::size_t rounded = (bytes + line - 1) & ~(line - 1);
+    if (rounded <= cap - top) {
+      unsigned char *p = base + top;
+      top += rounded;
+      return p;
+    }
+    unsigned char *p = aligned_allocator<unsigned char>().allocate(rounded);
+    overflow.push_back(block(p, rounded));
+    spilled += rounded;
+    return p;
+  }
+
+  /**
+    release everything, constant time unless the last frame
+    overflowed, then the arena is regrown once to fit it
+   */
+  void reset() {
+    if (!overflow.empty()) {
+      std::size_t want = top + spilled;
+      release_overflow();
+      grow(want);
+    }
+    top = 0;
+  }
+
+  /** bytes handed out since the last reset, including overflow*/
+  std::size_t used() const { return top + spilled; }
+  std::size_t capacity() const { return cap; }
+
+private:
+  typedef std::pair<unsigned char *, std::size_t> block;
+
+  void grow(std::size_t bytes) {
+    const std::size_t line = QUATERNION_CACHE_LINE;
+    bytes = (bytes + line - 1) & ~(line - 1);
+    if (bytes <= cap)
+      return;
+    aligned_allocator<unsigned char> a;
+    unsigned char *p = a.allocate(bytes);
+    a.deallocate(base, cap);
+    base = p;
+    cap = bytes;
+  }
+  void release_overflow() {
+    aligned_allocator<unsigned char> a;
+    for (std::size_t i = 0; i < overflow.size(); i++)
+      a.deallocate(overflow[i].first, overflow[i].second);
+    overflow.clear();
+    spilled = 0;
+  }
+
+  unsigned char *base;
+  std::size_t cap;
+  std::size_t top;
+  std::size_t spilled;
+  std::vector<block> overflow;
+};
+
+/**
+  \brief Standard allocator interface over a quaternion_arena.
+
+  deallocate is a no-op, memory comes back with the reset of the
+  arena. Two allocators are equal when they share the arena.
+ */
+template <class T> struct arena_allocator {
+  typedef T value_type;
+  template <class U> struct rebind { typedef arena_allocator<U> other; };
+
+  explicit arena_allocator(quaternion_arena &a) noexcept : arena(&a) {}
+  template <class U>
+  arena_allocator(const arena_allocator<U> &o) noexcept : arena(o.arena) {}
+
+  T *allocate(std::size_t n) {
+    if (n > static_cast<std::size_t>(-1) / sizeof(T))
+      throw std::bad_alloc();
+    return static_cast<T *>(arena->allocate(n * sizeof(T)));
+  }
+  void deallocate(T *, std::size_t) noexcept {}
+
+  quaternion_arena *arena;
+};
+
+template <class T, class U>
+bool operator==(const arena_allocator<T> &a,
+                const arena_allocator<U> &b) noexcept {
+  return a.arena == b.arena;
+}
+template <class T, class U>
+bool operator!=(const arena_allocator<T> &a,
+                const arena_allocator<U> &b) noexcept {
+  return a.arena != b.arena;
+}
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,367 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_BATCH_HPP
+#define QUATERNION_BATCH_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include "quaternion_iterator.hpp"
+#include "quaternion_parallel.hpp"
+#include <memory>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  \brief Many quaternions stored as structure of arrays.
+
+  Each component lives in its own contiguous array, so the batch
+  kernels below are plain loops over the four arrays that the
+  compiler can vectorize. out may be one of the inputs, it is
+  resized to the size of the inputs.
+
+  The arrays come from Alloc, an arena_allocator from
+  quaternion_allocator.hpp makes per frame batches free of heap
+  traffic, reserve them up front since growing leaves the old arrays
+  in the arena until its reset.
+ */
+template <class T, class Alloc = std::allocator<T>> class quaternion_batch {
+public:
+  typedef Alloc allocator_type;
+  typedef quaternion<T> value_type;
+  typedef batch_reference<T> reference;
+  typedef batch_reference<const T> const_reference;
+  typedef batch_iterator<T> iterator;
+  typedef batch_iterator<const T> const_iterator;
+
+  quaternion_batch() {}
+  explicit quaternion_batch(const Alloc &a)
+      : c{array(a), array(a), array(a), array(a)} {}
+  explicit quaternion_batch(std::size_t n, const Alloc &a = Alloc())
+      : c{array(a), array(a), array(a), array(a)} {
+    resize(n);
+  }
+
+  allocator_type get_allocator() const { return c[0].get_allocator(); }
+
+  std::size_t size() const { return c[0].size(); }
+  void resize(std::size_t n) {
+    for (unsigned int k = 0; k < 4; k++)
+      c[k].resize(n);
+  }
+  void reserve(std::size_t n) {
+    for (unsigned int k = 0; k < 4; k++)
+      c[k].reserve(n);
+  }
+  void push_back(const quaternion<T> &q) {
+    T s = static_cast<T>(0);
+    T v[3];
+    q.scalar(s);
+    q.vector(v);
+    c[0].push_back(s);
+    c[1].push_back(v[0]);
+    c[2].push_back(v[1]);
+    c[3].push_back(v[2]);
+  }
+
+  QUATERNION_FLAGS get(std::size_t i, quaternion<T> &out) const {
+    if (i >= size())
+      return INDEX_ERROR;
+    out = quaternion<T>(c[0][i], c[1][i], c[2][i], c[3][i]);
+    return SUCCESS;
+  }
+  QUATERNION_FLAGS set(std::size_t i, const quaternion<T> &q) {
+    if (i >= size())
+      return INDEX_ERROR;
+    T s = static_cast<T>(0);
+    T v[3];
+    q.scalar(s);
+    q.vector(v);
+    c[0][i] = s;
+    c[1][i] = v[0];
+    c[2][i] = v[1];
+    c[3][i] = v[2];
+    return SUCCESS;
+  }
+
+  /** component array, 0 is the scalar part*/
+  T *data(unsigned int k) { return c[k].data(); }
+  const T *data(unsigned int k) const { return c[k].data(); }
+
+  /** unchecked element access through a proxy*/
+  reference operator[](std::size_t i) { return *(begin() + i); }
+  const_reference operator[](std::size_t i) const { return *(begin() + i); }
+
+  iterator begin() {
+    return iterator(data(0), data(1), data(2), data(3), 0);
+  }
+  iterator end() { return begin() + size(); }
+  const_iterator begin() const {
+    return const_iterator(data(0), data(1), data(2), data(3), 0);
+  }
+  const_iterator end() const { return begin() + size(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  /**
+    ordered product \f[q_0 q_1 \cdots q_{n-1}\f], the identity for an
+    empty batch. Each block is multiplied as a tree of neighbouring
+    pairs, one tree level is a loop over independent products that
+    vectorizes, the order of the factors never changes. With several
+    threads each takes a contiguous run of blocks and the partial
+    products are multiplied in order.
+   */
+  QUATERNION_FLAGS reduce_product(quaternion<T> &out,
+                                  unsigned int threads = 1) const {
+    const std::size_t n = size();
+    T acc[4] = {static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+                static_cast<T>(0)};
+    if (threads == 1) {
+      reduce_blocks(0, n, acc);
+    } else {
+      // one slot per block, a run stores at its first block and the
+      // other slots stay the identity
+      const std::size_t blocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+      std::vector<T> partial(4 * blocks, static_cast<T>(0));
+      for (std::size_t i = 0; i < blocks; i++)
+        partial[4 * i] = static_cast<T>(1);
+      parallel_ranges(blocks, threads, [&](std::size_t b0, std::size_t b1) {
+        if (b0 < b1)
+          reduce_blocks(b0 * REDUCE_BLOCK,
+                        b1 * REDUCE_BLOCK < n ? b1 * REDUCE_BLOCK : n,
+                        &partial[4 * b0]);
+      });
+      for (std::size_t i = 0; i < blocks; i++)
+        multiply_into(acc, &partial[4 * i]);
+    }
+    out = quaternion<T>(acc[0], acc[1], acc[2], acc[3]);
+    return SUCCESS;
+  }
+
+  /** conjugate over the squared norm of every element*/
+  QUATERNION_FLAGS inversed(quaternion_batch &out) const {
+    const std::size_t n = size();
+    out.resize(n);
+    T t[4][LANE_BLOCK];
+    for (std::size_t i0 = 0; i0 < n; i0 += LANE_BLOCK) {
+      const std::size_t m = n - i0 < LANE_BLOCK ? n - i0 : LANE_BLOCK;
+      const T *w = c[0].data() + i0;
+      const T *x = c[1].data() + i0;
+      const T *y = c[2].data() + i0;
+      const T *z = c[3].data() + i0;
+      for (std::size_t i = 0; i < m; i++) {
+        T inv_mag2 = static_cast<T>(1) /
+                     (w[i] * w[i] + x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        t[0][i] = w[i] * inv_mag2;
+        t[1][i] = -x[i] * inv_mag2;
+        t[2][i] = -y[i] * inv_mag2;
+        t[3][i] = -z[i] * inv_mag2;
+      }
+      out.store(i0, m, t);
+    }
+    return SUCCESS;
+  }
+  QUATERNION_FLAGS conjugate(quaternion_batch &out) const {
+    const std::size_t n = size();
+    out.resize(n);
+    for (std::size_t i = 0; i < n; i++)
+      out.c[0][i] = c[0][i];
+    for (unsigned int k = 1; k < 4; k++) {
+      const T *a = c[k].data();
+      T *o = out.c[k].data();
+      for (std::size_t i = 0; i < n; i++)
+        o[i] = -a[i];
+    }
+    return SUCCESS;
+  }
+  /** element wise hamilton product, SIZE_ERROR if the sizes differ*/
+  QUATERNION_FLAGS hamilton_product(const quaternion_batch &b,
+                                    quaternion_batch &out) const {
+    const std::size_t n = size();
+    if (b.size() != n)
+      return SIZE_ERROR;
+    out.resize(n);
+    T t[4][LANE_BLOCK];
+    for (std::size_t i0 = 0; i0 < n; i0 += LANE_BLOCK) {
+      const std::size_t m = n - i0 < LANE_BLOCK ? n - i0 : LANE_BLOCK;
+      const T *aw = c[0].data() + i0;
+      const T *ax = c[1].data() + i0;
+      const T *ay = c[2].data() + i0;
+      const T *az = c[3].data() + i0;
+      const T *bw = b.c[0].data() + i0;
+      const T *bx = b.c[1].data() + i0;
+      const T *by = b.c[2].data() + i0;
+      const T *bz = b.c[3].data() + i0;
+      for (std::size_t i = 0; i < m; i++) {
+        // s_a s_b - a \cdot b
+        t[0][i] =
+            aw[i] * bw[i] - (bx[i] * ax[i] + by[i] * ay[i] + bz[i] * az[i]);
+        // s_a b + s_b a + a \times b
+        t[1][i] =
+            aw[i] * bx[i] + bw[i] * ax[i] + (ay[i] * bz[i] - az[i] * by[i]);
+        t[2][i] =
+            aw[i] * by[i] + bw[i] * ay[i] + (az[i] * bx[i] - ax[i] * bz[i]);
+        t[3][i] =
+            aw[i] * bz[i] + bw[i] * az[i] + (ax[i] * by[i] - ay[i] * bx[i]);
+      }
+      out.store(i0, m, t);
+    }
+    return SUCCESS;
+  }
+  /**
+    relative rotation \f[a_i^{-1} b_i\f] of every pair, the usual
+    building block of relative poses, in one pass without an
+    intermediate inverse batch
+   */
+  QUATERNION_FLAGS relative(const quaternion_batch &b,
+                            quaternion_batch &out) const {
+    const std::size_t n = size();
+    if (b.size() != n)
+      return SIZE_ERROR;
+    out.resize(n);
+    T t[4][LANE_BLOCK];
+    for (std::size_t i0 = 0; i0 < n; i0 += LANE_BLOCK) {
+      const std::size_t m = n - i0 < LANE_BLOCK ? n - i0 : LANE_BLOCK;
+      const T *aw = c[0].data() + i0;
+      const T *ax = c[1].data() + i0;
+      const T *ay = c[2].data() + i0;
+      const T *az = c[3].data() + i0;
+      const T *bw = b.c[0].data() + i0;
+      const T *bx = b.c[1].data() + i0;
+      const T *by = b.c[2].data() + i0;
+      const T *bz = b.c[3].data() + i0;
+      for (std::size_t i = 0; i < m; i++) {
+        // conjugate of a times b, over the squared norm of a
+        T inv_mag2 = static_cast<T>(1) / (aw[i] * aw[i] + ax[i] * ax[i] +
+                                          ay[i] * ay[i] + az[i] * az[i]);
+        T s = aw[i] * bw[i] + (bx[i] * ax[i] + by[i] * ay[i] + bz[i] * az[i]);
+        T x = aw[i] * bx[i] - bw[i] * ax[i] - (ay[i] * bz[i] - az[i] * by[i]);
+        T y = aw[i] * by[i] - bw[i] * ay[i] - (az[i] * bx[i] - ax[i] * bz[i]);
+        T z = aw[i] * bz[i] - bw[i] * az[i] - (ax[i] * by[i] - ay[i] * bx[i]);
+        t[0][i] = s * inv_mag2;
+        t[1][i] = x * inv_mag2;
+        t[2][i] = y * inv_mag2;
+        t[3][i] = z * inv_mag2;
+      }
+      out.store(i0, m, t);
+    }
+    return SUCCESS;
+  }
+
+private:
+  /** factors per tree of reduce_product*/
+  static const std::size_t REDUCE_BLOCK = 1024;
+
+  /** acc = acc r*/
+  static void multiply_into(T acc[4], const T r[4]) {
+    T p[4];
+    p[0] = acc[0] * r[0] - (r[1] * acc[1] + r[2] * acc[2] + r[3] * acc[3]);
+    p[1] = acc[0] * r[1] + r[0] * acc[1] + (acc[2] * r[3] - acc[3] * r[2]);
+    p[2] = acc[0] * r[2] + r[0] * acc[2] + (acc[3] * r[1] - acc[1] * r[3]);
+    p[3] = acc[0] * r[3] + r[0] * acc[3] + (acc[1] * r[2] - acc[2] * r[1]);
+    for (unsigned int k = 0; k < 4; k++)
+      acc[k] = p[k];
+  }
+  /** acc = acc q_{i0} ... q_{i1 - 1}, by trees of REDUCE_BLOCK factors*/
+  void reduce_blocks(std::size_t i0, std::size_t i1, T acc[4]) const {
+    // levels alternate between the two buffers
+    T ta[4][REDUCE_BLOCK / 2];
+    T tb[4][REDUCE_BLOCK / 4];
+    T *a[4] = {ta[0], ta[1], ta[2], ta[3]};
+    T *b[4] = {tb[0], tb[1], tb[2], tb[3]};
+    for (; i0 < i1; i0 += REDUCE_BLOCK) {
+      std::size_t m = i1 - i0 < REDUCE_BLOCK ? i1 - i0 : REDUCE_BLOCK;
+      T r[4];
+      if (m == 1) {
+        for (unsigned int k = 0; k < 4; k++)
+          r[k] = c[k][i0];
+      } else {
+        const T *src[4] = {c[0].data() + i0, c[1].data() + i0,
+                           c[2].data() + i0, c[3].data() + i0};
+        m = pair_products(src, m, a);
+        bool in_a = true;
+        while (m > 1) {
+          m = in_a ? pair_products(a, m, b) : pair_products(b, m, a);
+          in_a = !in_a;
+        }
+        for (unsigned int k = 0; k < 4; k++)
+          r[k] = in_a ? a[k][0] : b[k][0];
+      }
+      multiply_into(acc, r);
+    }
+  }
+
+  /**
+    d_i = s_{2i} s_{2i+1}, an odd last factor is carried over, returns
+    the number of factors left
+   */
+  static std::size_t pair_products(const T *const s[4], std::size_t m,
+                                   T *const d[4]) {
+    const std::size_t half = m / 2;
+    const T *s0 = s[0], *s1 = s[1], *s2 = s[2], *s3 = s[3];
+    T *d0 = d[0], *d1 = d[1], *d2 = d[2], *d3 = d[3];
+    for (std::size_t i = 0; i < half; i++) {
+      const std::size_t l = 2 * i, r = 2 * i + 1;
+      d0[i] = s0[l] * s0[r] - (s1[r] * s1[l] + s2[r] * s2[l] + s3[r] * s3[l]);
+      d1[i] = s0[l] * s1[r] + s0[r] * s1[l] + (s2[l] * s3[r] - s3[l] * s2[r]);
+      d2[i] = s0[l] * s2[r] + s0[r] * s2[l] + (s3[l] * s1[r] - s1[l] * s3[r]);
+      d3[i] = s0[l] * s3[r] + s0[r] * s3[l] + (s1[l] * s2[r] - s2[l] * s1[r]);
+    }
+    if (m & 1)
+      for (unsigned int k = 0; k < 4; k++)
+        d[k][half] = s[k][m - 1];
+    return half + (m & 1);
+  }
+
+  void store(std::size_t i0, std::size_t m, const T t[4][LANE_BLOCK]) {
+    for (unsigned int k = 0; k < 4; k++) {
+      T *o = c[k].data() + i0;
+      for (std::size_t i = 0; i < m; i++)
+        o[i] = t[k][i];
+    }
+  }
+
+  typedef std::vector<T, Alloc> array;
+  array c[4];
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,307 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_CLOUD_HPP
+#define QUATERNION_CLOUD_HPP
+#include "quaternion.hpp"
+#include "quaternion_parallel.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace quat11 {
+
+/**
+  \brief rotates the n interleaved points in, x y z each, by the
+  rotation of q and adds translation, which may be null. out may be
+  in. The quaternion is normalized once and applied as a matrix.
+  ARG_ERROR if q is zero.
+ */
+template <class T>
+QUATERNION_FLAGS rotate_points(const quaternion<T> &q, const T translation[3],
+                               const T *in, std::size_t n, T *out) {
+  quaternion<T> u;
+  T nrm;
+  q.norm(nrm);
+  if (nrm == static_cast<T>(0))
+    return ARG_ERROR;
+  q.normalized(u);
+  T w, v[3];
+  u.scalar(w);
+  u.vector(v);
+  const T one = static_cast<T>(1), two = static_cast<T>(2);
+  const T r0 = one - two * (v[1] * v[1] + v[2] * v[2]),
+          r1 = two * (v[0] * v[1] - w * v[2]),
+          r2 = two * (v[0] * v[2] + w * v[1]),
+          r3 = two * (v[0] * v[1] + w * v[2]),
+          r4 = one - two * (v[0] * v[0] + v[2] * v[2]),
+          r5 = two * (v[1] * v[2] - w * v[0]),
+          r6 = two * (v[0] * v[2] - w * v[1]),
+          r7 = two * (v[1] * v[2] + w * v[0]),
+          r8 = one - two * (v[0] * v[0] + v[1] * v[1]);
+  const T zero = static_cast<T>(0);
+  const T t0 = translation ? translation[0] : zero,
+          t1 = translation ? translation[1] : zero,
+          t2 = translation ? translation[2] : zero;
+  for (std::size_t i = 0; i < n; i++) {
+    T x = in[3 * i], y = in[3 * i + 1], z = in[3 * i + 2];
+    out[3 * i] = r0 * x + r1 * y + r2 * z + t0;
+    out[3 * i + 1] = r3 * x + r4 * y + r5 * z + t1;
+    out[3 * i + 2] = r6 * x + r7 * y + r8 * z + t2;
+  }
+  return SUCCESS;
+}
+
+/** how rotate_cloud_file splits and writes its work*/
+struct cloud_options {
+  /** worker threads, zero for one per hardware thread*/
+  unsigned int threads;
+  /**
+    write through O_DIRECT from aligned buffers instead of a shared
+    mapping of the output, so the output skips the page cache
+   */
+  bool direct;
+  /** points per chunk, rounded up to whole pages of the files*/
+  std::size_t chunk_points;
+  cloud_options() : threads(0), direct(false), chunk_points(1 << 20) {}
+};
+
+namespace cloud_detail {
+
+/** closes a descriptor on scope exit*/
+struct descriptor {
+  int fd;
+  explicit descriptor(int f) : fd(f) {}
+  ~descriptor() {
+    if (fd >= 0)
+      close(fd);
+  }
+};
+
+/** unmaps on scope exit*/
+struct mapping {
+  void *p;
+  std::size_t n;
+  mapping() : p(MAP_FAILED), n(0) {}
+  ~mapping() {
+    if (p != MAP_FAILED)
+      munmap(p, n);
+  }
+};
+
+/**
+  smallest multiple of points whose bytes are whole pages, which
+  madvise, msync and O_DIRECT need at chunk boundaries
+ */
+template <class T> std::size_t chunk_granule() {
+  long page = sysconf(_SC_PAGESIZE);
+  std::size_t g = page < 4096 ? 4096 : static_cast<std::size_t>(page);
+  std::size_t point = 3 * sizeof(T), a = g, b = point;
+  while (b != 0) {
+    std::size_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return g / a;
+}
+
+/** writes all of n bytes at offset, false with errno set otherwise*/
+inline bool write_all(int fd, const char *p, std::size_t n, off_t offset) {
+  while (n > 0) {
+    ssize_t w = pwrite(fd, p, n, offset);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += w;
+    n -= static_cast<std::size_t>(w);
+    offset += w;
+  }
+  return true;
+}
+
+} // namespace cloud_detail
+
+/**
+  \brief rotates the raw file of interleaved x y z values of type T
+  at input into output, see rotate_points, without reading it whole.
+  The input is memory mapped and split into chunks over threads.
+  The chunks of input and of a mapped output are unmapped from the
+  process after use, so the resident memory stays near threads
+  chunks. The output is written through a shared mapping, or through
+  O_DIRECT with options.direct. The mapped output is reserved with
+  posix_fallocate first, so a full disk is an error and not a SIGBUS,
+  and both outputs are flushed with fsync before SUCCESS.
+
+  SIZE_ERROR if the input is not whole points. ARG_ERROR if q is
+  zero, if both paths are one file or if a system call fails. In the
+  last case error receives errno, else it is zero.
+ */
+template <class T>
+QUATERNION_FLAGS rotate_cloud_file(const char *input, const char *output,
+                                   const quaternion<T> &q,
+                                   const T translation[3],
+                                   const cloud_options &options, int &error) {
+  using namespace cloud_detail;
+  error = 0;
+  T nrm;
+  q.norm(nrm);
+  if (nrm == static_cast<T>(0))
+    return ARG_ERROR;
+  descriptor in(open(input, O_RDONLY));
+  struct stat si, so;
+  if (in.fd < 0 || fstat(in.fd, &si) != 0) {
+    error = errno;
+    return ARG_ERROR;
+  }
+  const std::size_t bytes = static_cast<std::size_t>(si.st_size);
+  if (bytes % (3 * sizeof(T)) != 0)
+    return SIZE_ERROR;
+  if (stat(output, &so) == 0 && so.st_dev == si.st_dev &&
+      so.st_ino == si.st_ino)
+    return ARG_ERROR;
+  int flags = O_RDWR | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+  if (options.direct)
+    flags |= O_DIRECT;
+#else
+  if (options.direct) {
+    error = EINVAL;
+    return ARG_ERROR;
+  }
+#endif
+  descriptor out(open(output, flags, 0644));
+  if (out.fd < 0) {
+    error = errno;
+    return ARG_ERROR;
+  }
+  const std::size_t n = bytes / (3 * sizeof(T));
+  if (n == 0)
+    return SUCCESS;
+  mapping src, dst;
+  src.p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, in.fd, 0);
+  src.n = bytes;
+  if (src.p == MAP_FAILED) {
+    error = errno;
+    return ARG_ERROR;
+  }
+  madvise(src.p, bytes, MADV_SEQUENTIAL);
+  if (!options.direct) {
+    // ftruncate would leave a sparse file, whose pages can fail to
+    // find blocks on write back. posix_fallocate returns the error
+    int res = posix_fallocate(out.fd, 0, static_cast<off_t>(bytes));
+    if (res != 0) {
+      error = res;
+      return ARG_ERROR;
+    }
+    dst.p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, out.fd, 0);
+    dst.n = bytes;
+    if (dst.p == MAP_FAILED) {
+      error = errno;
+      return ARG_ERROR;
+    }
+  }
+  const std::size_t granule = chunk_granule<T>();
+  std::size_t chunk = options.chunk_points < 1 ? 1 : options.chunk_points;
+  chunk = (chunk + granule - 1) / granule * granule;
+  const std::size_t chunks = (n + chunk - 1) / chunk;
+  const T *from = static_cast<const T *>(src.p);
+  T *to = static_cast<T *>(dst.p);
+  std::atomic<int> failed(0);
+  parallel_ranges(chunks, options.threads, [&](std::size_t c0,
+                                                std::size_t c1) {
+    void *buffer = nullptr;
+    const std::size_t chunk_bytes = 3 * sizeof(T) * chunk;
+    if (options.direct && posix_memalign(&buffer, 4096, chunk_bytes) != 0) {
+      failed.store(ENOMEM);
+      return;
+    }
+    for (std::size_t c = c0; c < c1 && failed.load() == 0; c++) {
+      const std::size_t first = c * chunk;
+      const std::size_t m = n - first < chunk ? n - first : chunk;
+      const std::size_t used = 3 * sizeof(T) * m;
+      const T *p = from + 3 * first;
+      if (options.direct) {
+        T *b = static_cast<T *>(buffer);
+        rotate_points(q, translation, p, m, b);
+        // O_DIRECT writes whole blocks, the tail is cut by ftruncate
+        std::size_t padded = (used + 4095) / 4096 * 4096;
+        if (!write_all(out.fd, static_cast<const char *>(buffer), padded,
+                       static_cast<off_t>(3 * sizeof(T) * first)))
+          failed.store(errno);
+      } else {
+        T *o = to + 3 * first;
+        rotate_points(q, translation, p, m, o);
+        // start the write back, then unmap the chunk from the process.
+        // Dirty pages stay in the page cache until written, no data
+        // is lost, the fsync at the end reports failed writes
+        if (msync(o, used, MS_ASYNC) != 0 ||
+            madvise(o, used, MADV_DONTNEED) != 0)
+          failed.store(errno);
+      }
+      // unmaps the read chunk from the process, the pages stay in the
+      // page cache, the advice on the descriptor lets them go
+      madvise(const_cast<T *>(p), used, MADV_DONTNEED);
+      posix_fadvise(in.fd, static_cast<off_t>(3 * sizeof(T) * first),
+                    static_cast<off_t>(used), POSIX_FADV_DONTNEED);
+    }
+    std::free(buffer);
+  });
+  if (failed.load() != 0) {
+    error = failed.load();
+    return ARG_ERROR;
+  }
+  if (options.direct && ftruncate(out.fd, static_cast<off_t>(bytes)) != 0) {
+    error = errno;
+    return ARG_ERROR;
+  }
+  if (fsync(out.fd) != 0) {
+    error = errno;
+    return ARG_ERROR;
+  }
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
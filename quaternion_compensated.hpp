@@ -0,0 +1,269 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_COMPENSATED_HPP
+#define QUATERNION_COMPENSATED_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace quat11 {
+namespace compensated_detail {
+
+/** s + e == a + b exactly, Knuth 1969*/
+template <class T> inline void two_sum(T a, T b, T &s, T &e) {
+  s = a + b;
+  T bb = s - a;
+  e = (a - (s - bb)) + (b - bb);
+}
+/** p + e == a b exactly, with fma if it is fast, else Dekker 1971*/
+template <class T> inline void two_prod(T a, T b, T &p, T &e) {
+  p = a * b;
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+  using std::fma;
+  e = fma(a, b, -p);
+#else
+  const T split = static_cast<T>(
+      (1u << ((std::numeric_limits<T>::digits + 1) / 2)) + 1u);
+  T ta = split * a;
+  T ah = ta - (ta - a);
+  T al = a - ah;
+  T tb = split * b;
+  T bh = tb - (tb - b);
+  T bl = b - bh;
+  e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+}
+template <class T> inline void coefficients(const quaternion<T> &q, T c[4]) {
+  q.scalar(c[0]);
+  q.vector(c + 1);
+}
+/**
+  hamilton product of (ah + al) (bh + bl) as an unevaluated sum
+  hi + lo. Every coefficient is a dot product of four terms, summed
+  with the Dot2 algorithm of Ogita, Rump and Oishi 2005, pairwise to
+  shorten the dependency chain. The products of the low parts with
+  the high parts go into the error term. The four coefficients are
+  computed side by side, lane j is coefficient j, so the loops map
+  onto one vector register.
+ */
+template <class T>
+inline void hamilton(const T ah[4], const T al[4], const T bh[4],
+                     const T bl[4], T hi[4], T lo[4]) {
+  // term k of coefficient j is x[k][j] y[k][j], see hamilton_kernel
+  const T x[4][4] = {{ah[0], ah[0], ah[0], ah[0]},
+                     {-ah[1], ah[1], ah[2], ah[3]},
+                     {-ah[2], ah[2], ah[3], ah[1]},
+                     {-ah[3], -ah[3], -ah[1], -ah[2]}};
+  const T xl[4][4] = {{al[0], al[0], al[0], al[0]},
+                      {-al[1], al[1], al[2], al[3]},
+                      {-al[2], al[2], al[3], al[1]},
+                      {-al[3], -al[3], -al[1], -al[2]}};
+  const T y[4][4] = {{bh[0], bh[1], bh[2], bh[3]},
+                     {bh[1], bh[0], bh[0], bh[0]},
+                     {bh[2], bh[3], bh[1], bh[2]},
+                     {bh[3], bh[2], bh[3], bh[1]}};
+  const T yl[4][4] = {{bl[0], bl[1], bl[2], bl[3]},
+                      {bl[1], bl[0], bl[0], bl[0]},
+                      {bl[2], bl[3], bl[1], bl[2]},
+                      {bl[3], bl[2], bl[3], bl[1]}};
+  T p[4][4], e[4][4], c[4];
+  for (unsigned int k = 0; k < 4; k++)
+    for (unsigned int j = 0; j < 4; j++)
+      two_prod(x[k][j], y[k][j], p[k][j], e[k][j]);
+  for (unsigned int j = 0; j < 4; j++)
+    c[j] = (x[0][j] * yl[0][j] + xl[0][j] * y[0][j]) +
+           (x[1][j] * yl[1][j] + xl[1][j] * y[1][j]) +
+           (x[2][j] * yl[2][j] + xl[2][j] * y[2][j]) +
+           (x[3][j] * yl[3][j] + xl[3][j] * y[3][j]);
+  T s01[4], e01[4], s23[4], e23[4], s[4], es[4];
+  for (unsigned int j = 0; j < 4; j++) {
+    two_sum(p[0][j], p[1][j], s01[j], e01[j]);
+    two_sum(p[2][j], p[3][j], s23[j], e23[j]);
+  }
+  for (unsigned int j = 0; j < 4; j++) {
+    two_sum(s01[j], s23[j], s[j], es[j]);
+    c[j] += ((e[0][j] + e[1][j]) + (e[2][j] + e[3][j])) +
+            ((e01[j] + e23[j]) + es[j]);
+  }
+  for (unsigned int j = 0; j < 4; j++)
+    two_sum(s[j], c[j], hi[j], lo[j]);
+}
+
+} // namespace compensated_detail
+
+/**
+  \brief Quaternion as an unevaluated sum of two quaternions hi + lo.
+
+  Every coefficient carries its rounding error in lo, products and
+  sums are computed with error free transformations. Long chains of
+  float products stay close to double accuracy while all arithmetic
+  is done in float. Use it at the call sites that need it and convert
+  back with to_quaternion.
+
+  It is not a faster double. A compensated product is 16 two_prod
+  and 16 two_sum, several times the work of a double product, and a
+  chain is one long dependency so there is no batch form to hide it.
+  It pays off where double is slow or missing, on float only FPUs and
+  GPUs, where the data has to stay float, or with T = double for about
+  twice the digits of double.
+ */
+template <class T> class compensated_quaternion {
+public:
+  /** zero*/
+  compensated_quaternion() {
+    for (unsigned int k = 0; k < 4; k++) {
+      hi[k] = static_cast<T>(0);
+      lo[k] = static_cast<T>(0);
+    }
+  }
+  explicit compensated_quaternion(const quaternion<T> &q) {
+    compensated_detail::coefficients(q, hi);
+    for (unsigned int k = 0; k < 4; k++)
+      lo[k] = static_cast<T>(0);
+  }
+
+  /** hi + lo rounded to T*/
+  QUATERNION_FLAGS to_quaternion(quaternion<T> &out) const {
+    T c[4];
+    for (unsigned int k = 0; k < 4; k++)
+      c[k] = hi[k] + lo[k];
+    out = quaternion<T>(c);
+    return SUCCESS;
+  }
+  /** hi + lo in a wider type, to compare against a reference*/
+  template <class U> QUATERNION_FLAGS widened(quaternion<U> &out) const {
+    U c[4];
+    for (unsigned int k = 0; k < 4; k++)
+      c[k] = static_cast<U>(hi[k]) + static_cast<U>(lo[k]);
+    out = quaternion<U>(c);
+    return SUCCESS;
+  }
+
+  QUATERNION_FLAGS hamilton_product(const compensated_quaternion &q,
+                                    compensated_quaternion &out) const {
+    compensated_detail::hamilton(hi, lo, q.hi, q.lo, out.hi, out.lo);
+    return SUCCESS;
+  }
+  QUATERNION_FLAGS hamilton_product(const quaternion<T> &q,
+                                    compensated_quaternion &out) const {
+    return hamilton_product(compensated_quaternion(q), out);
+  }
+  QUATERNION_FLAGS add(const compensated_quaternion &q,
+                       compensated_quaternion &out) const {
+    for (unsigned int k = 0; k < 4; k++) {
+      T s, e;
+      compensated_detail::two_sum(hi[k], q.hi[k], s, e);
+      e += lo[k] + q.lo[k];
+      compensated_detail::two_sum(s, e, out.hi[k], out.lo[k]);
+    }
+    return SUCCESS;
+  }
+  QUATERNION_FLAGS add(const quaternion<T> &q,
+                       compensated_quaternion &out) const {
+    return add(compensated_quaternion(q), out);
+  }
+
+  /** value returning api*/
+  compensated_quaternion
+  operator*(const compensated_quaternion &q) const noexcept {
+    compensated_quaternion out;
+    hamilton_product(q, out);
+    return out;
+  }
+  compensated_quaternion
+  operator+(const compensated_quaternion &q) const noexcept {
+    compensated_quaternion out;
+    add(q, out);
+    return out;
+  }
+
+private:
+  T hi[4];
+  T lo[4];
+};
+
+/**
+  hamilton product of two plain quaternions, rounded once at the end
+  instead of after every multiplication and addition
+ */
+template <class T>
+QUATERNION_FLAGS compensated_product(const quaternion<T> &a,
+                                     const quaternion<T> &b,
+                                     quaternion<T> &out) {
+  T ah[4], bh[4], hi[4], lo[4];
+  const T zero[4] = {static_cast<T>(0), static_cast<T>(0), static_cast<T>(0),
+                     static_cast<T>(0)};
+  compensated_detail::coefficients(a, ah);
+  compensated_detail::coefficients(b, bh);
+  compensated_detail::hamilton(ah, zero, bh, zero, hi, lo);
+  for (unsigned int k = 0; k < 4; k++)
+    hi[k] += lo[k];
+  out = quaternion<T>(hi);
+  return SUCCESS;
+}
+/** Kahan-Babuska (Neumaier) sum of n quaternions*/
+template <class T>
+QUATERNION_FLAGS compensated_sum(const quaternion<T> *qs, std::size_t n,
+                                 quaternion<T> &out) {
+  T hi[4] = {static_cast<T>(0), static_cast<T>(0), static_cast<T>(0),
+             static_cast<T>(0)};
+  T lo[4] = {static_cast<T>(0), static_cast<T>(0), static_cast<T>(0),
+             static_cast<T>(0)};
+  for (std::size_t i = 0; i < n; i++) {
+    T c[4];
+    compensated_detail::coefficients(qs[i], c);
+    for (unsigned int k = 0; k < 4; k++) {
+      T e;
+      compensated_detail::two_sum(hi[k], c[k], hi[k], e);
+      lo[k] += e;
+    }
+  }
+  for (unsigned int k = 0; k < 4; k++)
+    hi[k] += lo[k];
+  out = quaternion<T>(hi);
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,300 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_COUNTERS_HPP
+#define QUATERNION_COUNTERS_HPP
+/**
+  Operation counters for quaternion methods.
+
+  Define QUATERNION_ENABLE_COUNTERS before including quaternion.hpp
+  (or when compiling quaternion.cpp) to count calls and failures of
+  every quaternion operation. Define QUATERNION_COUNT_CYCLES as well
+  to also accumulate the cycles spent in each operation. Without
+  QUATERNION_ENABLE_COUNTERS the hooks expand to nothing. This header
+  is included by quaternion.hpp and quaternion.h once QUATERNION_FLAGS
+  is declared.
+
+  Only the outermost operation of a thread is counted, so
+  hamilton_product calling vector_cross shows up as a single
+  hamilton_product call and its cycles include the inner calls.
+  Counters live in thread local blocks which are only written by
+  their thread, collect merges them on demand.
+ */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#ifdef QUATERNION_COUNT_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+namespace quat11 {
+namespace counters {
+
+/** counted quaternion operations*/
+enum QUATERNION_OP {
+  OP_VECTOR_MULTIPLICATION,
+  OP_VECTOR_ADDITION,
+  OP_VECTOR_SUBTRACTION,
+  OP_VECTOR_DIVISION,
+  OP_VECTOR_DOT,
+  OP_VECTOR_CROSS,
+  OP_HAMILTON_PRODUCT,
+  OP_CONJUGATE,
+  OP_NORMALIZED,
+  OP_INVERSED,
+  OP_ROTATE,
+  OP_ADD,
+  OP_SUBTRACT,
+  OP_PRODUCT,
+  OP_POWER,
+  OP_SQUARED,
+  OP_NORM,
+  OP_DETERMINANT,
+  OP_GET_COMPONENT,
+  OP_NEGATE,
+  OP_LOG,
+  OP_LEFT_MATRIX,
+  OP_RIGHT_MATRIX,
+  OP_COUNT
+};
+
+/** one slot per QUATERNION_FLAGS value*/
+static const unsigned int FLAG_COUNT = 5;
+
+inline const char *op_name(unsigned int op) {
+  static const char *names[OP_COUNT] = {
+      "vector_multiplication",
+      "vector_addition",
+      "vector_subtraction",
+      "vector_division",
+      "vector_dot",
+      "vector_cross",
+      "hamilton_product",
+      "conjugate",
+      "normalized",
+      "inversed",
+      "rotate",
+      "add",
+      "subtract",
+      "product",
+      "power",
+      "squared",
+      "norm",
+      "determinant",
+      "get_component",
+      "negate",
+      "log",
+      "left_matrix",
+      "right_matrix"};
+  return op < OP_COUNT ? names[op] : "unknown";
+}
+
+/** merged counters of all threads*/
+struct snapshot {
+  std::uint64_t calls[OP_COUNT];
+  std::uint64_t failures[OP_COUNT][FLAG_COUNT];
+  std::uint64_t cycles[OP_COUNT];
+  snapshot() : calls{}, failures{}, cycles{} {}
+};
+
+/** counters of a single thread, written only by that thread*/
+struct thread_block {
+  std::atomic<std::uint64_t> calls[OP_COUNT];
+  std::atomic<std::uint64_t> failures[OP_COUNT][FLAG_COUNT];
+  std::atomic<std::uint64_t> cycles[OP_COUNT];
+  unsigned int depth;
+  thread_block() : depth(0) { clear(); }
+  void clear() {
+    for (unsigned int i = 0; i < OP_COUNT; i++) {
+      calls[i].store(0, std::memory_order_relaxed);
+      cycles[i].store(0, std::memory_order_relaxed);
+      for (unsigned int j = 0; j < FLAG_COUNT; j++)
+        failures[i][j].store(0, std::memory_order_relaxed);
+    }
+  }
+  void add_to(snapshot &s) const {
+    for (unsigned int i = 0; i < OP_COUNT; i++) {
+      s.calls[i] += calls[i].load(std::memory_order_relaxed);
+      s.cycles[i] += cycles[i].load(std::memory_order_relaxed);
+      for (unsigned int j = 0; j < FLAG_COUNT; j++)
+        s.failures[i][j] += failures[i][j].load(std::memory_order_relaxed);
+    }
+  }
+};
+
+/** single writer increment, no read-modify-write needed*/
+inline void bump(std::atomic<std::uint64_t> &c, std::uint64_t v) {
+  c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+/** live thread blocks and the totals of finished threads*/
+struct registry {
+  std::mutex lock;
+  std::vector<thread_block *> blocks;
+  snapshot retired;
+};
+
+inline registry &global_registry() {
+  static registry r;
+  return r;
+}
+
+struct thread_slot {
+  thread_block block;
+  thread_slot() {
+    registry &r = global_registry();
+    std::lock_guard<std::mutex> g(r.lock);
+    r.blocks.push_back(&block);
+  }
+  ~thread_slot() {
+    registry &r = global_registry();
+    std::lock_guard<std::mutex> g(r.lock);
+    block.add_to(r.retired);
+    for (std::size_t i = 0; i < r.blocks.size(); i++) {
+      if (r.blocks[i] == &block) {
+        r.blocks.erase(r.blocks.begin() + i);
+        break;
+      }
+    }
+  }
+};
+
+inline thread_block &local_block() {
+  static thread_local thread_slot slot;
+  return slot.block;
+}
+
+inline std::uint64_t now() {
+#ifdef QUATERNION_COUNT_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+#else
+  return 0;
+#endif
+}
+
+/** counts a call for the lifetime of the scope*/
+class op_scope {
+public:
+  explicit op_scope(QUATERNION_OP op)
+      : block_(local_block()), op_(op), outer_(block_.depth == 0), start_(0) {
+    block_.depth++;
+    if (outer_) {
+      bump(block_.calls[op_], 1);
+      start_ = now();
+    }
+  }
+  ~op_scope() {
+    block_.depth--;
+#ifdef QUATERNION_COUNT_CYCLES
+    if (outer_)
+      bump(block_.cycles[op_], now() - start_);
+#endif
+  }
+  std::uint_least8_t result(std::uint_least8_t res) {
+    if (outer_ && res != SUCCESS && res < FLAG_COUNT)
+      bump(block_.failures[op_][res], 1);
+    return res;
+  }
+
+private:
+  thread_block &block_;
+  QUATERNION_OP op_;
+  bool outer_;
+  std::uint64_t start_;
+};
+
+/** merge the counters of all threads, live and finished*/
+inline void collect(snapshot &out) {
+  registry &r = global_registry();
+  std::lock_guard<std::mutex> g(r.lock);
+  out = r.retired;
+  for (std::size_t i = 0; i < r.blocks.size(); i++)
+    r.blocks[i]->add_to(out);
+}
+
+/**
+  zero every counter, counts made by other threads while resetting
+  may be lost
+ */
+inline void reset() {
+  registry &r = global_registry();
+  std::lock_guard<std::mutex> g(r.lock);
+  r.retired = snapshot();
+  for (std::size_t i = 0; i < r.blocks.size(); i++)
+    r.blocks[i]->clear();
+}
+
+/** per operation profile as JSON*/
+inline std::ostream &operator<<(std::ostream &out, const snapshot &s) {
+  static const char *flag_names[FLAG_COUNT] = {"", "SUCCESS", "SIZE_ERROR",
+                                               "INDEX_ERROR", "ARG_ERROR"};
+  out << "{";
+  bool first = true;
+  for (unsigned int i = 0; i < OP_COUNT; i++) {
+    if (s.calls[i] == 0)
+      continue;
+    out << (first ? "" : ",") << "\n  \"" << op_name(i)
+        << "\": {\"calls\": " << s.calls[i] << ", \"cycles\": " << s.cycles[i];
+    for (unsigned int j = 2; j < FLAG_COUNT; j++)
+      out << ", \"" << flag_names[j] << "\": " << s.failures[i][j];
+    out << "}";
+    first = false;
+  }
+  out << "\n}" << std::endl;
+  return out;
+}
+
+} // namespace counters
+} // namespace quat11
+
+#define QUATERNION_COUNT(op)                                                   \
+  quat11::counters::op_scope quaternion_op_scope_(quat11::counters::op)
+#define QUATERNION_COUNT_RESULT(res)                                           \
+  static_cast<QUATERNION_FLAGS>(quaternion_op_scope_.result(res))
+
+#endif
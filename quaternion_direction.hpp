@@ -0,0 +1,196 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_DIRECTION_HPP
+#define QUATERNION_DIRECTION_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include "quaternion_unit.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace quat11 {
+
+namespace direction_detail {
+
+template <class T>
+bool two_vectors_block(const T *const a[3], const T *const b[3],
+                       std::size_t i0, std::size_t m, T *const out[4]) {
+  using std::sqrt;
+  const T one = static_cast<T>(1);
+  T s[LANE_BLOCK], n2[LANE_BLOCK], c[4][LANE_BLOCK];
+  for (std::size_t i = 0; i < m; i++) {
+    std::size_t j = i0 + i;
+    s[i] = (a[0][j] * a[0][j] + a[1][j] * a[1][j] + a[2][j] * a[2][j]) *
+           (b[0][j] * b[0][j] + b[1][j] * b[1][j] + b[2][j] * b[2][j]);
+  }
+  for (std::size_t i = 0; i < m; i++)
+    s[i] = sqrt(s[i]);
+  std::int32_t zero = 0;
+  for (std::size_t i = 0; i < m; i++) {
+    std::size_t j = i0 + i;
+    T u[3] = {a[0][j], a[1][j], a[2][j]};
+    T v[3] = {b[0][j], b[1][j], b[2][j]};
+    T q[4];
+    n2[i] = unit_detail::two_vectors_lane(u, v, s[i], q);
+    for (unsigned int k = 0; k < 4; k++)
+      c[k][i] = q[k];
+    std::int32_t none = s[i] == static_cast<T>(0);
+    zero += none;
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n2[i] = sqrt(n2[i]);
+  T *w = out[0] + i0, *x = out[1] + i0, *y = out[2] + i0, *z = out[3] + i0;
+  for (std::size_t i = 0; i < m; i++) {
+    T inv = one / n2[i];
+    w[i] = c[0][i] * inv;
+    x[i] = c[1][i] * inv;
+    y[i] = c[2][i] * inv;
+    z[i] = c[3][i] * inv;
+  }
+  return zero == 0;
+}
+
+template <class T>
+bool look_at_block(const T *const forward[3], const T up[3], std::size_t i0,
+                   std::size_t m, T *const out[4]) {
+  using std::sqrt;
+  const T one = static_cast<T>(1);
+  T n[LANE_BLOCK], f[3][LANE_BLOCK], r[3][LANE_BLOCK], mask[4][LANE_BLOCK];
+  T idn[LANE_BLOCK];
+  const T *fx = forward[0] + i0, *fy = forward[1] + i0, *fz = forward[2] + i0;
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = fx[i] * fx[i] + fy[i] * fy[i] + fz[i] * fz[i];
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  std::int32_t zero = 0;
+  for (std::size_t i = 0; i < m; i++) {
+    // a zero forward looks along z here, the identity is blended in
+    // at the end, whatever the up vector
+    std::int32_t none = n[i] == static_cast<T>(0);
+    zero += none;
+    idn[i] = static_cast<T>(none);
+    T inv = one / (n[i] + static_cast<T>(none));
+    T g[3] = {fx[i] * inv, fy[i] * inv, fz[i] * inv + static_cast<T>(none)};
+    T s[3];
+    n[i] = unit_detail::look_at_side(g, up, s);
+    for (unsigned int k = 0; k < 3; k++) {
+      f[k][i] = g[k];
+      r[k][i] = s[k];
+    }
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  for (std::size_t i = 0; i < m; i++) {
+    T inv = one / n[i];
+    T g[3] = {f[0][i], f[1][i], f[2][i]};
+    T s[3] = {r[0][i] * inv, r[1][i] * inv, r[2][i] * inv};
+    T sel[4];
+    n[i] = unit_detail::look_at_radicand(g, s, sel);
+    for (unsigned int k = 0; k < 3; k++)
+      r[k][i] = s[k];
+    for (unsigned int k = 0; k < 4; k++)
+      mask[k][i] = sel[k];
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  T *w = out[0] + i0, *x = out[1] + i0, *y = out[2] + i0, *z = out[3] + i0;
+  for (std::size_t i = 0; i < m; i++) {
+    T g[3] = {f[0][i], f[1][i], f[2][i]};
+    T s[3] = {r[0][i], r[1][i], r[2][i]};
+    T sel[4] = {mask[0][i], mask[1][i], mask[2][i], mask[3][i]};
+    T c[4];
+    unit_detail::look_at_combine(g, s, sel, n[i], c);
+    w[i] = c[0] + idn[i] * (one - c[0]);
+    x[i] = c[1] - idn[i] * c[1];
+    y[i] = c[2] - idn[i] * c[2];
+    z[i] = c[3] - idn[i] * c[3];
+  }
+  return zero == 0;
+}
+
+} // namespace direction_detail
+
+/**
+  \brief shortest arcs from a[i] to b[i] for n pairs of vectors, given
+  as three arrays of coordinates each, see
+  unit_quaternion::from_two_vectors. out is resized to n. Pairs are
+  split over threads as in parallel_ranges. ARG_ERROR if a vector is
+  zero, its rotation is the identity.
+ */
+template <class T>
+QUATERNION_FLAGS from_two_vectors(const T *const a[3], const T *const b[3],
+                                  std::size_t n, quaternion_batch<T> &out,
+                                  unsigned int threads = 1) {
+  out.resize(n);
+  T *const dst[4] = {out.data(0), out.data(1), out.data(2), out.data(3)};
+  std::atomic<bool> ok(true);
+  parallel_blocks(n, threads, LANE_BLOCK,
+                  [a, b, &dst, &ok](std::size_t j, std::size_t m) {
+                    if (!direction_detail::two_vectors_block(a, b, j, m, dst))
+                      ok.store(false, std::memory_order_relaxed);
+                  });
+  return ok.load() ? SUCCESS : ARG_ERROR;
+}
+
+/**
+  \brief look at rotations for n forward directions, three arrays of
+  coordinates, sharing one up vector, see unit_quaternion::look_at.
+  out is resized to n. Directions are split over threads as in
+  parallel_ranges. ARG_ERROR if a forward is zero, its rotation is the
+  identity.
+ */
+template <class T>
+QUATERNION_FLAGS look_at(const T *const forward[3], const T up[3],
+                         std::size_t n, quaternion_batch<T> &out,
+                         unsigned int threads = 1) {
+  out.resize(n);
+  T *const dst[4] = {out.data(0), out.data(1), out.data(2), out.data(3)};
+  std::atomic<bool> ok(true);
+  parallel_blocks(n, threads, LANE_BLOCK,
+                  [forward, up, &dst, &ok](std::size_t j, std::size_t m) {
+                    if (!direction_detail::look_at_block(forward, up, j, m,
+                                                         dst))
+                      ok.store(false, std::memory_order_relaxed);
+                  });
+  return ok.load() ? SUCCESS : ARG_ERROR;
+}
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,254 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_DISTANCE_HPP
+#define QUATERNION_DISTANCE_HPP
+#include "quaternion_index.hpp"
+#include "quaternion_parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  distances between rotations p and q of unit norm, all of them
+  treat q and -q as the same rotation
+ */
+enum ROTATION_METRIC {
+  /** rotation angle \f[2 \arccos |p \cdot q|\f] in radians*/
+  METRIC_GEODESIC,
+  /** \f[\min(|p - q|, |p + q|) = \sqrt{2 - 2 |p \cdot q|}\f]*/
+  METRIC_CHORDAL,
+  /** \f[1 - |p \cdot q|\f], orders like the other two*/
+  METRIC_COSINE
+};
+
+namespace distance_detail {
+
+/** rows per block of the kernels, keeps the dots on the stack*/
+const std::size_t BLOCK = 256;
+
+/** |q . p| for the n rotations in c, at most one*/
+template <class T>
+void abs_dots(const T q[4], const T *const c[4], std::size_t n, T *out) {
+  using std::fabs;
+  const T *w = c[0];
+  const T *x = c[1];
+  const T *y = c[2];
+  const T *z = c[3];
+  for (std::size_t i = 0; i < n; i++) {
+    T d = fabs(q[0] * w[i] + q[1] * x[i] + q[2] * y[i] + q[3] * z[i]);
+    out[i] = d > static_cast<T>(1) ? static_cast<T>(1) : d;
+  }
+}
+
+/** turn |q . p| in place into the metric*/
+template <class T>
+void to_metric(ROTATION_METRIC metric, std::size_t n, T *d) {
+  using std::acos;
+  using std::sqrt;
+  // one loop per metric, the sqrt and acos loops do not mix
+  switch (metric) {
+  case METRIC_GEODESIC:
+    for (std::size_t i = 0; i < n; i++)
+      d[i] = static_cast<T>(2) * acos(d[i]);
+    break;
+  case METRIC_CHORDAL:
+    for (std::size_t i = 0; i < n; i++)
+      d[i] = sqrt(static_cast<T>(2) - static_cast<T>(2) * d[i]);
+    break;
+  case METRIC_COSINE:
+    for (std::size_t i = 0; i < n; i++)
+      d[i] = static_cast<T>(1) - d[i];
+    break;
+  }
+}
+
+/** the k rotations closest to q, sorted, angles only computed for them*/
+template <class T>
+void top_k(const T q[4], const quaternion_batch<T> &set, std::size_t k,
+           std::vector<orientation_neighbor<T>> &out) {
+  using std::acos;
+  typedef std::pair<T, std::size_t> entry;
+  // min heap on |dot|, the root is the worst of the best k
+  std::vector<entry> heap;
+  heap.reserve(k);
+  auto worse = [](const entry &a, const entry &b) { return a.first > b.first; };
+  T tau = static_cast<T>(-1);
+  T d[BLOCK];
+  const std::size_t n = set.size();
+  for (std::size_t i0 = 0; i0 < n && k > 0; i0 += BLOCK) {
+    const std::size_t m = n - i0 < BLOCK ? n - i0 : BLOCK;
+    const T *c[4] = {set.data(0) + i0, set.data(1) + i0, set.data(2) + i0,
+                     set.data(3) + i0};
+    abs_dots(q, c, m, d);
+    for (std::size_t j = 0; j < m; j++) {
+      if (!(d[j] > tau))
+        continue;
+      if (heap.size() < k) {
+        heap.push_back(entry(d[j], i0 + j));
+        std::push_heap(heap.begin(), heap.end(), worse);
+        if (heap.size() == k)
+          tau = heap.front().first;
+        continue;
+      }
+      std::pop_heap(heap.begin(), heap.end(), worse);
+      heap.back() = entry(d[j], i0 + j);
+      std::push_heap(heap.begin(), heap.end(), worse);
+      tau = heap.front().first;
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), worse);
+  out.resize(heap.size());
+  for (std::size_t j = 0; j < heap.size(); j++) {
+    out[j].index = heap[j].second;
+    out[j].angle = static_cast<T>(2) * acos(heap[j].first);
+  }
+}
+
+} // namespace distance_detail
+
+/**
+  \brief distances from q to every rotation of set, out is resized.
+
+  q is normalized, the rotations of set have to be of unit norm.
+  ARG_ERROR for a zero q.
+ */
+template <class T>
+QUATERNION_FLAGS distances(const quaternion<T> &q,
+                           const quaternion_batch<T> &set,
+                           ROTATION_METRIC metric, std::vector<T> &out) {
+  T u[4];
+  if (index_detail::unit_coefficients(q, u) != SUCCESS)
+    return ARG_ERROR;
+  out.resize(set.size());
+  const T *c[4] = {set.data(0), set.data(1), set.data(2), set.data(3)};
+  distance_detail::abs_dots(u, c, set.size(), out.data());
+  distance_detail::to_metric(metric, set.size(), out.data());
+  return SUCCESS;
+}
+
+/**
+  \brief distances between every rotation of a and every rotation of
+  b, out is resized to a.size() b.size() and row major.
+
+  Both batches have to be of unit norm. The rows are split over
+  threads, zero means one per hardware thread. Columns are walked in
+  blocks so a block of b stays in cache for all rows of a thread.
+ */
+template <class T>
+QUATERNION_FLAGS distances(const quaternion_batch<T> &a,
+                           const quaternion_batch<T> &b,
+                           ROTATION_METRIC metric, std::vector<T> &out,
+                           unsigned int threads = 1) {
+  const std::size_t nb = b.size();
+  out.resize(a.size() * nb);
+  T *dst = out.data();
+  parallel_ranges(
+      a.size(), threads, [&a, &b, metric, nb, dst](std::size_t r0,
+                                                    std::size_t r1) {
+        const std::size_t B = 4 * distance_detail::BLOCK;
+        for (std::size_t j0 = 0; j0 < nb; j0 += B) {
+          const std::size_t m = nb - j0 < B ? nb - j0 : B;
+          const T *c[4] = {b.data(0) + j0, b.data(1) + j0, b.data(2) + j0,
+                           b.data(3) + j0};
+          for (std::size_t i = r0; i < r1; i++) {
+            T q[4] = {a.data(0)[i], a.data(1)[i], a.data(2)[i], a.data(3)[i]};
+            distance_detail::abs_dots(q, c, m, dst + i * nb + j0);
+            distance_detail::to_metric(metric, m, dst + i * nb + j0);
+          }
+        }
+      });
+  return SUCCESS;
+}
+
+/**
+  \brief the k rotations of set closest to q, closest first.
+
+  The scan only compares |p . q| against the k-th best so far,
+  rejected candidates never get an angle, acos runs k times at the
+  end. Fewer than k results if set is smaller. q is normalized, set
+  has to be of unit norm, ARG_ERROR for a zero q.
+ */
+template <class T>
+QUATERNION_FLAGS nearest_k(const quaternion<T> &q,
+                           const quaternion_batch<T> &set, std::size_t k,
+                           std::vector<orientation_neighbor<T>> &out) {
+  T u[4];
+  if (index_detail::unit_coefficients(q, u) != SUCCESS)
+    return ARG_ERROR;
+  distance_detail::top_k(u, set, k, out);
+  return SUCCESS;
+}
+
+/**
+  nearest_k for every rotation of queries, out[i] holds the result of
+  query i. Queries are split over threads, zero means one per hardware
+  thread. ARG_ERROR if one of the queries is zero, its result is
+  empty.
+ */
+template <class T>
+QUATERNION_FLAGS
+nearest_k(const quaternion_batch<T> &queries, const quaternion_batch<T> &set,
+          std::size_t k,
+          std::vector<std::vector<orientation_neighbor<T>>> &out,
+          unsigned int threads = 1) {
+  out.resize(queries.size());
+  std::vector<char> failed(queries.size(), 0);
+  parallel_ranges(
+      queries.size(), threads,
+      [&queries, &set, k, &out, &failed](std::size_t r0, std::size_t r1) {
+        for (std::size_t i = r0; i < r1; i++) {
+          quaternion<T> q(queries.data(0)[i], queries.data(1)[i],
+                          queries.data(2)[i], queries.data(3)[i]);
+          if (nearest_k(q, set, k, out[i]) != SUCCESS) {
+            out[i].clear();
+            failed[i] = 1;
+          }
+        }
+      });
+  for (std::size_t i = 0; i < failed.size(); i++)
+    if (failed[i])
+      return ARG_ERROR;
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
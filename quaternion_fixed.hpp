@@ -0,0 +1,277 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_FIXED_HPP
+#define QUATERNION_FIXED_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+
+namespace quat11 {
+
+/**
+  \brief Q1.30 signed fixed point number.
+
+  Values live in [-2, 2) with a resolution of 2^-30. Every
+  operation is done with integer arithmetic only, so the results
+  are bit identical on every platform, which is what lockstep
+  simulations need. Addition and subtraction wrap around, products
+  and quotients are computed in 64 bits and rounded once.
+ */
+struct q1_30 {
+  std::int32_t raw;
+
+  q1_30() : raw(0) {}
+  explicit q1_30(int v)
+      : raw(static_cast<std::int32_t>(static_cast<std::int64_t>(v) * ONE)) {}
+  explicit q1_30(double v)
+      : raw(static_cast<std::int32_t>(
+            std::llround(v * static_cast<double>(ONE)))) {}
+
+  static q1_30 from_raw(std::int32_t r) {
+    q1_30 q;
+    q.raw = r;
+    return q;
+  }
+  double to_double() const {
+    return static_cast<double>(raw) / static_cast<double>(ONE);
+  }
+
+  static const std::int64_t ONE = static_cast<std::int64_t>(1) << 30;
+  static const unsigned int FRAC_BITS = 30;
+};
+
+namespace fixed_detail {
+
+/** two's complement wrap of a 64 bit value into 32 bits*/
+inline std::int32_t wrap32(std::uint64_t v) {
+  return static_cast<std::int32_t>(static_cast<std::uint32_t>(v));
+}
+
+/** round a Q60 accumulator back to Q30*/
+inline std::int32_t round_q60(std::uint64_t acc) {
+  std::int64_t v = static_cast<std::int64_t>(acc);
+  return wrap32(static_cast<std::uint64_t>(
+      (v + (static_cast<std::int64_t>(1) << 29)) >> 30));
+}
+
+/** Q30 x Q30 -> Q60 product as an unsigned accumulator term*/
+inline std::uint64_t mul_q60(std::int32_t a, std::int32_t b) {
+  return static_cast<std::uint64_t>(static_cast<std::int64_t>(a) *
+                                    static_cast<std::int64_t>(b));
+}
+
+/** floor of square root of a 64 bit unsigned integer, digit by digit*/
+inline std::uint64_t isqrt64(std::uint64_t v) {
+  std::uint64_t res = 0;
+  std::uint64_t bit = static_cast<std::uint64_t>(1) << 62;
+  while (bit > v)
+    bit >>= 2;
+  while (bit != 0) {
+    if (v >= res + bit) {
+      v -= res + bit;
+      res = (res >> 1) + bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+/** 1 / sqrt(v) in Q30 for a positive v in Q60*/
+inline std::int64_t rsqrt_q60(std::uint64_t v) {
+  std::int64_t n = static_cast<std::int64_t>(isqrt64(v));
+  return ((static_cast<std::int64_t>(1) << 60) + n / 2) / n;
+}
+
+} // namespace fixed_detail
+
+inline q1_30 operator+(q1_30 a, q1_30 b) {
+  return q1_30::from_raw(fixed_detail::wrap32(
+      static_cast<std::uint64_t>(static_cast<std::uint32_t>(a.raw)) +
+      static_cast<std::uint32_t>(b.raw)));
+}
+inline q1_30 operator-(q1_30 a, q1_30 b) {
+  return q1_30::from_raw(fixed_detail::wrap32(
+      static_cast<std::uint64_t>(static_cast<std::uint32_t>(a.raw)) -
+      static_cast<std::uint32_t>(b.raw)));
+}
+inline q1_30 operator-(q1_30 a) { return q1_30() - a; }
+inline q1_30 operator*(q1_30 a, q1_30 b) {
+  return q1_30::from_raw(
+      fixed_detail::round_q60(fixed_detail::mul_q60(a.raw, b.raw)));
+}
+/** division by zero saturates towards the sign of the dividend*/
+inline q1_30 operator/(q1_30 a, q1_30 b) {
+  if (b.raw == 0)
+    return q1_30::from_raw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+  std::int64_t n = static_cast<std::int64_t>(a.raw) * q1_30::ONE;
+  return q1_30::from_raw(fixed_detail::wrap32(
+      static_cast<std::uint64_t>(n / static_cast<std::int64_t>(b.raw))));
+}
+inline q1_30 &operator+=(q1_30 &a, q1_30 b) { return a = a + b; }
+inline q1_30 &operator-=(q1_30 &a, q1_30 b) { return a = a - b; }
+inline q1_30 &operator*=(q1_30 &a, q1_30 b) { return a = a * b; }
+inline q1_30 &operator/=(q1_30 &a, q1_30 b) { return a = a / b; }
+
+inline bool operator==(q1_30 a, q1_30 b) { return a.raw == b.raw; }
+inline bool operator!=(q1_30 a, q1_30 b) { return a.raw != b.raw; }
+inline bool operator<(q1_30 a, q1_30 b) { return a.raw < b.raw; }
+inline bool operator>(q1_30 a, q1_30 b) { return a.raw > b.raw; }
+inline bool operator<=(q1_30 a, q1_30 b) { return a.raw <= b.raw; }
+inline bool operator>=(q1_30 a, q1_30 b) { return a.raw >= b.raw; }
+inline bool operator==(q1_30 a, int b) { return a == q1_30(b); }
+inline bool operator!=(q1_30 a, int b) { return a != q1_30(b); }
+
+/** square root, negative values give 0*/
+inline q1_30 sqrt(q1_30 a) {
+  if (a.raw <= 0)
+    return q1_30();
+  std::uint64_t v = static_cast<std::uint64_t>(a.raw) << 30;
+  return q1_30::from_raw(
+      static_cast<std::int32_t>(fixed_detail::isqrt64(v)));
+}
+/** reciprocal square root, saturates when the result does not fit*/
+inline q1_30 rsqrt(q1_30 a) {
+  if (a.raw <= 0)
+    return q1_30::from_raw(INT32_MAX);
+  std::uint64_t v = static_cast<std::uint64_t>(a.raw) << 30;
+  std::int64_t r = fixed_detail::rsqrt_q60(v);
+  if (r > INT32_MAX)
+    return q1_30::from_raw(INT32_MAX);
+  return q1_30::from_raw(static_cast<std::int32_t>(r));
+}
+
+inline std::ostream &operator<<(std::ostream &out, q1_30 a) {
+  out << a.to_double();
+  return out;
+}
+
+/**
+  Hamilton product with a single rounding per component. The four
+  partial products are accumulated in 64 bits with wrap around so
+  the result is exact whenever it is representable.
+ */
+template <>
+inline void quaternion<q1_30>::hamilton_kernel(const q1_30 a[4],
+                                               const q1_30 b[4],
+                                               q1_30 out[4]) noexcept {
+  using fixed_detail::mul_q60;
+  using fixed_detail::round_q60;
+  std::uint64_t s = mul_q60(a[0].raw, b[0].raw) - mul_q60(a[1].raw, b[1].raw) -
+                    mul_q60(a[2].raw, b[2].raw) - mul_q60(a[3].raw, b[3].raw);
+  std::uint64_t x = mul_q60(a[0].raw, b[1].raw) + mul_q60(a[1].raw, b[0].raw) +
+                    mul_q60(a[2].raw, b[3].raw) - mul_q60(a[3].raw, b[2].raw);
+  std::uint64_t y = mul_q60(a[0].raw, b[2].raw) - mul_q60(a[1].raw, b[3].raw) +
+                    mul_q60(a[2].raw, b[0].raw) + mul_q60(a[3].raw, b[1].raw);
+  std::uint64_t z = mul_q60(a[0].raw, b[3].raw) + mul_q60(a[1].raw, b[2].raw) -
+                    mul_q60(a[2].raw, b[1].raw) + mul_q60(a[3].raw, b[0].raw);
+  out[0] = q1_30::from_raw(round_q60(s));
+  out[1] = q1_30::from_raw(round_q60(x));
+  out[2] = q1_30::from_raw(round_q60(y));
+  out[3] = q1_30::from_raw(round_q60(z));
+}
+
+/**
+  Normalization with an integer reciprocal square root. Small
+  quaternions are scaled up by powers of two first so that the
+  reciprocal always fits in Q1.30. The zero quaternion can not be
+  normalized and gives ARG_ERROR.
+ */
+template <>
+inline QUATERNION_FLAGS
+quaternion<q1_30>::normalized(quaternion<q1_30> &out) const {
+  QUATERNION_COUNT(OP_NORMALIZED);
+  using fixed_detail::mul_q60;
+  q1_30 c[4];
+  auto res = scalar(c[0]);
+  if (res != SUCCESS)
+    return QUATERNION_COUNT_RESULT(res);
+  res = vector(c + 1);
+  if (res != SUCCESS)
+    return QUATERNION_COUNT_RESULT(res);
+
+  // a square is up to 2^62 in Q60, four of them reach 2^64. Sum them
+  // in Q58 with the two bits shifted out kept apart, then go back to
+  // Q60 unless the squared norm is 16.
+  std::uint64_t d = 0, low = 0;
+  for (unsigned int i = 0; i < 4; i++) {
+    std::uint64_t s = mul_q60(c[i].raw, c[i].raw);
+    d += s >> 2;
+    low += s & 3;
+  }
+  d += low >> 2;
+  low &= 3;
+  if (d == 0 && low == 0)
+    return QUATERNION_COUNT_RESULT(ARG_ERROR);
+
+  unsigned int shift = 0;
+  std::int64_t r;
+  if (d >= static_cast<std::uint64_t>(1) << 62) {
+    // 1 / sqrt in Q30 of a Q58 value
+    std::int64_t n = static_cast<std::int64_t>(fixed_detail::isqrt64(d));
+    r = ((static_cast<std::int64_t>(1) << 59) + n / 2) / n;
+  } else {
+    d = (d << 2) | low;
+    // scale by 2^shift until the squared norm is at least 0.5
+    const std::uint64_t half = static_cast<std::uint64_t>(1) << 59;
+    while (d < half) {
+      d <<= 2;
+      shift++;
+    }
+    r = fixed_detail::rsqrt_q60(d);
+  }
+  q1_30 n[4];
+  for (unsigned int i = 0; i < 4; i++) {
+    std::int64_t ci = static_cast<std::int64_t>(c[i].raw) *
+                      (static_cast<std::int64_t>(1) << shift);
+    std::uint64_t p = static_cast<std::uint64_t>(ci * r);
+    n[i] = q1_30::from_raw(fixed_detail::round_q60(p));
+  }
+  out = quaternion<q1_30>(n);
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
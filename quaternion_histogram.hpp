@@ -0,0 +1,276 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_HISTOGRAM_HPP
+#define QUATERNION_HISTOGRAM_HPP
+#include "quaternion_batch.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  \brief Near uniform grid of bins over the rotations.
+
+  A rotation q ~ -q is sent to the cell of the tesseract its largest
+  coefficient c points at, the other three coefficients over q_c are
+  in [-1, 1]. Each of them is warped by
+  \f[u = a (1.5 - 0.5 |a|)\f]
+  and cut into n slices, so there are 4 n^3 bins. Without the warp
+  the bins near the cell corners would be ten times smaller than in
+  the middle, with it the largest bin is about 1.6 times the
+  smallest. The mapping needs neither normalization nor
+  trigonometric functions, only a division.
+ */
+template <class T> class so3_grid {
+public:
+  /** largest n for which bin indices fit 32 bits*/
+  static const unsigned int MAX_RESOLUTION = 1023;
+
+  so3_grid() : n(1) {}
+
+  /** n slices per cell axis, ARG_ERROR unless 1 <= n <= MAX_RESOLUTION*/
+  static QUATERNION_FLAGS from_resolution(unsigned int n, so3_grid &out) {
+    if (n == 0 || n > MAX_RESOLUTION)
+      return ARG_ERROR;
+    out.n = n;
+    return SUCCESS;
+  }
+
+  unsigned int resolution() const { return n; }
+  std::size_t size() const {
+    return 4 * static_cast<std::size_t>(n) * n * n;
+  }
+
+  /** bin of q, ARG_ERROR for the zero quaternion*/
+  QUATERNION_FLAGS bin(const quaternion<T> &q, std::uint32_t &out) const {
+    T c[4];
+    q.scalar(c[0]);
+    q.vector(c + 1);
+    return bin(c, c + 1, c + 2, c + 3, 1, &out);
+  }
+  /**
+    bins of a whole batch into out, which is resized. Zero quaternions
+    get the bin size() and make it return ARG_ERROR.
+   */
+  QUATERNION_FLAGS bin(const quaternion_batch<T> &b,
+                       std::vector<std::uint32_t> &out) const {
+    out.resize(b.size());
+    return bin(b.data(0), b.data(1), b.data(2), b.data(3), b.size(),
+               out.data());
+  }
+  /** bins of count rotations given as component arrays*/
+  QUATERNION_FLAGS bin(const T *w, const T *x, const T *y, const T *z,
+                       std::size_t count, std::uint32_t *out) const {
+    using std::fabs;
+    // 32 bit indices and blends only, so the loop vectorizes. Slices
+    // are signed for the float conversion, the bin is unsigned as 4 n^3
+    // passes 2^31 for n > 812
+    const T fn = static_cast<T>(n);
+    const std::int32_t last = static_cast<std::int32_t>(n) - 1;
+    const std::uint32_t n1 = n;
+    const std::uint32_t n2 = n1 * n1;
+    const std::uint32_t n3 = n2 * n1;
+    const std::uint32_t zero_bin = static_cast<std::uint32_t>(size());
+    std::int32_t zeros = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      T aw = fabs(w[i]), ax = fabs(x[i]), ay = fabs(y[i]), az = fabs(z[i]);
+      // largest coefficient and the three others in order. The cell
+      // is summed from the comparisons, a chain of selects on it gets
+      // threaded into branches
+      std::int32_t g1 = ax > aw;
+      T am = g1 ? ax : aw;
+      std::int32_t g2 = ay > am;
+      am = g2 ? ay : am;
+      std::int32_t g3 = az > am;
+      // below2: c <= 2, below1: c <= 1, below0: c == 0
+      std::int32_t below2 = 1 - g3;
+      std::int32_t below1 = below2 * (1 - g2);
+      std::int32_t below0 = below1 * (1 - g1);
+      std::int32_t c = 3 - below2 - below1 - below0;
+      T m = w[i] + static_cast<T>(g1) * (x[i] - w[i]);
+      m = m + static_cast<T>(g2) * (y[i] - m);
+      m = m + static_cast<T>(g3) * (z[i] - m);
+      T l0 = static_cast<T>(below0), l1 = static_cast<T>(below1),
+        l2 = static_cast<T>(below2);
+      T o0 = w[i] + l0 * (x[i] - w[i]);
+      T o1 = x[i] + l1 * (y[i] - x[i]);
+      T o2 = y[i] + l2 * (z[i] - y[i]);
+      // blends instead of selects for the zero case, or the compiler
+      // moves the division into a branch
+      std::int32_t is_zero = m == static_cast<T>(0);
+      zeros |= is_zero;
+      T inv = static_cast<T>(1) / (m + static_cast<T>(is_zero));
+      std::int32_t k0 = slice(o0 * inv, fn, last);
+      std::int32_t k1 = slice(o1 * inv, fn, last);
+      std::int32_t k2 = slice(o2 * inv, fn, last);
+      std::uint32_t b = static_cast<std::uint32_t>(c) * n3 +
+                        static_cast<std::uint32_t>(k0) * n2 +
+                        static_cast<std::uint32_t>(k1) * n1 +
+                        static_cast<std::uint32_t>(k2);
+      // modular, gives zero_bin for is_zero
+      out[i] = b + static_cast<std::uint32_t>(is_zero) * (zero_bin - b);
+    }
+    return zeros ? ARG_ERROR : SUCCESS;
+  }
+
+  /** unit quaternion at the center of bin, INDEX_ERROR past size()*/
+  QUATERNION_FLAGS center(std::uint32_t b, quaternion<T> &out) const {
+    using std::sqrt;
+    if (b >= size())
+      return INDEX_ERROR;
+    const std::uint32_t n2 = n * n;
+    const std::uint32_t n3 = n2 * n;
+    std::uint32_t c = b / n3;
+    std::uint32_t k[3] = {(b / n2) % n, (b / n) % n, b % n};
+    T o[3];
+    for (unsigned int j = 0; j < 3; j++) {
+      // invert the warp at the middle of the slice
+      T u = (static_cast<T>(2) * (static_cast<T>(k[j]) + static_cast<T>(0.5)) /
+             static_cast<T>(n)) -
+            static_cast<T>(1);
+      T au = u < static_cast<T>(0) ? -u : u;
+      T a = static_cast<T>(1.5) -
+            sqrt(static_cast<T>(2.25) - static_cast<T>(2) * au);
+      o[j] = u < static_cast<T>(0) ? -a : a;
+    }
+    T q[4];
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < 4; i++)
+      q[i] = i == c ? static_cast<T>(1) : o[j++];
+    T inv = static_cast<T>(1) /
+            sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    out = quaternion<T>(q[0] * inv, q[1] * inv, q[2] * inv, q[3] * inv);
+    return SUCCESS;
+  }
+
+private:
+  static std::int32_t slice(T a, T fn, std::int32_t last) {
+    using std::fabs;
+    T u = a * (static_cast<T>(1.5) - static_cast<T>(0.5) * fabs(a));
+    T s = (u + static_cast<T>(1)) * static_cast<T>(0.5) * fn;
+    std::int32_t k = static_cast<std::int32_t>(s);
+    k = k < 0 ? 0 : k;
+    return k > last ? last : k;
+  }
+
+  unsigned int n;
+};
+
+/**
+  \brief Histogram shared by many threads.
+
+  Threads count into their own so3_histogram and merge it with
+  so3_histogram::merge_into, which only does relaxed atomic adds, so
+  merging never takes a lock and never blocks other threads.
+ */
+class shared_so3_histogram {
+public:
+  explicit shared_so3_histogram(std::size_t bins) : counts(bins) {
+    for (std::size_t i = 0; i < bins; i++)
+      counts[i].store(0, std::memory_order_relaxed);
+  }
+  std::size_t size() const { return counts.size(); }
+  void add(std::size_t b, std::uint64_t count) {
+    counts[b].fetch_add(count, std::memory_order_relaxed);
+  }
+  std::uint64_t count(std::size_t b) const {
+    return counts[b].load(std::memory_order_relaxed);
+  }
+  /** copy of all counts, exact once the merging threads are joined*/
+  void snapshot(std::vector<std::uint64_t> &out) const {
+    out.resize(counts.size());
+    for (std::size_t i = 0; i < counts.size(); i++)
+      out[i] = counts[i].load(std::memory_order_relaxed);
+  }
+
+private:
+  std::vector<std::atomic<std::uint64_t>> counts;
+};
+
+/** \brief Histogram owned by one thread.*/
+class so3_histogram {
+public:
+  explicit so3_histogram(std::size_t bins) : counts(bins, 0) {}
+
+  std::size_t size() const { return counts.size(); }
+  const std::vector<std::uint64_t> &values() const { return counts; }
+
+  /**
+    bin and count a whole batch, block by block so the bin indices
+    never leave the cache. Zero quaternions are skipped and make it
+    return ARG_ERROR, SIZE_ERROR if the grid has another size.
+   */
+  template <class T>
+  QUATERNION_FLAGS add(const so3_grid<T> &grid, const quaternion_batch<T> &b) {
+    if (grid.size() != counts.size())
+      return SIZE_ERROR;
+    const std::size_t B = 256;
+    std::uint32_t bins[B];
+    QUATERNION_FLAGS res = SUCCESS;
+    for (std::size_t i0 = 0; i0 < b.size(); i0 += B) {
+      const std::size_t m = b.size() - i0 < B ? b.size() - i0 : B;
+      if (grid.bin(b.data(0) + i0, b.data(1) + i0, b.data(2) + i0,
+                   b.data(3) + i0, m, bins) != SUCCESS)
+        res = ARG_ERROR;
+      for (std::size_t j = 0; j < m; j++)
+        if (bins[j] < counts.size())
+          counts[bins[j]]++;
+    }
+    return res;
+  }
+  /** add the counts to total and clear them, SIZE_ERROR on mismatch*/
+  QUATERNION_FLAGS merge_into(shared_so3_histogram &total) {
+    if (total.size() != counts.size())
+      return SIZE_ERROR;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+      if (counts[i] != 0)
+        total.add(i, counts[i]);
+      counts[i] = 0;
+    }
+    return SUCCESS;
+  }
+
+private:
+  std::vector<std::uint64_t> counts;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,417 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_IMU_HPP
+#define QUATERNION_IMU_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include <cmath>
+#include <cstdint>
+
+namespace quat11 {
+
+/**
+  \brief Madgwick orientation filter for a gyroscope and an
+  accelerometer.
+
+  The orientation is integrated from the angular rate and pulled
+  towards the attitude the measured gravity implies by one gradient
+  descent step of size beta per update, Madgwick 2010 - An efficient
+  orientation filter for inertial and inertial/magnetic sensor arrays.
+  q rotates the sensor frame into the earth frame, whose z axis
+  points up.
+ */
+template <class T> class madgwick_filter {
+public:
+  explicit madgwick_filter(T beta = static_cast<T>(0.1))
+      : q(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+          static_cast<T>(0)),
+        beta(beta) {}
+
+  const quaternion<T> &orientation() const { return q; }
+  /** q is normalized, ARG_ERROR if it is zero*/
+  QUATERNION_FLAGS set_orientation(const quaternion<T> &p) {
+    return p.normalized(q);
+  }
+
+  /**
+    one step of dt seconds with gyro in rad/s and accel in any unit,
+    a zero accel only integrates the rate
+   */
+  QUATERNION_FLAGS update(const T gyro[3], const T accel[3], T dt) {
+    using std::sqrt;
+    const T half = static_cast<T>(0.5);
+    quaternion<T> rate;
+    auto res = q.hamilton_product(
+        quaternion<T>(static_cast<T>(0), gyro[0], gyro[1], gyro[2]), rate);
+    if (res != SUCCESS)
+      return res;
+    T d[4];
+    rate.scalar(d[0]);
+    rate.vector(d + 1);
+    T a2 = accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2];
+    T s[4] = {static_cast<T>(0), static_cast<T>(0), static_cast<T>(0),
+              static_cast<T>(0)};
+    if (a2 != static_cast<T>(0)) {
+      T c[4];
+      q.scalar(c[0]);
+      q.vector(c + 1);
+      T ra = static_cast<T>(1) / sqrt(a2);
+      T a[3] = {accel[0] * ra, accel[1] * ra, accel[2] * ra};
+      gradient(c, a, s);
+      T s2 = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3];
+      if (s2 != static_cast<T>(0)) {
+        T rs = static_cast<T>(1) / sqrt(s2);
+        for (unsigned int k = 0; k < 4; k++)
+          s[k] *= rs;
+      }
+    }
+    quaternion<T> step(half * d[0] - beta * s[0], half * d[1] - beta * s[1],
+                       half * d[2] - beta * s[2], half * d[3] - beta * s[3]);
+    quaternion<T> next;
+    step.product(dt, step);
+    q.add(step, next);
+    return next.normalized(q);
+  }
+
+  /**
+    gradient of \f[|q^* (0, 0, 0, 1) q - a|^2\f] with respect to q
+    for a unit q and a unit a, Madgwick 2010 eq. 25 and 26
+   */
+  static void gradient(const T c[4], const T a[3], T s[4]) {
+    const T two = static_cast<T>(2);
+    const T four = static_cast<T>(4);
+    const T eight = static_cast<T>(8);
+    T q0q0 = c[0] * c[0], q1q1 = c[1] * c[1], q2q2 = c[2] * c[2],
+      q3q3 = c[3] * c[3];
+    s[0] = four * c[0] * q2q2 + two * c[2] * a[0] + four * c[0] * q1q1 -
+           two * c[1] * a[1];
+    s[1] = four * c[1] * q3q3 - two * c[3] * a[0] + four * q0q0 * c[1] -
+           two * c[0] * a[1] - four * c[1] + eight * c[1] * q1q1 +
+           eight * c[1] * q2q2 + four * c[1] * a[2];
+    s[2] = four * q0q0 * c[2] + two * c[0] * a[0] + four * c[2] * q3q3 -
+           two * c[3] * a[1] - four * c[2] + eight * c[2] * q1q1 +
+           eight * c[2] * q2q2 + four * c[2] * a[2];
+    s[3] = four * q1q1 * c[3] - two * c[1] * a[0] + four * q2q2 * c[3] -
+           two * c[2] * a[1];
+  }
+
+private:
+  quaternion<T> q;
+  T beta;
+};
+
+/**
+  \brief Mahony complementary filter for a gyroscope and an
+  accelerometer.
+
+  The cross product of measured and estimated gravity is fed back
+  into the rate through a proportional gain kp and an integral gain
+  ki, the integral learns the gyroscope bias, Mahony, Hamel and
+  Pflimlin 2008 - Nonlinear complementary filters on the special
+  orthogonal group. Same frames as madgwick_filter.
+ */
+template <class T> class mahony_filter {
+public:
+  explicit mahony_filter(T kp = static_cast<T>(1), T ki = static_cast<T>(0))
+      : q(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+          static_cast<T>(0)),
+        kp(kp), ki(ki), integral{static_cast<T>(0), static_cast<T>(0),
+                                 static_cast<T>(0)} {}
+
+  const quaternion<T> &orientation() const { return q; }
+  QUATERNION_FLAGS set_orientation(const quaternion<T> &p) {
+    return p.normalized(q);
+  }
+  /** current estimate of the gyroscope bias, with the opposite sign*/
+  void bias_correction(T out[3]) const {
+    out[0] = integral[0];
+    out[1] = integral[1];
+    out[2] = integral[2];
+  }
+
+  /** one step, see madgwick_filter::update*/
+  QUATERNION_FLAGS update(const T gyro[3], const T accel[3], T dt) {
+    using std::sqrt;
+    T g[3] = {gyro[0], gyro[1], gyro[2]};
+    T a2 = accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2];
+    if (a2 != static_cast<T>(0)) {
+      T c[4];
+      q.scalar(c[0]);
+      q.vector(c + 1);
+      T ra = static_cast<T>(1) / sqrt(a2);
+      T a[3] = {accel[0] * ra, accel[1] * ra, accel[2] * ra};
+      // half the estimated gravity in the sensor frame
+      T v[3] = {c[1] * c[3] - c[0] * c[2], c[0] * c[1] + c[2] * c[3],
+                c[0] * c[0] - static_cast<T>(0.5) + c[3] * c[3]};
+      T e[3] = {a[1] * v[2] - a[2] * v[1], a[2] * v[0] - a[0] * v[2],
+                a[0] * v[1] - a[1] * v[0]};
+      for (unsigned int k = 0; k < 3; k++) {
+        integral[k] += static_cast<T>(2) * ki * e[k] * dt;
+        g[k] += integral[k] + static_cast<T>(2) * kp * e[k];
+      }
+    }
+    quaternion<T> rate;
+    auto res = q.hamilton_product(
+        quaternion<T>(static_cast<T>(0), g[0], g[1], g[2]), rate);
+    if (res != SUCCESS)
+      return res;
+    quaternion<T> next;
+    rate.product(static_cast<T>(0.5) * dt, rate);
+    q.add(rate, next);
+    return next.normalized(q);
+  }
+
+private:
+  quaternion<T> q;
+  T kp;
+  T ki;
+  T integral[3];
+};
+
+/**
+  \brief n Madgwick filters updated together.
+
+  Orientations are kept as structure of arrays and one update runs
+  every filter through the same steps, lane by lane. Each step is a
+  separate loop over a block of lanes. The square roots get their
+  own loops, whose errno path keeps them scalar, and zero
+  measurements are blended instead of branched on, so every other
+  loop vectorizes. Lanes can be split over threads.
+
+  update starts and joins its threads on every call, which takes tens
+  of microseconds, about as long as one thread needs for a few
+  thousand lanes. Threads only help from about a hundred thousand
+  filters. For fewer filters at a high rate keep threads at 1, or give
+  each long running thread of your own a batch of its filters.
+ */
+template <class T> class madgwick_batch {
+public:
+  explicit madgwick_batch(std::size_t n, T beta = static_cast<T>(0.1))
+      : q(n), beta(beta) {
+    for (std::size_t i = 0; i < n; i++)
+      q.data(0)[i] = static_cast<T>(1);
+  }
+
+  std::size_t size() const { return q.size(); }
+  const quaternion_batch<T> &orientations() const { return q; }
+  /** INDEX_ERROR past size(), ARG_ERROR for a zero p*/
+  QUATERNION_FLAGS set_orientation(std::size_t i, const quaternion<T> &p) {
+    quaternion<T> n;
+    auto res = p.normalized(n);
+    if (res != SUCCESS)
+      return res;
+    return q.set(i, n);
+  }
+
+  /**
+    one step of dt seconds for every filter, gyro and accel hold three
+    arrays of size() values each, threads as in parallel_ranges
+   */
+  QUATERNION_FLAGS update(const T *const gyro[3], const T *const accel[3],
+                          T dt, unsigned int threads = 1) {
+    parallel_blocks(size(), threads, LANE_BLOCK,
+                    [this, gyro, accel, dt](std::size_t b, std::size_t m) {
+                      block(b, m, gyro, accel, dt);
+                    });
+    return SUCCESS;
+  }
+
+private:
+  void block(std::size_t i0, std::size_t m, const T *const gyro[3],
+             const T *const accel[3], T dt) {
+    using std::sqrt;
+    const std::size_t B = LANE_BLOCK;
+    const T one = static_cast<T>(1);
+    const T half = static_cast<T>(0.5);
+    T *w = q.data(0) + i0, *x = q.data(1) + i0, *y = q.data(2) + i0,
+      *z = q.data(3) + i0;
+    const T *gx = gyro[0] + i0, *gy = gyro[1] + i0, *gz = gyro[2] + i0;
+    const T *ax = accel[0] + i0, *ay = accel[1] + i0, *az = accel[2] + i0;
+    T n2[B], r[B], on[B];
+    T t[4][B], s[4][B];
+    for (std::size_t i = 0; i < m; i++)
+      n2[i] = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+    for (std::size_t i = 0; i < m; i++)
+      r[i] = sqrt(n2[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      // zero accel: no correction, and no division by zero either
+      std::int32_t zero = n2[i] == static_cast<T>(0);
+      on[i] = static_cast<T>(1 - zero);
+      T ra = one / (r[i] + static_cast<T>(zero));
+      T c[4] = {w[i], x[i], y[i], z[i]};
+      T a[3] = {ax[i] * ra, ay[i] * ra, az[i] * ra};
+      T g[4];
+      madgwick_filter<T>::gradient(c, a, g);
+      for (unsigned int k = 0; k < 4; k++)
+        s[k][i] = g[k];
+      n2[i] = g[0] * g[0] + g[1] * g[1] + g[2] * g[2] + g[3] * g[3];
+    }
+    for (std::size_t i = 0; i < m; i++)
+      r[i] = sqrt(n2[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      std::int32_t zero = n2[i] == static_cast<T>(0);
+      T rs = beta * on[i] / (r[i] + static_cast<T>(zero));
+      // q (0, g) / 2 minus the normalized gradient step
+      T d0 = half * -(x[i] * gx[i] + y[i] * gy[i] + z[i] * gz[i]);
+      T d1 = half * (w[i] * gx[i] + y[i] * gz[i] - z[i] * gy[i]);
+      T d2 = half * (w[i] * gy[i] + z[i] * gx[i] - x[i] * gz[i]);
+      T d3 = half * (w[i] * gz[i] + x[i] * gy[i] - y[i] * gx[i]);
+      t[0][i] = w[i] + (d0 - rs * s[0][i]) * dt;
+      t[1][i] = x[i] + (d1 - rs * s[1][i]) * dt;
+      t[2][i] = y[i] + (d2 - rs * s[2][i]) * dt;
+      t[3][i] = z[i] + (d3 - rs * s[3][i]) * dt;
+      n2[i] = t[0][i] * t[0][i] + t[1][i] * t[1][i] + t[2][i] * t[2][i] +
+              t[3][i] * t[3][i];
+    }
+    for (std::size_t i = 0; i < m; i++)
+      r[i] = sqrt(n2[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      T inv = one / r[i];
+      w[i] = t[0][i] * inv;
+      x[i] = t[1][i] * inv;
+      y[i] = t[2][i] * inv;
+      z[i] = t[3][i] * inv;
+    }
+  }
+
+  quaternion_batch<T> q;
+  T beta;
+};
+
+/**
+  \brief n Mahony filters updated together, laid out like
+  madgwick_batch.
+ */
+template <class T> class mahony_batch {
+public:
+  explicit mahony_batch(std::size_t n, T kp = static_cast<T>(1),
+                        T ki = static_cast<T>(0))
+      : q(n), integral{std::vector<T>(n), std::vector<T>(n),
+                       std::vector<T>(n)},
+        kp(kp), ki(ki) {
+    for (std::size_t i = 0; i < n; i++)
+      q.data(0)[i] = static_cast<T>(1);
+  }
+
+  std::size_t size() const { return q.size(); }
+  const quaternion_batch<T> &orientations() const { return q; }
+  QUATERNION_FLAGS set_orientation(std::size_t i, const quaternion<T> &p) {
+    quaternion<T> n;
+    auto res = p.normalized(n);
+    if (res != SUCCESS)
+      return res;
+    return q.set(i, n);
+  }
+
+  /** see madgwick_batch::update and its note on threads*/
+  QUATERNION_FLAGS update(const T *const gyro[3], const T *const accel[3],
+                          T dt, unsigned int threads = 1) {
+    parallel_blocks(size(), threads, LANE_BLOCK,
+                    [this, gyro, accel, dt](std::size_t b, std::size_t m) {
+                      block(b, m, gyro, accel, dt);
+                    });
+    return SUCCESS;
+  }
+
+private:
+  void block(std::size_t i0, std::size_t m, const T *const gyro[3],
+             const T *const accel[3], T dt) {
+    using std::sqrt;
+    const std::size_t B = LANE_BLOCK;
+    const T one = static_cast<T>(1);
+    const T half = static_cast<T>(0.5);
+    const T two_kp = static_cast<T>(2) * kp;
+    const T two_ki_dt = static_cast<T>(2) * ki * dt;
+    const T h = half * dt;
+    T *w = q.data(0) + i0, *x = q.data(1) + i0, *y = q.data(2) + i0,
+      *z = q.data(3) + i0;
+    T *ix = integral[0].data() + i0, *iy = integral[1].data() + i0,
+      *iz = integral[2].data() + i0;
+    const T *gx = gyro[0] + i0, *gy = gyro[1] + i0, *gz = gyro[2] + i0;
+    const T *ax = accel[0] + i0, *ay = accel[1] + i0, *az = accel[2] + i0;
+    T n2[B], r[B];
+    T t[4][B];
+    for (std::size_t i = 0; i < m; i++)
+      n2[i] = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+    for (std::size_t i = 0; i < m; i++)
+      r[i] = sqrt(n2[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      std::int32_t zero = n2[i] == static_cast<T>(0);
+      // a zero accel gives no error and no integral feedback
+      T on = static_cast<T>(1 - zero);
+      T ra = on / (r[i] + static_cast<T>(zero));
+      T a0 = ax[i] * ra, a1 = ay[i] * ra, a2 = az[i] * ra;
+      T v0 = x[i] * z[i] - w[i] * y[i];
+      T v1 = w[i] * x[i] + y[i] * z[i];
+      T v2 = w[i] * w[i] - half + z[i] * z[i];
+      T e0 = a1 * v2 - a2 * v1;
+      T e1 = a2 * v0 - a0 * v2;
+      T e2 = a0 * v1 - a1 * v0;
+      ix[i] += two_ki_dt * e0;
+      iy[i] += two_ki_dt * e1;
+      iz[i] += two_ki_dt * e2;
+      T g0 = (gx[i] + on * ix[i] + two_kp * e0) * h;
+      T g1 = (gy[i] + on * iy[i] + two_kp * e1) * h;
+      T g2 = (gz[i] + on * iz[i] + two_kp * e2) * h;
+      t[0][i] = w[i] - (x[i] * g0 + y[i] * g1 + z[i] * g2);
+      t[1][i] = x[i] + (w[i] * g0 + y[i] * g2 - z[i] * g1);
+      t[2][i] = y[i] + (w[i] * g1 + z[i] * g0 - x[i] * g2);
+      t[3][i] = z[i] + (w[i] * g2 + x[i] * g1 - y[i] * g0);
+      n2[i] = t[0][i] * t[0][i] + t[1][i] * t[1][i] + t[2][i] * t[2][i] +
+              t[3][i] * t[3][i];
+    }
+    for (std::size_t i = 0; i < m; i++)
+      r[i] = sqrt(n2[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      T inv = one / r[i];
+      w[i] = t[0][i] * inv;
+      x[i] = t[1][i] * inv;
+      y[i] = t[2][i] * inv;
+      z[i] = t[3][i] * inv;
+    }
+  }
+
+  quaternion_batch<T> q;
+  std::vector<T> integral[3];
+  T kp;
+  T ki;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,326 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_INDEX_HPP
+#define QUATERNION_INDEX_HPP
+#include "quaternion_batch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace quat11 {
+
+namespace index_detail {
+
+/** normalized coefficients of q, ARG_ERROR for zero*/
+template <class T>
+QUATERNION_FLAGS unit_coefficients(const quaternion<T> &q, T c[4]) {
+  using std::sqrt;
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  T n2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+  if (n2 == static_cast<T>(0))
+    return ARG_ERROR;
+  T inv = static_cast<T>(1) / sqrt(n2);
+  for (unsigned int k = 0; k < 4; k++)
+    c[k] *= inv;
+  return SUCCESS;
+}
+
+} // namespace index_detail
+
+/** result of an orientation_index query*/
+template <class T> struct orientation_neighbor {
+  /** position in the batch the index was built from*/
+  std::size_t index;
+  /** rotation angle between query and neighbor in radians*/
+  T angle;
+};
+
+/**
+  \brief Vantage point tree over a set of rotations.
+
+  q and -q are the same rotation, so the tree works on the chordal
+  metric of the projective space
+  \f[d(p, q) = \min(|p - q|, |p + q|) = \sqrt{2 - 2 |p \cdot q|}\f]
+  which is a true metric and orders neighbors like the rotation angle
+  \f[2 \arccos |p \cdot q|\f], only results are converted to angles.
+  Yianilos 1993 - Data structures and algorithms for nearest
+  neighbor search in general metric spaces.
+
+  Queries only read the tree, any number of threads can query a built
+  index at the same time.
+ */
+template <class T> class orientation_index {
+public:
+  orientation_index() {}
+
+  /**
+    build from a batch, the quaternions are normalized. ARG_ERROR if
+    one of them is zero.
+   */
+  QUATERNION_FLAGS build(const quaternion_batch<T> &set) {
+    using std::sqrt;
+    const std::size_t n = set.size();
+    points.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+      T c[4] = {set.data(0)[i], set.data(1)[i], set.data(2)[i],
+                set.data(3)[i]};
+      T n2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+      if (n2 == static_cast<T>(0)) {
+        points.clear();
+        nodes.clear();
+        return ARG_ERROR;
+      }
+      T inv = static_cast<T>(1) / sqrt(n2);
+      for (unsigned int k = 0; k < 4; k++)
+        points[i].c[k] = c[k] * inv;
+      points[i].index = i;
+    }
+    nodes.clear();
+    if (n > 0)
+      build_node(0, n);
+    return SUCCESS;
+  }
+
+  std::size_t size() const { return points.size(); }
+
+  /** closest rotation, ARG_ERROR on an empty index*/
+  QUATERNION_FLAGS nearest(const quaternion<T> &q,
+                           orientation_neighbor<T> &out) const {
+    T c[4];
+    auto res = index_detail::unit_coefficients(q, c);
+    if (res != SUCCESS)
+      return res;
+    if (nodes.empty())
+      return ARG_ERROR;
+    entry best(std::numeric_limits<T>::infinity(), 0);
+    search_nearest(0, c, best);
+    out = to_neighbor(best);
+    return SUCCESS;
+  }
+  /** k closest rotations, closest first*/
+  QUATERNION_FLAGS knn(const quaternion<T> &q, std::size_t k,
+                       std::vector<orientation_neighbor<T>> &out) const {
+    out.clear();
+    T c[4];
+    auto res = index_detail::unit_coefficients(q, c);
+    if (res != SUCCESS)
+      return res;
+    if (k == 0 || nodes.empty())
+      return SUCCESS;
+    heap h;
+    T tau = std::numeric_limits<T>::infinity();
+    search_knn(0, c, k, h, tau);
+    out.resize(h.size());
+    for (std::size_t i = h.size(); i > 0; i--) {
+      out[i - 1] = to_neighbor(h.top());
+      h.pop();
+    }
+    return SUCCESS;
+  }
+  /** every rotation within angle radians, in no particular order*/
+  QUATERNION_FLAGS radius(const quaternion<T> &q, T angle,
+                          std::vector<orientation_neighbor<T>> &out) const {
+    out.clear();
+    T c[4];
+    auto res = index_detail::unit_coefficients(q, c);
+    if (res != SUCCESS)
+      return res;
+    if (angle < static_cast<T>(0))
+      return ARG_ERROR;
+    if (nodes.empty())
+      return SUCCESS;
+    using std::cos;
+    T half = angle * static_cast<T>(0.5);
+    T r = half >= static_cast<T>(1.57079632679489661923)
+              ? std::numeric_limits<T>::infinity()
+              : chord_from_dot(cos(half));
+    search_radius(0, c, r, out);
+    return SUCCESS;
+  }
+
+private:
+  struct point {
+    T c[4];
+    std::size_t index;
+  };
+  /**
+    points [begin, end) of the tree order belong to the node. Inner
+    nodes keep their vantage point at begin, points closer than mu at
+    [begin + 1, mid) under inside and the rest under outside.
+   */
+  struct node {
+    std::size_t begin;
+    std::size_t end;
+    T mu;
+    std::size_t inside;
+    std::size_t outside;
+  };
+  /** (distance, position in points), largest distance on top*/
+  typedef std::pair<T, std::size_t> entry;
+  typedef std::priority_queue<entry> heap;
+
+  static const std::size_t LEAF = 8;
+  static const std::size_t NONE = static_cast<std::size_t>(-1);
+
+  static T chord_from_dot(T d) {
+    using std::fabs;
+    using std::sqrt;
+    T x = static_cast<T>(2) - static_cast<T>(2) * fabs(d);
+    return x > static_cast<T>(0) ? sqrt(x) : static_cast<T>(0);
+  }
+  static T distance(const T a[4], const T b[4]) {
+    return chord_from_dot(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] +
+                          a[3] * b[3]);
+  }
+  orientation_neighbor<T> to_neighbor(const entry &e) const {
+    using std::asin;
+    orientation_neighbor<T> nb;
+    nb.index = points[e.second].index;
+    // chord = 2 sin(angle / 4)
+    T s = e.first * static_cast<T>(0.5);
+    nb.angle = static_cast<T>(4) *
+               asin(s < static_cast<T>(1) ? s : static_cast<T>(1));
+    return nb;
+  }
+
+  std::size_t build_node(std::size_t begin, std::size_t end) {
+    std::size_t id = nodes.size();
+    node nd = {begin, end, static_cast<T>(0), NONE, NONE};
+    nodes.push_back(nd);
+    if (end - begin <= LEAF)
+      return id;
+    // vantage point at begin, the rest split at the median distance
+    const T *vp = points[begin].c;
+    std::size_t mid = begin + 1 + (end - begin - 1) / 2;
+    std::nth_element(points.begin() + begin + 1, points.begin() + mid,
+                     points.begin() + end,
+                     [vp](const point &a, const point &b) {
+                       return distance(vp, a.c) < distance(vp, b.c);
+                     });
+    nodes[id].mu = distance(vp, points[mid].c);
+    std::size_t inside = build_node(begin + 1, mid);
+    std::size_t outside = build_node(mid, end);
+    nodes[id].inside = inside;
+    nodes[id].outside = outside;
+    return id;
+  }
+
+  static void offer(heap &h, std::size_t k, T d, std::size_t i, T &tau) {
+    if (h.size() < k) {
+      h.push(entry(d, i));
+      if (h.size() == k)
+        tau = h.top().first;
+    } else if (d < h.top().first) {
+      h.pop();
+      h.push(entry(d, i));
+      tau = h.top().first;
+    }
+  }
+  void search_knn(std::size_t id, const T q[4], std::size_t k, heap &h,
+                  T &tau) const {
+    const node &nd = nodes[id];
+    if (nd.inside == NONE) {
+      for (std::size_t i = nd.begin; i < nd.end; i++)
+        offer(h, k, distance(q, points[i].c), i, tau);
+      return;
+    }
+    T d = distance(q, points[nd.begin].c);
+    offer(h, k, d, nd.begin, tau);
+    if (d < nd.mu) {
+      search_knn(nd.inside, q, k, h, tau);
+      if (d + tau >= nd.mu)
+        search_knn(nd.outside, q, k, h, tau);
+    } else {
+      search_knn(nd.outside, q, k, h, tau);
+      if (d - tau <= nd.mu)
+        search_knn(nd.inside, q, k, h, tau);
+    }
+  }
+  void search_nearest(std::size_t id, const T q[4], entry &best) const {
+    const node &nd = nodes[id];
+    if (nd.inside == NONE) {
+      for (std::size_t i = nd.begin; i < nd.end; i++) {
+        T d = distance(q, points[i].c);
+        if (d < best.first)
+          best = entry(d, i);
+      }
+      return;
+    }
+    T d = distance(q, points[nd.begin].c);
+    if (d < best.first)
+      best = entry(d, nd.begin);
+    if (d < nd.mu) {
+      search_nearest(nd.inside, q, best);
+      if (d + best.first >= nd.mu)
+        search_nearest(nd.outside, q, best);
+    } else {
+      search_nearest(nd.outside, q, best);
+      if (d - best.first <= nd.mu)
+        search_nearest(nd.inside, q, best);
+    }
+  }
+  void search_radius(std::size_t id, const T q[4], T r,
+                     std::vector<orientation_neighbor<T>> &out) const {
+    const node &nd = nodes[id];
+    if (nd.inside == NONE) {
+      for (std::size_t i = nd.begin; i < nd.end; i++) {
+        T d = distance(q, points[i].c);
+        if (d <= r)
+          out.push_back(to_neighbor(entry(d, i)));
+      }
+      return;
+    }
+    T d = distance(q, points[nd.begin].c);
+    if (d <= r)
+      out.push_back(to_neighbor(entry(d, nd.begin)));
+    if (d - r <= nd.mu)
+      search_radius(nd.inside, q, r, out);
+    if (d + r >= nd.mu)
+      search_radius(nd.outside, q, r, out);
+  }
+
+  std::vector<point> points;
+  std::vector<node> nodes;
+};
+
+} // namespace quat11
+
+#endif
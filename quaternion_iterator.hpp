@@ -0,0 +1,205 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_ITERATOR_HPP
+#define QUATERNION_ITERATOR_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace quat11 {
+
+/**
+  \brief Proxy for one element of a structure of arrays.
+
+  Points at the four coefficients of one quaternion, it converts to
+  quaternion<T> and assigning a quaternion<T> writes the four arrays.
+  P is T for a mutable and const T for a read only element.
+ */
+template <class P> class batch_reference {
+public:
+  typedef typename std::remove_const<P>::type value_t;
+
+  batch_reference(P *w, P *x, P *y, P *z) : w(w), x(x), y(y), z(z) {}
+
+  operator quaternion<value_t>() const {
+    return quaternion<value_t>(*w, *x, *y, *z);
+  }
+  /** writes the element, only for a mutable batch*/
+  const batch_reference &operator=(const quaternion<value_t> &q) const {
+    value_t v[3];
+    q.scalar(*w);
+    q.vector(v);
+    *x = v[0];
+    *y = v[1];
+    *z = v[2];
+    return *this;
+  }
+  /** copies the value, not the proxy*/
+  const batch_reference &operator=(const batch_reference &o) const {
+    *w = *o.w;
+    *x = *o.x;
+    *y = *o.y;
+    *z = *o.z;
+    return *this;
+  }
+  template <class Q>
+  const batch_reference &operator=(const batch_reference<Q> &o) const {
+    return *this = static_cast<quaternion<value_t>>(o);
+  }
+  batch_reference(const batch_reference &) = default;
+
+  friend void swap(const batch_reference &a, const batch_reference &b) {
+    quaternion<value_t> t = a;
+    a = b;
+    b = t;
+  }
+
+private:
+  P *w;
+  P *x;
+  P *y;
+  P *z;
+};
+
+/**
+  \brief Random access iterator over a structure of arrays.
+
+  Keeps the four array starts and an index, dereferencing gives a
+  batch_reference. Standard algorithms with or without an execution
+  policy take these iterators, element wise lambdas should take
+  quaternion<T> by value or const reference.
+ */
+template <class P> class batch_iterator {
+public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef quaternion<typename std::remove_const<P>::type> value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef batch_reference<P> reference;
+  typedef void pointer;
+
+  batch_iterator() : c{nullptr, nullptr, nullptr, nullptr}, i(0) {}
+  batch_iterator(P *w, P *x, P *y, P *z, difference_type i)
+      : c{w, x, y, z}, i(i) {}
+  /** mutable to read only*/
+  template <class Q, class = typename std::enable_if<
+                         std::is_same<const Q, P>::value &&
+                         !std::is_same<Q, P>::value>::type>
+  batch_iterator(const batch_iterator<Q> &o)
+      : c{o.c[0], o.c[1], o.c[2], o.c[3]}, i(o.i) {}
+
+  reference operator*() const {
+    return reference(c[0] + i, c[1] + i, c[2] + i, c[3] + i);
+  }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  batch_iterator &operator++() {
+    ++i;
+    return *this;
+  }
+  batch_iterator operator++(int) {
+    batch_iterator t = *this;
+    ++i;
+    return t;
+  }
+  batch_iterator &operator--() {
+    --i;
+    return *this;
+  }
+  batch_iterator operator--(int) {
+    batch_iterator t = *this;
+    --i;
+    return t;
+  }
+  batch_iterator &operator+=(difference_type n) {
+    i += n;
+    return *this;
+  }
+  batch_iterator &operator-=(difference_type n) {
+    i -= n;
+    return *this;
+  }
+  batch_iterator operator+(difference_type n) const {
+    batch_iterator t = *this;
+    t.i += n;
+    return t;
+  }
+  friend batch_iterator operator+(difference_type n, const batch_iterator &a) {
+    return a + n;
+  }
+  batch_iterator operator-(difference_type n) const { return *this + (-n); }
+  difference_type operator-(const batch_iterator &o) const { return i - o.i; }
+
+  bool operator==(const batch_iterator &o) const { return i == o.i; }
+  bool operator!=(const batch_iterator &o) const { return i != o.i; }
+  bool operator<(const batch_iterator &o) const { return i < o.i; }
+  bool operator>(const batch_iterator &o) const { return i > o.i; }
+  bool operator<=(const batch_iterator &o) const { return i <= o.i; }
+  bool operator>=(const batch_iterator &o) const { return i >= o.i; }
+
+private:
+  template <class Q> friend class batch_iterator;
+  P *c[4];
+  difference_type i;
+};
+
+/**
+  \brief Hamilton product as a binary operation.
+
+  The product is associative but not commutative, so it is fine for
+  std::accumulate, std::partial_sum and std::inclusive_scan, which
+  keep the order of the operands, but not for std::reduce, which may
+  swap them. Give the scans an initial value when they run over
+  batch_iterator, so the running value is a quaternion<T>.
+  quaternion_batch::reduce_product is the ordered reduction that can
+  use several threads.
+ */
+template <class T> struct hamilton_multiplies {
+  quaternion<T> operator()(const quaternion<T> &a,
+                           const quaternion<T> &b) const {
+    return a * b;
+  }
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,177 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_JACOBIAN_HPP
+#define QUATERNION_JACOBIAN_HPP
+#include "quaternion.hpp"
+#include <cmath>
+
+namespace quat11 {
+
+/**
+  Analytic jacobians of the quaternion operations for solvers that
+  would otherwise differentiate hot residuals automatically. They are
+  row major, row i is output i and column j input j, with quaternions
+  ordered [s, x, y, z]. The value is written too, as residuals need
+  both.
+ */
+
+/**
+  \brief d(ab)/da = R(b) and d(ab)/db = L(a), the right and left
+  product matrices
+ */
+template <class T>
+QUATERNION_FLAGS hamilton_product_jacobian(const quaternion<T> &a,
+                                           const quaternion<T> &b,
+                                           quaternion<T> &out, T d_a[16],
+                                           T d_b[16]) {
+  a.left_matrix(d_b);
+  b.right_matrix(d_a);
+  return a.hamilton_product(b, out);
+}
+
+/**
+  \brief jacobians of quaternion::rotate, \f[q [0, v] q^{-1}\f], with
+  respect to q (3 x 4) and v (3 x 3). With q = [w, u] and
+  \f[n = |q|^2\f] the rotation is \f[M v / n\f] for
+  \f[M = (w^2 - u \cdot u) I + 2 u u^T + 2 w [u]_\times\f], so q needs
+  not be a unit quaternion. ARG_ERROR if q is zero.
+ */
+template <class T>
+QUATERNION_FLAGS rotate_jacobian(const quaternion<T> &q, const T v[3],
+                                 T out[3], T d_q[12], T d_v[9]) {
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  const T w = c[0], *u = c + 1;
+  T uu = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+  T n = w * w + uu;
+  if (n == static_cast<T>(0))
+    return ARG_ERROR;
+  const T two = static_cast<T>(2);
+  T inv = static_cast<T>(1) / n;
+  T uv = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+  T uxv[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2],
+              u[0] * v[1] - u[1] * v[0]};
+  T d = w * w - uu;
+  for (unsigned int i = 0; i < 3; i++)
+    out[i] = (d * v[i] + two * uv * u[i] + two * w * uxv[i]) * inv;
+  // cross product matrices [u]x and [v]x
+  const T o = static_cast<T>(0);
+  T ux[9] = {o, -u[2], u[1], u[2], o, -u[0], -u[1], u[0], o};
+  T vx[9] = {o, -v[2], v[1], v[2], o, -v[0], -v[1], v[0], o};
+  for (unsigned int i = 0; i < 3; i++) {
+    // dg / dw - 2 out w, over n
+    d_q[4 * i] = (two * w * v[i] + two * uxv[i] - two * out[i] * w) * inv;
+    for (unsigned int j = 0; j < 3; j++) {
+      T delta = static_cast<T>(i == j);
+      T dg = two * (uv * delta + u[i] * v[j] - v[i] * u[j] - w * vx[3 * i + j]);
+      d_q[4 * i + j + 1] = (dg - two * out[i] * u[j]) * inv;
+      d_v[3 * i + j] =
+          (d * delta + two * u[i] * u[j] + two * w * ux[3 * i + j]) * inv;
+    }
+  }
+  return SUCCESS;
+}
+
+/**
+  \brief jacobian of q / |q|, \f[(I - \hat{q} \hat{q}^T) / |q|\f].
+  ARG_ERROR if q is zero.
+ */
+template <class T>
+QUATERNION_FLAGS normalized_jacobian(const quaternion<T> &q,
+                                     quaternion<T> &out, T d_q[16]) {
+  using std::sqrt;
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  T n2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+  if (n2 == static_cast<T>(0))
+    return ARG_ERROR;
+  T inv = static_cast<T>(1) / sqrt(n2);
+  T h[4] = {c[0] * inv, c[1] * inv, c[2] * inv, c[3] * inv};
+  for (unsigned int i = 0; i < 4; i++)
+    for (unsigned int j = 0; j < 4; j++)
+      d_q[4 * i + j] = (static_cast<T>(i == j) - h[i] * h[j]) * inv;
+  out = quaternion<T>(h[0], h[1], h[2], h[3]);
+  return SUCCESS;
+}
+
+/**
+  \brief jacobian of quaternion::log. With q = [w, u], r = |u|,
+  \f[n = |q|^2\f] and \f[k = atan2(r, w) / r\f] the logarithm is
+  \f[[\ln n / 2, k u]\f], whose rows are \f[q^T / n\f] and
+  \f[[-u / n, k I + (w / n - k) u u^T / r^2]\f]. The last factor
+  tends to \f[-2 / (3 w^3)\f] for pure reals. ARG_ERROR where log
+  fails.
+ */
+template <class T>
+QUATERNION_FLAGS log_jacobian(const quaternion<T> &q, quaternion<T> &out,
+                              T d_q[16]) {
+  using std::atan2;
+  using std::sqrt;
+  auto res = q.log(out);
+  if (res != SUCCESS)
+    return res;
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  const T w = c[0], *u = c + 1;
+  T r2 = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+  T inv = static_cast<T>(1) / (w * w + r2);
+  T k, f;
+  if (r2 == static_cast<T>(0)) {
+    k = static_cast<T>(1) / w;
+    f = static_cast<T>(-2) / (static_cast<T>(3) * w * w * w);
+  } else {
+    T r = sqrt(r2);
+    k = atan2(r, w) / r;
+    f = (w * inv - k) / r2;
+  }
+  for (unsigned int j = 0; j < 4; j++)
+    d_q[j] = c[j] * inv;
+  for (unsigned int i = 0; i < 3; i++) {
+    d_q[4 * (i + 1)] = -u[i] * inv;
+    for (unsigned int j = 0; j < 3; j++)
+      d_q[4 * (i + 1) + j + 1] = k * static_cast<T>(i == j) + f * u[i] * u[j];
+  }
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,161 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_LAZY_HPP
+#define QUATERNION_LAZY_HPP
+#include "quaternion_unit.hpp"
+#include <limits>
+
+namespace quat11 {
+
+/**
+  \brief Unit quaternion that renormalizes only when needed.
+
+  Long chains of hamilton_product drift off the unit sphere.
+  Instead of normalizing after every product, this type carries an
+  upper bound e on \f[||q|^2 - 1|\f] and updates it per product with
+
+  \f[e_{ab} = e_a + e_b + e_a e_b + k \epsilon\f]
+
+  where the last term bounds the rounding of the product itself.
+  Only once the bound exceeds the tolerance the quaternion is
+  pulled back with reproject, which needs neither sqrt nor
+  division, or with a full normalization if it drifted far.
+ */
+template <class T> class lazy_unit_quaternion {
+public:
+  lazy_unit_quaternion()
+      : q(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+          static_cast<T>(0)),
+        bound(static_cast<T>(0)), tol(default_tolerance()) {}
+  /**
+    tolerance is capped by unit_quaternion<T>::tolerance so that the
+    quaternion can always be handed out as a unit_quaternion. The
+    bound starts from the measured drift of u, which may be off by up
+    to unit_quaternion<T>::tolerance.
+   */
+  explicit lazy_unit_quaternion(const unit_quaternion<T> &u,
+                                T tolerance = default_tolerance())
+      : q(u.get()), bound(measured_drift(u.get()) + rounding()),
+        tol(tolerance < unit_quaternion<T>::tolerance()
+                ? tolerance
+                : unit_quaternion<T>::tolerance()) {}
+
+  /** square root of the machine epsilon*/
+  static T default_tolerance() {
+    using std::sqrt;
+    return sqrt(std::numeric_limits<T>::epsilon());
+  }
+  /** bound on the norm error added by rounding in one product*/
+  static T rounding() {
+    return static_cast<T>(16) * std::numeric_limits<T>::epsilon();
+  }
+
+  /** current upper bound on the deviation of the squared norm*/
+  T drift_bound() const { return bound; }
+  T tolerance() const { return tol; }
+  const quaternion<T> &get() const { return q; }
+
+  QUATERNION_FLAGS hamilton_product(const lazy_unit_quaternion &p,
+                                    lazy_unit_quaternion &out) const {
+    T e = bound + p.bound + bound * p.bound + rounding();
+    auto res = q.hamilton_product(p.q, out.q);
+    if (res != SUCCESS)
+      return res;
+    out.bound = e;
+    out.tol = tol;
+    if (e > tol)
+      return out.renormalize();
+    return SUCCESS;
+  }
+  lazy_unit_quaternion operator*(const lazy_unit_quaternion &p) const noexcept {
+    lazy_unit_quaternion out;
+    hamilton_product(p, out);
+    return out;
+  }
+
+  /** pull back onto the unit sphere now, regardless of the bound*/
+  QUATERNION_FLAGS renormalize() {
+    if (bound <= static_cast<T>(0.1)) {
+      auto res = reproject(q, q);
+      if (res != SUCCESS)
+        return res;
+      bound = bound * bound + rounding();
+      return SUCCESS;
+    }
+    auto res = q.normalized(q);
+    if (res != SUCCESS)
+      return res;
+    bound = rounding();
+    return SUCCESS;
+  }
+
+  /** unit quaternion within the tolerance*/
+  QUATERNION_FLAGS to_unit(unit_quaternion<T> &out) const {
+    out = unit_quaternion<T>(q);
+    return SUCCESS;
+  }
+
+  /**
+    Rotate without scaling, the result is off by at most the
+    tolerance relative to the length of v.
+   */
+  QUATERNION_FLAGS rotate(const T v[3], T out[3]) const {
+    unit_quaternion<T> u;
+    auto res = to_unit(u);
+    if (res != SUCCESS)
+      return res;
+    return u.rotate(v, out);
+  }
+
+private:
+  /** \f[||q|^2 - 1|\f]*/
+  static T measured_drift(const quaternion<T> &p) {
+    T d = static_cast<T>(0);
+    p.det(d);
+    T e = d - static_cast<T>(1);
+    return e < static_cast<T>(0) ? -e : e;
+  }
+
+  quaternion<T> q;
+  T bound;
+  T tol;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,549 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_MEKF_HPP
+#define QUATERNION_MEKF_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// the lane kernels have to be inlined into the batch loops for them to
+// vectorize, which is past the compilers' size limits
+#if defined(__GNUC__)
+#define QUATERNION_MEKF_INLINE inline __attribute__((always_inline))
+#else
+#define QUATERNION_MEKF_INLINE inline
+#endif
+
+namespace quat11 {
+
+namespace mekf_detail {
+
+/** rotation matrix of a unit quaternion w x y z, body to reference*/
+template <class T>
+QUATERNION_MEKF_INLINE void rotation_matrix(const T c[4], T r[3][3]) {
+  const T one = static_cast<T>(1);
+  const T two = static_cast<T>(2);
+  T w = c[0], x = c[1], y = c[2], z = c[3];
+  r[0][0] = one - two * (y * y + z * z);
+  r[0][1] = two * (x * y - w * z);
+  r[0][2] = two * (x * z + w * y);
+  r[1][0] = two * (x * y + w * z);
+  r[1][1] = one - two * (x * x + z * z);
+  r[1][2] = two * (y * z - w * x);
+  r[2][0] = two * (x * z - w * y);
+  r[2][1] = two * (y * z + w * x);
+  r[2][2] = one - two * (x * x + y * y);
+}
+
+/** symmetric 3x3 matrix from its upper triangle xx xy xz yy yz zz*/
+template <class T>
+QUATERNION_MEKF_INLINE void unpack(const T p[6], T m[3][3]) {
+  m[0][0] = p[0];
+  m[0][1] = m[1][0] = p[1];
+  m[0][2] = m[2][0] = p[2];
+  m[1][1] = p[3];
+  m[1][2] = m[2][1] = p[4];
+  m[2][2] = p[5];
+}
+
+/**
+  upper triangle of a P a^T for a symmetric P given as its upper
+  triangle. Written out, with loops the small arrays stayed in memory
+  and the batch lanes did not vectorize.
+ */
+template <class T>
+QUATERNION_MEKF_INLINE void sandwich(const T a[3][3], const T p[6],
+                                     T out[6]) {
+  T ap[3][3];
+  ap[0][0] = a[0][0] * p[0] + a[0][1] * p[1] + a[0][2] * p[2];
+  ap[0][1] = a[0][0] * p[1] + a[0][1] * p[3] + a[0][2] * p[4];
+  ap[0][2] = a[0][0] * p[2] + a[0][1] * p[4] + a[0][2] * p[5];
+  ap[1][0] = a[1][0] * p[0] + a[1][1] * p[1] + a[1][2] * p[2];
+  ap[1][1] = a[1][0] * p[1] + a[1][1] * p[3] + a[1][2] * p[4];
+  ap[1][2] = a[1][0] * p[2] + a[1][1] * p[4] + a[1][2] * p[5];
+  ap[2][0] = a[2][0] * p[0] + a[2][1] * p[1] + a[2][2] * p[2];
+  ap[2][1] = a[2][0] * p[1] + a[2][1] * p[3] + a[2][2] * p[4];
+  ap[2][2] = a[2][0] * p[2] + a[2][1] * p[4] + a[2][2] * p[5];
+  out[0] = ap[0][0] * a[0][0] + ap[0][1] * a[0][1] + ap[0][2] * a[0][2];
+  out[1] = ap[0][0] * a[1][0] + ap[0][1] * a[1][1] + ap[0][2] * a[1][2];
+  out[2] = ap[0][0] * a[2][0] + ap[0][1] * a[2][1] + ap[0][2] * a[2][2];
+  out[3] = ap[1][0] * a[1][0] + ap[1][1] * a[1][1] + ap[1][2] * a[1][2];
+  out[4] = ap[1][0] * a[2][0] + ap[1][1] * a[2][1] + ap[1][2] * a[2][2];
+  out[5] = ap[2][0] * a[2][0] + ap[2][1] * a[2][1] + ap[2][2] * a[2][2];
+}
+
+/**
+  propagation over one gyro step. d is the step rotation, the
+  attitude error is expressed in the body frame so it turns with
+  d^T, noise is the gyro variance times dt
+ */
+template <class T>
+QUATERNION_MEKF_INLINE void predict_lane(T c[4], T p[6], const T d[4],
+                                         T noise) {
+  const T half = static_cast<T>(0.5);
+  T w = c[0], x = c[1], y = c[2], z = c[3];
+  T t0 = w * d[0] - x * d[1] - y * d[2] - z * d[3];
+  T t1 = w * d[1] + x * d[0] + y * d[3] - z * d[2];
+  T t2 = w * d[2] - x * d[3] + y * d[0] + z * d[1];
+  T t3 = w * d[3] + x * d[2] - y * d[1] + z * d[0];
+  // one Newton step back to unit norm, no square root needed
+  T f = half * (static_cast<T>(3) - (t0 * t0 + t1 * t1 + t2 * t2 + t3 * t3));
+  c[0] = t0 * f;
+  c[1] = t1 * f;
+  c[2] = t2 * f;
+  c[3] = t3 * f;
+  T r[3][3], ft[3][3];
+  rotation_matrix(d, r);
+  ft[0][0] = r[0][0];
+  ft[0][1] = r[1][0];
+  ft[0][2] = r[2][0];
+  ft[1][0] = r[0][1];
+  ft[1][1] = r[1][1];
+  ft[1][2] = r[2][1];
+  ft[2][0] = r[0][2];
+  ft[2][1] = r[1][2];
+  ft[2][2] = r[2][2];
+  T out[6];
+  sandwich(ft, p, out);
+  p[0] = out[0] + noise;
+  p[1] = out[1];
+  p[2] = out[2];
+  p[3] = out[3] + noise;
+  p[4] = out[4];
+  p[5] = out[5] + noise;
+}
+
+/**
+  update with the unit direction b measured in the body frame of the
+  unit direction ref in the reference frame, var is the measurement
+  variance. on is one to apply the update and zero to leave the lane
+  as it is. Writes the corrected but unnormalized quaternion to t and
+  returns its squared norm.
+ */
+template <class T>
+QUATERNION_MEKF_INLINE T update_lane(const T c[4], T p[6], const T b[3],
+                                     const T ref[3], T var, T on, T t[4]) {
+  const T half = static_cast<T>(0.5);
+  T r[3][3];
+  rotation_matrix(c, r);
+  // predicted measurement, b = e + [e x] dtheta to first order
+  T e0 = r[0][0] * ref[0] + r[1][0] * ref[1] + r[2][0] * ref[2];
+  T e1 = r[0][1] * ref[0] + r[1][1] * ref[1] + r[2][1] * ref[2];
+  T e2 = r[0][2] * ref[0] + r[1][2] * ref[1] + r[2][2] * ref[2];
+  T m[3][3];
+  unpack(p, m);
+  // P H^T with H = [e x]
+  T pht[3][3];
+  pht[0][0] = m[0][2] * e1 - m[0][1] * e2;
+  pht[0][1] = m[0][0] * e2 - m[0][2] * e0;
+  pht[0][2] = m[0][1] * e0 - m[0][0] * e1;
+  pht[1][0] = m[1][2] * e1 - m[1][1] * e2;
+  pht[1][1] = m[1][0] * e2 - m[1][2] * e0;
+  pht[1][2] = m[1][1] * e0 - m[1][0] * e1;
+  pht[2][0] = m[2][2] * e1 - m[2][1] * e2;
+  pht[2][1] = m[2][0] * e2 - m[2][2] * e0;
+  pht[2][2] = m[2][1] * e0 - m[2][0] * e1;
+  // S = H P H^T + var I, symmetric
+  T s00 = e1 * pht[2][0] - e2 * pht[1][0] + var;
+  T s01 = e1 * pht[2][1] - e2 * pht[1][1];
+  T s02 = e1 * pht[2][2] - e2 * pht[1][2];
+  T s11 = e2 * pht[0][1] - e0 * pht[2][1] + var;
+  T s12 = e2 * pht[0][2] - e0 * pht[2][2];
+  T s22 = e0 * pht[1][2] - e1 * pht[0][2] + var;
+  // S is positive definite, invert through the adjugate
+  T a00 = s11 * s22 - s12 * s12;
+  T a01 = s02 * s12 - s01 * s22;
+  T a02 = s01 * s12 - s02 * s11;
+  T a11 = s00 * s22 - s02 * s02;
+  T a12 = s02 * s01 - s00 * s12;
+  T a22 = s00 * s11 - s01 * s01;
+  T inv_det = static_cast<T>(1) / (s00 * a00 + s01 * a01 + s02 * a02);
+  T k[3][3];
+  for (unsigned int i = 0; i < 3; i++) {
+    k[i][0] = (pht[i][0] * a00 + pht[i][1] * a01 + pht[i][2] * a02) * inv_det;
+    k[i][1] = (pht[i][0] * a01 + pht[i][1] * a11 + pht[i][2] * a12) * inv_det;
+    k[i][2] = (pht[i][0] * a02 + pht[i][1] * a12 + pht[i][2] * a22) * inv_det;
+  }
+  T y0 = b[0] - e0, y1 = b[1] - e1, y2 = b[2] - e2;
+  T d0 = on * half * (k[0][0] * y0 + k[0][1] * y1 + k[0][2] * y2);
+  T d1 = on * half * (k[1][0] * y0 + k[1][1] * y1 + k[1][2] * y2);
+  T d2 = on * half * (k[2][0] * y0 + k[2][1] * y1 + k[2][2] * y2);
+  // Joseph form (I - K H) P (I - K H)^T + var K K^T stays symmetric
+  // and positive definite
+  T ikh[3][3];
+  for (unsigned int i = 0; i < 3; i++) {
+    ikh[i][0] = k[i][2] * e1 - k[i][1] * e2;
+    ikh[i][1] = k[i][0] * e2 - k[i][2] * e0;
+    ikh[i][2] = k[i][1] * e0 - k[i][0] * e1;
+  }
+  ikh[0][0] += static_cast<T>(1);
+  ikh[1][1] += static_cast<T>(1);
+  ikh[2][2] += static_cast<T>(1);
+  T jp[6];
+  sandwich(ikh, p, jp);
+  p[0] += on * (jp[0] + var * (k[0][0] * k[0][0] + k[0][1] * k[0][1] +
+                               k[0][2] * k[0][2]) - p[0]);
+  p[1] += on * (jp[1] + var * (k[0][0] * k[1][0] + k[0][1] * k[1][1] +
+                               k[0][2] * k[1][2]) - p[1]);
+  p[2] += on * (jp[2] + var * (k[0][0] * k[2][0] + k[0][1] * k[2][1] +
+                               k[0][2] * k[2][2]) - p[2]);
+  p[3] += on * (jp[3] + var * (k[1][0] * k[1][0] + k[1][1] * k[1][1] +
+                               k[1][2] * k[1][2]) - p[3]);
+  p[4] += on * (jp[4] + var * (k[1][0] * k[2][0] + k[1][1] * k[2][1] +
+                               k[1][2] * k[2][2]) - p[4]);
+  p[5] += on * (jp[5] + var * (k[2][0] * k[2][0] + k[2][1] * k[2][1] +
+                               k[2][2] * k[2][2]) - p[5]);
+  // q (1, dtheta / 2), the error is reset into the reference
+  t[0] = c[0] - (c[1] * d0 + c[2] * d1 + c[3] * d2);
+  t[1] = c[1] + (c[0] * d0 + c[2] * d2 - c[3] * d1);
+  t[2] = c[2] + (c[0] * d1 + c[3] * d0 - c[1] * d2);
+  t[3] = c[3] + (c[0] * d2 + c[1] * d1 - c[2] * d0);
+  return t[0] * t[0] + t[1] * t[1] + t[2] * t[2] + t[3] * t[3];
+}
+
+/** the step rotation for rate g over dt, given |g| as rate*/
+template <class T>
+inline void step_rotation(const T g[3], T rate, T dt, T d[4]) {
+  using std::cos;
+  using std::sin;
+  const T half = static_cast<T>(0.5);
+  std::int32_t still = rate == static_cast<T>(0);
+  T a = half * rate * dt;
+  // sin(a) / |g| tends to dt / 2 for a vanishing rate
+  T k = sin(a) / (rate + static_cast<T>(still)) +
+        static_cast<T>(still) * half * dt;
+  d[0] = cos(a);
+  d[1] = k * g[0];
+  d[2] = k * g[1];
+  d[3] = k * g[2];
+}
+
+} // namespace mekf_detail
+
+/**
+  \brief Multiplicative extended Kalman filter for attitude.
+
+  The state is a reference orientation q, rotating the body frame into
+  the reference frame, and the covariance of a three dimensional
+  small angle error in the body frame, Markley 2003 - Attitude error
+  representations for Kalman filtering. Gyro rates drive the
+  prediction, any number of direction measurements, e.g. gravity or
+  the magnetic field, correct it. After each update the error is
+  folded back into q. All matrices are fixed size arrays on the stack.
+ */
+template <class T> class mekf {
+public:
+  /**
+    gyro_noise is the rate noise density in rad/s/sqrt(Hz) and
+    initial_sigma the standard deviation of the initial error in rad
+   */
+  explicit mekf(T gyro_noise = static_cast<T>(0.01),
+                T initial_sigma = static_cast<T>(1))
+      : q(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+          static_cast<T>(0)),
+        gyro_var(gyro_noise * gyro_noise) {
+    T v = initial_sigma * initial_sigma;
+    T z = static_cast<T>(0);
+    T init[6] = {v, z, z, v, z, v};
+    for (unsigned int k = 0; k < 6; k++)
+      p[k] = init[k];
+  }
+
+  const quaternion<T> &orientation() const { return q; }
+  /** q is normalized, ARG_ERROR if it is zero*/
+  QUATERNION_FLAGS set_orientation(const quaternion<T> &r) {
+    return r.normalized(q);
+  }
+  /** error covariance as a row major 3x3 matrix*/
+  void covariance(T out[9]) const {
+    T m[3][3];
+    mekf_detail::unpack(p, m);
+    for (unsigned int i = 0; i < 3; i++)
+      for (unsigned int j = 0; j < 3; j++)
+        out[3 * i + j] = m[i][j];
+  }
+
+  /** propagate by dt seconds with gyro in rad/s*/
+  QUATERNION_FLAGS predict(const T gyro[3], T dt) {
+    using std::sqrt;
+    T c[4], d[4];
+    coefficients(c);
+    T rate = sqrt(gyro[0] * gyro[0] + gyro[1] * gyro[1] + gyro[2] * gyro[2]);
+    mekf_detail::step_rotation(gyro, rate, dt, d);
+    mekf_detail::predict_lane(c, p, d, gyro_var * dt);
+    q = quaternion<T>(c[0], c[1], c[2], c[3]);
+    return SUCCESS;
+  }
+
+  /**
+    correct with the direction measured in the body frame of the
+    direction reference in the reference frame, sigma is the
+    measurement noise in the same unit as the normalized directions.
+    ARG_ERROR if either is zero.
+   */
+  QUATERNION_FLAGS update(const T measured[3], const T reference[3], T sigma) {
+    using std::sqrt;
+    T b[3], r[3];
+    if (!unit(measured, b) || !unit(reference, r))
+      return ARG_ERROR;
+    T c[4], t[4];
+    coefficients(c);
+    T n2 = mekf_detail::update_lane(c, p, b, r, sigma * sigma,
+                                    static_cast<T>(1), t);
+    T inv = static_cast<T>(1) / sqrt(n2);
+    q = quaternion<T>(t[0] * inv, t[1] * inv, t[2] * inv, t[3] * inv);
+    return SUCCESS;
+  }
+
+private:
+  void coefficients(T c[4]) const {
+    q.scalar(c[0]);
+    q.vector(c + 1);
+  }
+  static bool unit(const T v[3], T out[3]) {
+    using std::sqrt;
+    T n2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    if (n2 == static_cast<T>(0))
+      return false;
+    T inv = static_cast<T>(1) / sqrt(n2);
+    for (unsigned int k = 0; k < 3; k++)
+      out[k] = v[k] * inv;
+    return true;
+  }
+
+  quaternion<T> q;
+  /** upper triangle of the error covariance*/
+  T p[6];
+  T gyro_var;
+};
+
+/**
+  \brief n independent MEKFs updated together.
+
+  Orientations and covariance triangles are kept as structure of
+  arrays. Every lane goes through the same stages as mekf, one loop
+  per stage over a block of lanes, so the matrix arithmetic
+  vectorizes while square roots, sine and cosine get loops of their
+  own. Lanes with a zero measurement are left unchanged by update.
+  Lanes can be split over threads.
+ */
+template <class T> class mekf_batch {
+public:
+  explicit mekf_batch(std::size_t n, T gyro_noise = static_cast<T>(0.01),
+                      T initial_sigma = static_cast<T>(1))
+      : q(n), gyro_var(gyro_noise * gyro_noise) {
+    T v = initial_sigma * initial_sigma;
+    for (unsigned int k = 0; k < 6; k++)
+      p[k].assign(n, k == 0 || k == 3 || k == 5 ? v : static_cast<T>(0));
+    for (std::size_t i = 0; i < n; i++)
+      q.data(0)[i] = static_cast<T>(1);
+  }
+
+  std::size_t size() const { return q.size(); }
+  const quaternion_batch<T> &orientations() const { return q; }
+  /** INDEX_ERROR past size(), ARG_ERROR for a zero r*/
+  QUATERNION_FLAGS set_orientation(std::size_t i, const quaternion<T> &r) {
+    quaternion<T> n;
+    auto res = r.normalized(n);
+    if (res != SUCCESS)
+      return res;
+    return q.set(i, n);
+  }
+  /** error covariance of filter i, row major, INDEX_ERROR past size()*/
+  QUATERNION_FLAGS covariance(std::size_t i, T out[9]) const {
+    if (i >= size())
+      return INDEX_ERROR;
+    T t[6] = {p[0][i], p[1][i], p[2][i], p[3][i], p[4][i], p[5][i]};
+    T m[3][3];
+    mekf_detail::unpack(t, m);
+    for (unsigned int r = 0; r < 3; r++)
+      for (unsigned int c = 0; c < 3; c++)
+        out[3 * r + c] = m[r][c];
+    return SUCCESS;
+  }
+
+  /**
+    propagate every filter, gyro holds three arrays of size() rates,
+    threads as in parallel_ranges
+   */
+  QUATERNION_FLAGS predict(const T *const gyro[3], T dt,
+                           unsigned int threads = 1) {
+    parallel_blocks(size(), threads, LANE_BLOCK,
+                    [this, gyro, dt](std::size_t b, std::size_t m) {
+                      predict_block(b, m, gyro, dt);
+                    });
+    return SUCCESS;
+  }
+
+  /**
+    correct every filter with its own measured direction, three arrays
+    of size() values, of the same reference direction. ARG_ERROR for a
+    zero reference, or if a measurement is zero, whose filter is left
+    uncorrected while the others are.
+   */
+  QUATERNION_FLAGS update(const T *const measured[3], const T reference[3],
+                          T sigma, unsigned int threads = 1) {
+    using std::sqrt;
+    T n2 = reference[0] * reference[0] + reference[1] * reference[1] +
+           reference[2] * reference[2];
+    if (n2 == static_cast<T>(0))
+      return ARG_ERROR;
+    T inv = static_cast<T>(1) / sqrt(n2);
+    const T r[3] = {reference[0] * inv, reference[1] * inv, reference[2] * inv};
+    const T var = sigma * sigma;
+    std::atomic<bool> ok(true);
+    parallel_blocks(size(), threads, LANE_BLOCK,
+                    [this, measured, &r, var, &ok](std::size_t b,
+                                                   std::size_t m) {
+                      if (!update_block(b, m, measured, r, var))
+                        ok.store(false, std::memory_order_relaxed);
+                    });
+    return ok.load() ? SUCCESS : ARG_ERROR;
+  }
+
+private:
+  void predict_block(std::size_t i0, std::size_t m, const T *const gyro[3],
+                     T dt) {
+    using std::sqrt;
+    const std::size_t B = LANE_BLOCK;
+    const T noise = gyro_var * dt;
+    const T *gx = gyro[0] + i0, *gy = gyro[1] + i0, *gz = gyro[2] + i0;
+    T rate[B], d[4][B];
+    for (std::size_t i = 0; i < m; i++)
+      rate[i] = gx[i] * gx[i] + gy[i] * gy[i] + gz[i] * gz[i];
+    for (std::size_t i = 0; i < m; i++)
+      rate[i] = sqrt(rate[i]);
+    for (std::size_t i = 0; i < m; i++) {
+      T g[3] = {gx[i], gy[i], gz[i]}, s[4];
+      mekf_detail::step_rotation(g, rate[i], dt, s);
+      for (unsigned int k = 0; k < 4; k++)
+        d[k][i] = s[k];
+    }
+    T *c[4], *cov[6];
+    lanes(i0, c, cov);
+    // results go to the stack first, see LANE_BLOCK
+    T qs[4][B], ps[6][B];
+    for (std::size_t i = 0; i < m; i++) {
+      T u[4] = {c[0][i], c[1][i], c[2][i], c[3][i]};
+      T t[6] = {cov[0][i], cov[1][i], cov[2][i],
+                cov[3][i], cov[4][i], cov[5][i]};
+      T s[4] = {d[0][i], d[1][i], d[2][i], d[3][i]};
+      mekf_detail::predict_lane(u, t, s, noise);
+      for (unsigned int k = 0; k < 4; k++)
+        qs[k][i] = u[k];
+      for (unsigned int k = 0; k < 6; k++)
+        ps[k][i] = t[k];
+    }
+    for (unsigned int k = 0; k < 4; k++)
+      std::copy(qs[k], qs[k] + m, c[k]);
+    for (unsigned int k = 0; k < 6; k++)
+      std::copy(ps[k], ps[k] + m, cov[k]);
+  }
+
+  /** false if a measurement of the block is zero*/
+  bool update_block(std::size_t i0, std::size_t m, const T *const measured[3],
+                    const T r[3], T var) {
+    using std::sqrt;
+    const std::size_t B = LANE_BLOCK;
+    const T one = static_cast<T>(1);
+    const T *bx = measured[0] + i0, *by = measured[1] + i0,
+            *bz = measured[2] + i0;
+    T n2[B], len[B], t[4][B];
+    for (std::size_t i = 0; i < m; i++)
+      n2[i] = bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i];
+    for (std::size_t i = 0; i < m; i++)
+      len[i] = sqrt(n2[i]);
+    T *c[4], *cov[6];
+    lanes(i0, c, cov);
+    T ps[6][B];
+    std::int32_t zeros = 0;
+    for (std::size_t i = 0; i < m; i++) {
+      // zero measurement: no correction, and no division by zero either
+      std::int32_t zero = n2[i] == static_cast<T>(0);
+      zeros += zero;
+      T on = static_cast<T>(1 - zero);
+      T inv = one / (len[i] + static_cast<T>(zero));
+      T b[3] = {bx[i] * inv, by[i] * inv, bz[i] * inv};
+      T u[4] = {c[0][i], c[1][i], c[2][i], c[3][i]};
+      T s[6] = {cov[0][i], cov[1][i], cov[2][i],
+                cov[3][i], cov[4][i], cov[5][i]};
+      T v[4];
+      n2[i] = mekf_detail::update_lane(u, s, b, r, var, on, v);
+      for (unsigned int k = 0; k < 4; k++)
+        t[k][i] = v[k];
+      for (unsigned int k = 0; k < 6; k++)
+        ps[k][i] = s[k];
+    }
+    for (unsigned int k = 0; k < 6; k++)
+      std::copy(ps[k], ps[k] + m, cov[k]);
+    for (std::size_t i = 0; i < m; i++)
+      len[i] = sqrt(n2[i]);
+    T *w = c[0], *x = c[1], *y = c[2], *z = c[3];
+    for (std::size_t i = 0; i < m; i++) {
+      T inv = one / len[i];
+      w[i] = t[0][i] * inv;
+      x[i] = t[1][i] * inv;
+      y[i] = t[2][i] * inv;
+      z[i] = t[3][i] * inv;
+    }
+    return zeros == 0;
+  }
+
+  /** the quaternion and covariance arrays from lane i0 on*/
+  void lanes(std::size_t i0, T *c[4], T *cov[6]) {
+    for (unsigned int k = 0; k < 4; k++)
+      c[k] = q.data(k) + i0;
+    for (unsigned int k = 0; k < 6; k++)
+      cov[k] = p[k].data() + i0;
+  }
+
+  quaternion_batch<T> q;
+  /** upper triangles of the covariances, xx xy xz yy yz zz*/
+  std::vector<T> p[6];
+  T gyro_var;
+};
+
+} // namespace quat11
+
+#undef QUATERNION_MEKF_INLINE
+
+#endif
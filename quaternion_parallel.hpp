@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_PARALLEL_HPP
+#define QUATERNION_PARALLEL_HPP
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  run fn(first, last) over [0, n) split into threads contiguous
+  ranges, the calling thread takes the last one. Zero threads means
+  one per hardware thread.
+ */
+template <class Fn>
+void parallel_ranges(std::size_t n, unsigned int threads, Fn fn) {
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  if (threads > n)
+    threads = n == 0 ? 1 : static_cast<unsigned int>(n);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  const std::size_t chunk = n / threads;
+  for (unsigned int t = 0; t + 1 < threads; t++)
+    workers.push_back(std::thread(fn, t * chunk, (t + 1) * chunk));
+  fn((threads - 1) * chunk, n);
+  for (std::size_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+}
+
+/**
+  lanes per block of the batch kernels. Their intermediates live in
+  stack arrays of this size, and results go to the stack first and are
+  copied out, as writing many output arrays in one loop needs more alias
+  checks than the vectorizer does. The stack cannot alias the inputs,
+  so the output may be one of them.
+ */
+const std::size_t LANE_BLOCK = 64;
+
+/**
+  parallel_ranges with every range cut into blocks, fn(first, count)
+  runs once per block of at most block lanes
+ */
+template <class Fn>
+void parallel_blocks(std::size_t n, unsigned int threads, std::size_t block,
+                     Fn fn) {
+  parallel_ranges(n, threads, [block, &fn](std::size_t i0, std::size_t i1) {
+    for (std::size_t b = i0; b < i1; b += block)
+      fn(b, i1 - b < block ? i1 - b : block);
+  });
+}
+
+} // namespace quat11
+
+#endif
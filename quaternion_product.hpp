@@ -0,0 +1,137 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_PRODUCT_HPP
+#define QUATERNION_PRODUCT_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include <algorithm>
+
+namespace quat11 {
+
+namespace product_detail {
+
+/**
+  columns of b per tile. A tile of the four coordinates stays in the
+  first level cache while every row of a multiplies it.
+ */
+const std::size_t TILE = 256;
+
+/**
+  rows [i0, i1) of the many by many product as the small matrix
+  product \f[C = [L(a_{i0}); ...; L(a_{i1 - 1})] B\f] with B the 4 x n
+  coordinates of b. Row 4 i + k of C is coordinate k of out from
+  i n on. inverse takes \f[L(a_i^{-1})\f] instead.
+ */
+template <class T>
+void product_rows(const quaternion_batch<T> &a, bool inverse,
+                  const quaternion_batch<T> &b, std::size_t i0,
+                  std::size_t i1, quaternion_batch<T> &out) {
+  const std::size_t n = b.size();
+  T t0[TILE], t1[TILE], t2[TILE], t3[TILE];
+  for (std::size_t j0 = 0; j0 < n; j0 += TILE) {
+    const std::size_t m = n - j0 < TILE ? n - j0 : TILE;
+    std::copy(b.data(0) + j0, b.data(0) + j0 + m, t0);
+    std::copy(b.data(1) + j0, b.data(1) + j0 + m, t1);
+    std::copy(b.data(2) + j0, b.data(2) + j0 + m, t2);
+    std::copy(b.data(3) + j0, b.data(3) + j0 + m, t3);
+    for (std::size_t i = i0; i < i1; i++) {
+      quaternion<T> q;
+      a.get(i, q);
+      if (inverse)
+        q = q.inverse();
+      T l[16];
+      q.left_matrix(l);
+      T *o0 = out.data(0) + i * n + j0, *o1 = out.data(1) + i * n + j0,
+        *o2 = out.data(2) + i * n + j0, *o3 = out.data(3) + i * n + j0;
+      for (std::size_t j = 0; j < m; j++) {
+        o0[j] = l[0] * t0[j] + l[1] * t1[j] + l[2] * t2[j] + l[3] * t3[j];
+        o1[j] = l[4] * t0[j] + l[5] * t1[j] + l[6] * t2[j] + l[7] * t3[j];
+        o2[j] = l[8] * t0[j] + l[9] * t1[j] + l[10] * t2[j] + l[11] * t3[j];
+        o3[j] = l[12] * t0[j] + l[13] * t1[j] + l[14] * t2[j] + l[15] * t3[j];
+      }
+    }
+  }
+}
+
+template <class T>
+void product(const quaternion_batch<T> &a, bool inverse,
+             const quaternion_batch<T> &b, quaternion_batch<T> &out,
+             unsigned int threads) {
+  out.resize(a.size() * b.size());
+  parallel_ranges(a.size(), threads, [&](std::size_t i0, std::size_t i1) {
+    product_rows(a, inverse, b, i0, i1, out);
+  });
+}
+
+} // namespace product_detail
+
+/**
+  \brief every product \f[a_i b_j\f], at index i b.size() + j of out,
+  which is resized. Each product is \f[L(a_i) b_j\f], so the whole is
+  a dense matrix product of the stacked left matrices of a with the
+  coordinates of b, computed tile by tile. out must not be a or b.
+ */
+template <class T>
+QUATERNION_FLAGS all_pairs_product(const quaternion_batch<T> &a,
+                                   const quaternion_batch<T> &b,
+                                   quaternion_batch<T> &out,
+                                   unsigned int threads = 1) {
+  if (&out == &a || &out == &b)
+    return ARG_ERROR;
+  product_detail::product(a, false, b, out, threads);
+  return SUCCESS;
+}
+
+/**
+  \brief every relative rotation \f[a_i^{-1} b_j\f], laid out as in
+  all_pairs_product. out must not be a or b.
+ */
+template <class T>
+QUATERNION_FLAGS all_pairs_relative(const quaternion_batch<T> &a,
+                                    const quaternion_batch<T> &b,
+                                    quaternion_batch<T> &out,
+                                    unsigned int threads = 1) {
+  if (&out == &a || &out == &b)
+    return ARG_ERROR;
+  product_detail::product(a, true, b, out, threads);
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
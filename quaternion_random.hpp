@@ -0,0 +1,223 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_RANDOM_HPP
+#define QUATERNION_RANDOM_HPP
+#include "quaternion_batch.hpp"
+#include <cmath>
+#include <cstdint>
+
+namespace quat11 {
+namespace random_detail {
+
+/**
+  Philox4x32-10 counter based generator of Salmon et al. 2011,
+  Parallel random numbers: as easy as 1, 2, 3. The output only
+  depends on the counter and the key, there is no state to share.
+ */
+inline void philox4x32(const std::uint32_t ctr[4], const std::uint32_t key[2],
+                       std::uint32_t out[4]) {
+  const std::uint32_t M0 = 0xD2511F53u;
+  const std::uint32_t M1 = 0xCD9E8D57u;
+  std::uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  std::uint32_t k0 = key[0], k1 = key[1];
+  for (unsigned int r = 0; r < 10; r++) {
+    std::uint64_t p0 = static_cast<std::uint64_t>(M0) * c0;
+    std::uint64_t p1 = static_cast<std::uint64_t>(M1) * c2;
+    std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    std::uint32_t n1 = static_cast<std::uint32_t>(p1);
+    std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    std::uint32_t n3 = static_cast<std::uint32_t>(p0);
+    c0 = n0;
+    c1 = n1;
+    c2 = n2;
+    c3 = n3;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+/** uniform in (0, 1) from 32 random bits, 24 of them for float*/
+inline float uniform(std::uint32_t x, float) {
+  return (static_cast<float>(x >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+inline double uniform(std::uint32_t x, double) {
+  return (static_cast<double>(x) + 0.5) * (1.0 / 4294967296.0);
+}
+
+/**
+  sin and cos of 2 pi x / 2^32 without calling into libm: the top two
+  bits pick the quadrant, the rest is an angle in [-pi/4, pi/4) after
+  centering, where short Taylor series are exact to the precision of
+  T. Only arithmetic and selects, so loops over it vectorize.
+ */
+template <class T> inline void sincos_turn(std::uint32_t x, T &s, T &c) {
+  const T half_pi = static_cast<T>(1.57079632679489661923);
+  const T inv_sqrt2 = static_cast<T>(0.70710678118654752440);
+  T f = static_cast<T>(x & 0x3FFFFFFFu) * static_cast<T>(1.0 / 1073741824.0);
+  T a = (f - static_cast<T>(0.5)) * half_pi;
+  T a2 = a * a;
+  // Horner form of the series up to a^15 and a^16
+  static const double sin_c[8] = {1.0,
+                                  -1.0 / 6,
+                                  1.0 / 120,
+                                  -1.0 / 5040,
+                                  1.0 / 362880,
+                                  -1.0 / 39916800,
+                                  1.0 / 6227020800.0,
+                                  -1.0 / 1307674368000.0};
+  static const double cos_c[9] = {1.0,
+                                  -1.0 / 2,
+                                  1.0 / 24,
+                                  -1.0 / 720,
+                                  1.0 / 40320,
+                                  -1.0 / 3628800,
+                                  1.0 / 479001600,
+                                  -1.0 / 87178291200.0,
+                                  1.0 / 20922789888000.0};
+  T sa = static_cast<T>(sin_c[7]);
+  for (int k = 6; k >= 0; k--)
+    sa = sa * a2 + static_cast<T>(sin_c[k]);
+  sa = sa * a;
+  T ca = static_cast<T>(cos_c[8]);
+  for (int k = 7; k >= 0; k--)
+    ca = ca * a2 + static_cast<T>(cos_c[k]);
+  // angle of the quadrant plus pi/4 plus a
+  T s0 = (sa + ca) * inv_sqrt2;
+  T c0 = (ca - sa) * inv_sqrt2;
+  std::uint32_t q = x >> 30;
+  T s1 = (q & 1u) ? c0 : s0;
+  T c1 = (q & 1u) ? -s0 : c0;
+  s = (q & 2u) ? -s1 : s1;
+  c = (q & 2u) ? -c1 : c1;
+}
+
+} // namespace random_detail
+
+/**
+  \brief Uniformly distributed random rotations.
+
+  Shoemake 1992 - Uniform random rotations, Graphics Gems III
+  p. 124, driven by Philox4x32-10. Rotation i of a sequence is
+  computed from the counter (i, stream) and the key seed alone, so
+  any range of the sequence can be generated by any thread and the
+  result does not depend on how the work was split.
+ */
+template <class T> class random_rotations {
+public:
+  explicit random_rotations(std::uint64_t seed, std::uint64_t stream = 0)
+      : key{static_cast<std::uint32_t>(seed),
+            static_cast<std::uint32_t>(seed >> 32)},
+        stream_lo(static_cast<std::uint32_t>(stream)),
+        stream_hi(static_cast<std::uint32_t>(stream >> 32)) {}
+
+  /** rotation number index of the sequence*/
+  QUATERNION_FLAGS generate(std::uint64_t index, quaternion<T> &out) const {
+    T c[4];
+    T *dst[4] = {c, c + 1, c + 2, c + 3};
+    fill(index, 1, dst);
+    out = quaternion<T>(c);
+    return SUCCESS;
+  }
+  /** rotations first to first + n - 1 into out, which is resized to n*/
+  QUATERNION_FLAGS generate(std::size_t n, quaternion_batch<T> &out,
+                            std::uint64_t first = 0) const {
+    out.resize(n);
+    T *dst[4] = {out.data(0), out.data(1), out.data(2), out.data(3)};
+    fill(first, n, dst);
+    return SUCCESS;
+  }
+  /**
+    rotations first to first + n - 1 into four component arrays, e.g.
+    a slice of a batch that other threads fill at the same time
+   */
+  void fill(std::uint64_t first, std::size_t n, T *const dst[4]) const {
+    const std::size_t B = 64;
+    std::uint32_t r[3][B];
+    for (std::size_t i0 = 0; i0 < n; i0 += B) {
+      const std::size_t m = n - i0 < B ? n - i0 : B;
+      for (std::size_t j = 0; j < m; j++) {
+        std::uint64_t index = first + i0 + j;
+        const std::uint32_t ctr[4] = {static_cast<std::uint32_t>(index),
+                                      static_cast<std::uint32_t>(index >> 32),
+                                      stream_lo, stream_hi};
+        std::uint32_t bits[4];
+        random_detail::philox4x32(ctr, key, bits);
+        r[0][j] = bits[0];
+        r[1][j] = bits[1];
+        r[2][j] = bits[2];
+      }
+      // sqrt stays in its own loop, its errno path would keep the
+      // other loops from vectorizing
+      T sc[4][B], ab[2][B];
+      for (std::size_t j = 0; j < m; j++) {
+        random_detail::sincos_turn(r[1][j], sc[0][j], sc[1][j]);
+        random_detail::sincos_turn(r[2][j], sc[2][j], sc[3][j]);
+        ab[1][j] = random_detail::uniform(r[0][j], T());
+        ab[0][j] = static_cast<T>(1) - ab[1][j];
+      }
+      for (std::size_t j = 0; j < m; j++) {
+        using std::sqrt;
+        ab[0][j] = sqrt(ab[0][j]);
+        ab[1][j] = sqrt(ab[1][j]);
+      }
+      T *w = dst[0] + i0;
+      T *x = dst[1] + i0;
+      T *y = dst[2] + i0;
+      T *z = dst[3] + i0;
+      for (std::size_t j = 0; j < m; j++) {
+        w[j] = ab[1][j] * sc[3][j];
+        x[j] = ab[0][j] * sc[0][j];
+        y[j] = ab[0][j] * sc[1][j];
+        z[j] = ab[1][j] * sc[2][j];
+      }
+    }
+  }
+
+private:
+  std::uint32_t key[2];
+  std::uint32_t stream_lo;
+  std::uint32_t stream_hi;
+};
+
+} // namespace quat11
+
+#endif
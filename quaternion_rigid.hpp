@@ -0,0 +1,254 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_RIGID_HPP
+#define QUATERNION_RIGID_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace quat11 {
+
+namespace rigid_detail {
+
+/**
+  time derivative of the state: \f[\dot q = \frac{1}{2} q (0, \omega)\f]
+  and Euler's equations \f[I \dot\omega = \tau - \omega \times I
+  \omega\f] with omega in the body frame and a diagonal inertia
+ */
+template <class T>
+inline void derivative(const T c[4], const T w[3], const T inertia[3],
+                       const T inv_inertia[3], const T tau[3], T dc[4],
+                       T dw[3]) {
+  const T half = static_cast<T>(0.5);
+  dc[0] = -half * (c[1] * w[0] + c[2] * w[1] + c[3] * w[2]);
+  dc[1] = half * (c[0] * w[0] + c[2] * w[2] - c[3] * w[1]);
+  dc[2] = half * (c[0] * w[1] + c[3] * w[0] - c[1] * w[2]);
+  dc[3] = half * (c[0] * w[2] + c[1] * w[1] - c[2] * w[0]);
+  T l0 = inertia[0] * w[0], l1 = inertia[1] * w[1], l2 = inertia[2] * w[2];
+  dw[0] = (tau[0] - (w[1] * l2 - w[2] * l1)) * inv_inertia[0];
+  dw[1] = (tau[1] - (w[2] * l0 - w[0] * l2)) * inv_inertia[1];
+  dw[2] = (tau[2] - (w[0] * l1 - w[1] * l0)) * inv_inertia[2];
+}
+
+/**
+  one classic Runge-Kutta step for one body, the four stages are
+  fused so nothing leaves registers. c is left unnormalized, the
+  squared norm is returned.
+ */
+template <class T>
+inline T rk4_lane(T c[4], T w[3], const T inertia[3], const T tau[3], T dt) {
+  const T half = static_cast<T>(0.5);
+  const T sixth = dt / static_cast<T>(6);
+  const T inv[3] = {static_cast<T>(1) / inertia[0],
+                    static_cast<T>(1) / inertia[1],
+                    static_cast<T>(1) / inertia[2]};
+  T k1c[4], k1w[3], k2c[4], k2w[3], k3c[4], k3w[3], k4c[4], k4w[3];
+  T sc[4], sw[3];
+  derivative(c, w, inertia, inv, tau, k1c, k1w);
+  for (unsigned int k = 0; k < 4; k++)
+    sc[k] = c[k] + half * dt * k1c[k];
+  for (unsigned int k = 0; k < 3; k++)
+    sw[k] = w[k] + half * dt * k1w[k];
+  derivative(sc, sw, inertia, inv, tau, k2c, k2w);
+  for (unsigned int k = 0; k < 4; k++)
+    sc[k] = c[k] + half * dt * k2c[k];
+  for (unsigned int k = 0; k < 3; k++)
+    sw[k] = w[k] + half * dt * k2w[k];
+  derivative(sc, sw, inertia, inv, tau, k3c, k3w);
+  for (unsigned int k = 0; k < 4; k++)
+    sc[k] = c[k] + dt * k3c[k];
+  for (unsigned int k = 0; k < 3; k++)
+    sw[k] = w[k] + dt * k3w[k];
+  derivative(sc, sw, inertia, inv, tau, k4c, k4w);
+  for (unsigned int k = 0; k < 4; k++)
+    c[k] += sixth * (k1c[k] + static_cast<T>(2) * (k2c[k] + k3c[k]) + k4c[k]);
+  for (unsigned int k = 0; k < 3; k++)
+    w[k] += sixth * (k1w[k] + static_cast<T>(2) * (k2w[k] + k3w[k]) + k4w[k]);
+  return c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+}
+
+} // namespace rigid_detail
+
+/**
+  \brief one RK4 step of dt for a rigid body with orientation q, body
+  frame angular velocity omega in rad/s, principal moments of inertia
+  and body frame torque, held constant over the step. q rotates the
+  body frame into the world frame and is renormalized once at the end.
+  ARG_ERROR for a zero q or a moment that is not positive, nothing is
+  changed then.
+ */
+template <class T>
+QUATERNION_FLAGS rk4_step(quaternion<T> &q, T omega[3], const T inertia[3],
+                          const T torque[3], T dt) {
+  using std::sqrt;
+  const T zero = static_cast<T>(0);
+  if (!(inertia[0] > zero && inertia[1] > zero && inertia[2] > zero))
+    return ARG_ERROR;
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  if (c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3] == zero)
+    return ARG_ERROR;
+  T inv = static_cast<T>(1) / sqrt(rigid_detail::rk4_lane(c, omega, inertia,
+                                                          torque, dt));
+  q = quaternion<T>(c[0] * inv, c[1] * inv, c[2] * inv, c[3] * inv);
+  return SUCCESS;
+}
+
+/**
+  \brief n rigid bodies integrated together with RK4.
+
+  Orientations, angular velocities and principal moments are kept as
+  structure of arrays. A step runs the fused four stage kernel of
+  rk4_step lane by lane over blocks of bodies, the square roots of
+  the single renormalization get a loop of their own. Bodies can be
+  split over threads.
+ */
+template <class T> class rigid_body_batch {
+public:
+  /** n bodies at rest with identity orientation and unit moments*/
+  explicit rigid_body_batch(std::size_t n)
+      : q(n), omega{std::vector<T>(n), std::vector<T>(n), std::vector<T>(n)},
+        inertia{std::vector<T>(n, static_cast<T>(1)),
+                std::vector<T>(n, static_cast<T>(1)),
+                std::vector<T>(n, static_cast<T>(1))} {
+    for (std::size_t i = 0; i < n; i++)
+      q.data(0)[i] = static_cast<T>(1);
+  }
+
+  std::size_t size() const { return q.size(); }
+  const quaternion_batch<T> &orientations() const { return q; }
+  /** body frame angular velocities, component k of every body*/
+  const T *angular_velocity(unsigned int k) const { return omega[k].data(); }
+
+  /**
+    sets body i, p is normalized. INDEX_ERROR past size(), ARG_ERROR
+    for a zero p or a moment that is not positive.
+   */
+  QUATERNION_FLAGS set_body(std::size_t i, const quaternion<T> &p,
+                            const T w[3], const T moments[3]) {
+    if (i >= size())
+      return INDEX_ERROR;
+    const T zero = static_cast<T>(0);
+    if (!(moments[0] > zero && moments[1] > zero && moments[2] > zero))
+      return ARG_ERROR;
+    quaternion<T> n;
+    auto res = p.normalized(n);
+    if (res != SUCCESS)
+      return res;
+    q.set(i, n);
+    for (unsigned int k = 0; k < 3; k++) {
+      omega[k][i] = w[k];
+      inertia[k][i] = moments[k];
+    }
+    return SUCCESS;
+  }
+
+  /**
+    one step of dt for every body, torque holds three arrays of size()
+    body frame torques, threads as in parallel_ranges
+   */
+  QUATERNION_FLAGS step(const T *const torque[3], T dt,
+                        unsigned int threads = 1) {
+    parallel_blocks(size(), threads, LANE_BLOCK,
+                    [this, torque, dt](std::size_t b, std::size_t m) {
+                      block(b, m, torque, dt);
+                    });
+    return SUCCESS;
+  }
+  /** one torque free step*/
+  QUATERNION_FLAGS step(T dt, unsigned int threads = 1) {
+    return step(nullptr, dt, threads);
+  }
+
+private:
+  void block(std::size_t i0, std::size_t m, const T *const torque[3], T dt) {
+    using std::sqrt;
+    const std::size_t B = LANE_BLOCK;
+    const T zero = static_cast<T>(0);
+    T *c[4], *w[3];
+    const T *in[3];
+    for (unsigned int k = 0; k < 4; k++)
+      c[k] = q.data(k) + i0;
+    for (unsigned int k = 0; k < 3; k++) {
+      w[k] = omega[k].data() + i0;
+      in[k] = inertia[k].data() + i0;
+    }
+    // no torque reads zeros instead of branching in the lanes
+    T none[B];
+    std::fill(none, none + m, zero);
+    const T *tau[3] = {torque ? torque[0] + i0 : none,
+                       torque ? torque[1] + i0 : none,
+                       torque ? torque[2] + i0 : none};
+    // results go to the stack first, see LANE_BLOCK
+    T cs[4][B], ws[3][B], n2[B];
+    for (std::size_t i = 0; i < m; i++) {
+      T u[4] = {c[0][i], c[1][i], c[2][i], c[3][i]};
+      T v[3] = {w[0][i], w[1][i], w[2][i]};
+      T moments[3] = {in[0][i], in[1][i], in[2][i]};
+      T t[3] = {tau[0][i], tau[1][i], tau[2][i]};
+      n2[i] = rigid_detail::rk4_lane(u, v, moments, t, dt);
+      for (unsigned int k = 0; k < 4; k++)
+        cs[k][i] = u[k];
+      for (unsigned int k = 0; k < 3; k++)
+        ws[k][i] = v[k];
+    }
+    for (unsigned int k = 0; k < 3; k++)
+      std::copy(ws[k], ws[k] + m, w[k]);
+    for (std::size_t i = 0; i < m; i++)
+      n2[i] = sqrt(n2[i]);
+    T *qw = c[0], *qx = c[1], *qy = c[2], *qz = c[3];
+    for (std::size_t i = 0; i < m; i++) {
+      T inv = static_cast<T>(1) / n2[i];
+      qw[i] = cs[0][i] * inv;
+      qx[i] = cs[1][i] * inv;
+      qy[i] = cs[2][i] * inv;
+      qz[i] = cs[3][i] * inv;
+    }
+  }
+
+  quaternion_batch<T> q;
+  std::vector<T> omega[3];
+  std::vector<T> inertia[3];
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,255 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_RING_HPP
+#define QUATERNION_RING_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include "quaternion_allocator.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace quat11 {
+
+/** one orientation reading with the time it was taken*/
+template <class T> struct orientation_sample {
+  std::uint64_t timestamp;
+  quaternion<T> q;
+};
+
+namespace ring_detail {
+
+/** smallest power of two at least n and at least 2*/
+inline std::size_t round_capacity(std::size_t n) {
+  std::size_t c = 2;
+  while (c < n)
+    c *= 2;
+  return c;
+}
+
+/**
+  an index alone on its cache line together with the copy of the
+  other side's index its owner keeps, padded instead of aligned so
+  that heap allocated rings need no over aligned new
+ */
+struct padded_index {
+  char before[QUATERNION_CACHE_LINE];
+  std::atomic<std::uint64_t> value;
+  std::uint64_t cached;
+  char after[QUATERNION_CACHE_LINE - sizeof(std::atomic<std::uint64_t>) -
+             sizeof(std::uint64_t)];
+};
+
+} // namespace ring_detail
+
+/**
+  \brief Bounded lock-free queue for one producer and one consumer.
+
+  The producer only writes the tail and the consumer only the head,
+  each on its own cache line. Both keep a copy of the other index and
+  only reload it when the copy says the ring is full or empty, so in
+  steady state a push or pop touches no line the other side writes
+  except the records. Batched push and pop move as many records as
+  fit and publish them with a single store.
+ */
+template <class T> class spsc_ring {
+public:
+  typedef orientation_sample<T> value_type;
+
+  /** capacity is rounded up to a power of two*/
+  explicit spsc_ring(std::size_t capacity)
+      : records(ring_detail::round_capacity(capacity)),
+        mask(records.size() - 1) {
+    tail.value.store(0, std::memory_order_relaxed);
+    tail.cached = 0;
+    head.value.store(0, std::memory_order_relaxed);
+    head.cached = 0;
+  }
+  spsc_ring(const spsc_ring &) = delete;
+  spsc_ring &operator=(const spsc_ring &) = delete;
+
+  std::size_t capacity() const { return records.size(); }
+  /** records in the ring, exact only while neither side runs*/
+  std::size_t size() const {
+    return static_cast<std::size_t>(tail.value.load(std::memory_order_acquire) -
+                                    head.value.load(std::memory_order_acquire));
+  }
+
+  /** producer side, false if the ring is full*/
+  bool push(const value_type &v) { return push(&v, 1) == 1; }
+  /** producer side, pushes the first records that fit, returns how many*/
+  std::size_t push(const value_type *v, std::size_t n) {
+    const std::uint64_t t = tail.value.load(std::memory_order_relaxed);
+    std::size_t room = capacity() - static_cast<std::size_t>(t - tail.cached);
+    if (room < n) {
+      tail.cached = head.value.load(std::memory_order_acquire);
+      room = capacity() - static_cast<std::size_t>(t - tail.cached);
+    }
+    const std::size_t k = n < room ? n : room;
+    for (std::size_t j = 0; j < k; j++)
+      records[(t + j) & mask] = v[j];
+    tail.value.store(t + k, std::memory_order_release);
+    return k;
+  }
+
+  /** consumer side, false if the ring is empty*/
+  bool pop(value_type &out) { return pop(&out, 1) == 1; }
+  /** consumer side, pops up to n records, returns how many*/
+  std::size_t pop(value_type *out, std::size_t n) {
+    const std::uint64_t h = head.value.load(std::memory_order_relaxed);
+    std::size_t ready = static_cast<std::size_t>(head.cached - h);
+    if (ready < n) {
+      head.cached = tail.value.load(std::memory_order_acquire);
+      ready = static_cast<std::size_t>(head.cached - h);
+    }
+    const std::size_t k = n < ready ? n : ready;
+    for (std::size_t j = 0; j < k; j++)
+      out[j] = records[(h + j) & mask];
+    head.value.store(h + k, std::memory_order_release);
+    return k;
+  }
+
+private:
+  std::vector<value_type, aligned_allocator<value_type>> records;
+  const std::size_t mask;
+  /** written by the producer, cached is its copy of the head*/
+  ring_detail::padded_index tail;
+  /** written by the consumer, cached is its copy of the tail*/
+  ring_detail::padded_index head;
+};
+
+/**
+  \brief Bounded lock-free queue for many producers and one consumer.
+
+  Producers reserve a run of slots with one compare and swap on the
+  tail, fill them and mark each slot ready with its position plus
+  one, Vyukov 2010 - Bounded MPMC queue. The consumer takes ready
+  slots in order and publishes the head, which producers read to
+  know which slots are free again. A producer preempted between its
+  reservation and its marks holds back the consumer at that slot,
+  records are never reordered or lost.
+ */
+template <class T> class mpsc_ring {
+public:
+  typedef orientation_sample<T> value_type;
+
+  /** capacity is rounded up to a power of two*/
+  explicit mpsc_ring(std::size_t capacity)
+      : slots(ring_detail::round_capacity(capacity)), mask(slots.size() - 1) {
+    for (std::size_t i = 0; i < slots.size(); i++)
+      slots[i].ready.store(0, std::memory_order_relaxed);
+    tail.value.store(0, std::memory_order_relaxed);
+    tail.cached = 0;
+    head.value.store(0, std::memory_order_relaxed);
+    head.cached = 0;
+  }
+  mpsc_ring(const mpsc_ring &) = delete;
+  mpsc_ring &operator=(const mpsc_ring &) = delete;
+
+  std::size_t capacity() const { return slots.size(); }
+  /** records reserved and not yet popped, a snapshot*/
+  std::size_t size() const {
+    return static_cast<std::size_t>(tail.value.load(std::memory_order_acquire) -
+                                    head.value.load(std::memory_order_acquire));
+  }
+
+  /** producer side, any thread, false if the ring is full*/
+  bool push(const value_type &v) { return push(&v, 1) == 1; }
+  /**
+    producer side, any thread. Reserves and pushes as many of the n
+    records as fit in one go, returns how many.
+   */
+  std::size_t push(const value_type *v, std::size_t n) {
+    std::uint64_t t = tail.value.load(std::memory_order_relaxed);
+    std::size_t k = 0;
+    for (;;) {
+      const std::uint64_t h = head.value.load(std::memory_order_acquire);
+      const std::size_t room = capacity() - static_cast<std::size_t>(t - h);
+      k = n < room ? n : room;
+      if (k == 0)
+        return 0;
+      if (tail.value.compare_exchange_weak(t, t + k,
+                                           std::memory_order_relaxed,
+                                           std::memory_order_relaxed))
+        break;
+    }
+    for (std::size_t j = 0; j < k; j++) {
+      slot &s = slots[(t + j) & mask];
+      s.v = v[j];
+      s.ready.store(t + j + 1, std::memory_order_release);
+    }
+    return k;
+  }
+
+  /** consumer side, false if the next record is not ready*/
+  bool pop(value_type &out) { return pop(&out, 1) == 1; }
+  /** consumer side, pops up to n ready records in order, returns how many*/
+  std::size_t pop(value_type *out, std::size_t n) {
+    const std::uint64_t h = head.value.load(std::memory_order_relaxed);
+    std::size_t k = 0;
+    while (k < n) {
+      const slot &s = slots[(h + k) & mask];
+      if (s.ready.load(std::memory_order_acquire) != h + k + 1)
+        break;
+      out[k] = s.v;
+      k++;
+    }
+    if (k != 0)
+      head.value.store(h + k, std::memory_order_release);
+    return k;
+  }
+
+private:
+  struct slot {
+    /** position plus one once the record at that position is written*/
+    std::atomic<std::uint64_t> ready;
+    value_type v;
+  };
+
+  std::vector<slot, aligned_allocator<slot>> slots;
+  const std::size_t mask;
+  ring_detail::padded_index tail;
+  ring_detail::padded_index head;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,403 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_SWING_HPP
+#define QUATERNION_SWING_HPP
+#include "quaternion_batch.hpp"
+#include "quaternion_parallel.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  limits of one joint: the twist about axis may range from twist_min
+  to twist_max and the swing of the axis may reach swing_max, all in
+  radians with \f[-\pi \le twist_{min} \le twist_{max} \le \pi\f] and
+  \f[0 \le swing_{max} \le \pi\f]. The axis need not be normalized.
+ */
+template <class T> struct joint_limit {
+  T axis[3];
+  T twist_min;
+  T twist_max;
+  T swing_max;
+};
+
+namespace swing_detail {
+
+/**
+  twist of c about the unit axis d as (tw, ts d) before normalizing,
+  Dobrowolski 2015 - Swing-twist decomposition in Clifford algebra.
+  A rotation by a half turn about an axis perpendicular to d has no
+  twist, the identity is blended in there. Returns the squared norm.
+ */
+template <class T>
+inline T twist_lane(const T c[4], const T d[3], T &tw, T &ts) {
+  tw = c[0];
+  ts = c[1] * d[0] + c[2] * d[1] + c[3] * d[2];
+  std::int32_t none = tw * tw + ts * ts == static_cast<T>(0);
+  tw += static_cast<T>(none);
+  return tw * tw + ts * ts;
+}
+
+/** swing = c (tw, ts d)^* for a unit twist*/
+template <class T>
+inline void swing_lane(const T c[4], const T d[3], T tw, T ts, T s[4]) {
+  T vd = c[1] * d[0] + c[2] * d[1] + c[3] * d[2];
+  T x[3] = {c[2] * d[2] - c[3] * d[1], c[3] * d[0] - c[1] * d[2],
+            c[1] * d[1] - c[2] * d[0]};
+  s[0] = c[0] * tw + ts * vd;
+  for (unsigned int k = 0; k < 3; k++)
+    s[k + 1] = tw * c[k + 1] - c[0] * ts * d[k] - ts * x[k];
+}
+
+/**
+  clamps the unit twist (tw, ts d) to the half angles given by their
+  cosines and sines, after turning it to tw >= 0. Returns the sign it
+  took.
+ */
+template <class T>
+inline T clamp_twist(T &tw, T &ts, T lo_c, T lo_s, T hi_c, T hi_s) {
+  using std::copysign;
+  T sign = copysign(static_cast<T>(1), tw);
+  tw *= sign;
+  ts *= sign;
+  // the half angle is in [-pi / 2, pi / 2], crosses order it
+  std::int32_t above = ts * hi_c - tw * hi_s > static_cast<T>(0);
+  std::int32_t below = ts * lo_c - tw * lo_s < static_cast<T>(0);
+  T a = static_cast<T>(above), b = static_cast<T>(below);
+  T keep = static_cast<T>(1) - a - b;
+  tw = keep * tw + a * hi_c + b * lo_c;
+  ts = keep * ts + a * hi_s + b * lo_s;
+  return sign;
+}
+
+/**
+  turns the swing s to s[0] >= 0, returns the sign it took and
+  writes |v|^2 of the vector part to r2
+ */
+template <class T> inline T canonical_swing(T s[4], T &r2) {
+  using std::copysign;
+  T sign = copysign(static_cast<T>(1), s[0]);
+  for (unsigned int k = 0; k < 4; k++)
+    s[k] *= sign;
+  r2 = s[1] * s[1] + s[2] * s[2] + s[3] * s[3];
+  return sign;
+}
+
+/**
+  limits the swing s with s[0] >= 0 and |v| = r to the cone with half
+  angle cosine and sine cone_c, cone_s, then writes sign s (tw, ts d)
+  to out
+ */
+template <class T>
+inline void recompose_lane(const T s[4], T r, T cone_c, T cone_s,
+                           const T d[3], T tw, T ts, T sign, T out[4]) {
+  std::int32_t outside = r * cone_c > s[0] * cone_s;
+  std::int32_t zero = r == static_cast<T>(0);
+  T o = static_cast<T>(outside);
+  T keep = static_cast<T>(1) - o;
+  T scale = keep + o * cone_s / (r + static_cast<T>(zero));
+  T p[4] = {keep * s[0] + o * cone_c, s[1] * scale, s[2] * scale,
+            s[3] * scale};
+  T pd = p[1] * d[0] + p[2] * d[1] + p[3] * d[2];
+  T x[3] = {p[2] * d[2] - p[3] * d[1], p[3] * d[0] - p[1] * d[2],
+            p[1] * d[1] - p[2] * d[0]};
+  out[0] = sign * (p[0] * tw - ts * pd);
+  for (unsigned int k = 0; k < 3; k++)
+    out[k + 1] = sign * (p[0] * ts * d[k] + tw * p[k + 1] + ts * x[k]);
+}
+
+/** cosine and sine of the half angles, false for invalid limits*/
+template <class T> bool half_angles(const joint_limit<T> &l, T d[3], T h[6]) {
+  using std::cos;
+  using std::sin;
+  using std::sqrt;
+  const T pi = static_cast<T>(3.14159265358979323846);
+  const T half = static_cast<T>(0.5);
+  T n2 = l.axis[0] * l.axis[0] + l.axis[1] * l.axis[1] + l.axis[2] * l.axis[2];
+  if (n2 == static_cast<T>(0) || !(-pi <= l.twist_min) ||
+      !(l.twist_min <= l.twist_max) || !(l.twist_max <= pi) ||
+      !(static_cast<T>(0) <= l.swing_max) || !(l.swing_max <= pi))
+    return false;
+  T inv = static_cast<T>(1) / sqrt(n2);
+  for (unsigned int k = 0; k < 3; k++)
+    d[k] = l.axis[k] * inv;
+  h[0] = cos(half * l.twist_min);
+  h[1] = sin(half * l.twist_min);
+  h[2] = cos(half * l.twist_max);
+  h[3] = sin(half * l.twist_max);
+  h[4] = cos(half * l.swing_max);
+  h[5] = sin(half * l.swing_max);
+  return true;
+}
+
+} // namespace swing_detail
+
+/**
+  \brief splits the unit q into swing * twist, twist a rotation about
+  axis and swing one about an axis perpendicular to it. The axis need
+  not be normalized, ARG_ERROR if it is zero. If q turns by half a
+  turn about an axis perpendicular to axis the twist is the identity.
+ */
+template <class T>
+QUATERNION_FLAGS swing_twist(const quaternion<T> &q, const T axis[3],
+                             quaternion<T> &swing, quaternion<T> &twist) {
+  using std::sqrt;
+  T n2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+  if (n2 == static_cast<T>(0))
+    return ARG_ERROR;
+  T inv = static_cast<T>(1) / sqrt(n2);
+  T d[3] = {axis[0] * inv, axis[1] * inv, axis[2] * inv};
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  T tw, ts;
+  inv = static_cast<T>(1) / sqrt(swing_detail::twist_lane(c, d, tw, ts));
+  tw *= inv;
+  ts *= inv;
+  T s[4];
+  swing_detail::swing_lane(c, d, tw, ts, s);
+  swing = quaternion<T>(s[0], s[1], s[2], s[3]);
+  twist = quaternion<T>(tw, ts * d[0], ts * d[1], ts * d[2]);
+  return SUCCESS;
+}
+
+/**
+  \brief clamps the twist and the swing of the unit q to the limits
+  of one joint and recomposes them. A q within the limits comes back
+  unchanged up to rounding. ARG_ERROR for invalid limits.
+ */
+template <class T>
+QUATERNION_FLAGS clamp_swing_twist(const quaternion<T> &q,
+                                   const joint_limit<T> &limit,
+                                   quaternion<T> &out) {
+  using std::sqrt;
+  T d[3], h[6];
+  if (!swing_detail::half_angles(limit, d, h))
+    return ARG_ERROR;
+  T c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  T tw, ts, r2, s[4], o[4];
+  T inv = static_cast<T>(1) / sqrt(swing_detail::twist_lane(c, d, tw, ts));
+  tw *= inv;
+  ts *= inv;
+  swing_detail::swing_lane(c, d, tw, ts, s);
+  T sign = swing_detail::canonical_swing(s, r2);
+  sign *= swing_detail::clamp_twist(tw, ts, h[0], h[1], h[2], h[3]);
+  swing_detail::recompose_lane(s, sqrt(r2), h[4], h[5], d, tw, ts, sign, o);
+  out = quaternion<T>(o[0], o[1], o[2], o[3]);
+  return SUCCESS;
+}
+
+/**
+  \brief limits of all joints of a skeleton as structure of arrays,
+  with the axes normalized and the cosines and sines of the half
+  angles computed once.
+ */
+template <class T> class joint_limits {
+public:
+  std::size_t size() const { return axis[0].size(); }
+  /** appends one joint, ARG_ERROR for invalid limits*/
+  QUATERNION_FLAGS push_back(const joint_limit<T> &l) {
+    T d[3], h[6];
+    if (!swing_detail::half_angles(l, d, h))
+      return ARG_ERROR;
+    for (unsigned int k = 0; k < 3; k++)
+      axis[k].push_back(d[k]);
+    for (unsigned int k = 0; k < 6; k++)
+      half[k].push_back(h[k]);
+    return SUCCESS;
+  }
+  /** unit axis, component k of every joint*/
+  const T *axes(unsigned int k) const { return axis[k].data(); }
+  /**
+    cosine and sine of the half twist_min, twist_max and swing_max in
+    this order, k from 0 to 5
+   */
+  const T *half_angles(unsigned int k) const { return half[k].data(); }
+
+private:
+  std::vector<T> axis[3];
+  std::vector<T> half[6];
+};
+
+namespace swing_detail {
+
+template <class T>
+void decompose_block(const quaternion_batch<T> &pose,
+                     const joint_limits<T> &joints, std::size_t i0,
+                     std::size_t m, quaternion_batch<T> &swing,
+                     quaternion_batch<T> &twist) {
+  using std::sqrt;
+  const T one = static_cast<T>(1);
+  T tw[LANE_BLOCK], ts[LANE_BLOCK], n[LANE_BLOCK];
+  const T *w = pose.data(0) + i0, *x = pose.data(1) + i0,
+          *y = pose.data(2) + i0, *z = pose.data(3) + i0;
+  const T *dx = joints.axes(0) + i0, *dy = joints.axes(1) + i0,
+          *dz = joints.axes(2) + i0;
+  for (std::size_t i = 0; i < m; i++) {
+    T c[4] = {w[i], x[i], y[i], z[i]};
+    T d[3] = {dx[i], dy[i], dz[i]};
+    n[i] = twist_lane(c, d, tw[i], ts[i]);
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  T s[4][LANE_BLOCK], t[4][LANE_BLOCK];
+  for (std::size_t i = 0; i < m; i++) {
+    T inv = one / n[i];
+    T c[4] = {w[i], x[i], y[i], z[i]};
+    T d[3] = {dx[i], dy[i], dz[i]};
+    T a = tw[i] * inv, b = ts[i] * inv, p[4];
+    swing_lane(c, d, a, b, p);
+    for (unsigned int k = 0; k < 4; k++)
+      s[k][i] = p[k];
+    t[0][i] = a;
+    t[1][i] = b * d[0];
+    t[2][i] = b * d[1];
+    t[3][i] = b * d[2];
+  }
+  for (unsigned int k = 0; k < 4; k++) {
+    std::copy(s[k], s[k] + m, swing.data(k) + i0);
+    std::copy(t[k], t[k] + m, twist.data(k) + i0);
+  }
+}
+
+template <class T>
+void clamp_block(const quaternion_batch<T> &pose,
+                 const joint_limits<T> &joints, std::size_t i0,
+                 std::size_t m, quaternion_batch<T> &out) {
+  using std::sqrt;
+  const T one = static_cast<T>(1);
+  T tw[LANE_BLOCK], ts[LANE_BLOCK], n[LANE_BLOCK], sign[LANE_BLOCK];
+  T sw[LANE_BLOCK], sx[LANE_BLOCK], sy[LANE_BLOCK], sz[LANE_BLOCK];
+  const T *w = pose.data(0) + i0, *x = pose.data(1) + i0,
+          *y = pose.data(2) + i0, *z = pose.data(3) + i0;
+  const T *dx = joints.axes(0) + i0, *dy = joints.axes(1) + i0,
+          *dz = joints.axes(2) + i0;
+  const T *h[6];
+  for (unsigned int k = 0; k < 6; k++)
+    h[k] = joints.half_angles(k) + i0;
+  for (std::size_t i = 0; i < m; i++) {
+    T c[4] = {w[i], x[i], y[i], z[i]};
+    T d[3] = {dx[i], dy[i], dz[i]};
+    n[i] = twist_lane(c, d, tw[i], ts[i]);
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  for (std::size_t i = 0; i < m; i++) {
+    T inv = one / n[i];
+    T c[4] = {w[i], x[i], y[i], z[i]};
+    T d[3] = {dx[i], dy[i], dz[i]};
+    T a = tw[i] * inv, b = ts[i] * inv, p[4];
+    swing_lane(c, d, a, b, p);
+    sign[i] = canonical_swing(p, n[i]);
+    sign[i] *= clamp_twist(a, b, h[0][i], h[1][i], h[2][i], h[3][i]);
+    tw[i] = a;
+    ts[i] = b;
+    sw[i] = p[0];
+    sx[i] = p[1];
+    sy[i] = p[2];
+    sz[i] = p[3];
+  }
+  for (std::size_t i = 0; i < m; i++)
+    n[i] = sqrt(n[i]);
+  // out may be pose, written back only after the block is read
+  T ow[LANE_BLOCK], ox[LANE_BLOCK], oy[LANE_BLOCK], oz[LANE_BLOCK];
+  for (std::size_t i = 0; i < m; i++) {
+    T p[4] = {sw[i], sx[i], sy[i], sz[i]};
+    T d[3] = {dx[i], dy[i], dz[i]};
+    T o[4];
+    recompose_lane(p, n[i], h[4][i], h[5][i], d, tw[i], ts[i], sign[i], o);
+    ow[i] = o[0];
+    ox[i] = o[1];
+    oy[i] = o[2];
+    oz[i] = o[3];
+  }
+  std::copy(ow, ow + m, out.data(0) + i0);
+  std::copy(ox, ox + m, out.data(1) + i0);
+  std::copy(oy, oy + m, out.data(2) + i0);
+  std::copy(oz, oz + m, out.data(3) + i0);
+}
+
+} // namespace swing_detail
+
+/**
+  \brief swing_twist for every joint of a pose, about the axes of
+  joints. swing and twist are resized. SIZE_ERROR if pose and joints
+  differ in size.
+ */
+template <class T>
+QUATERNION_FLAGS swing_twist(const quaternion_batch<T> &pose,
+                             const joint_limits<T> &joints,
+                             quaternion_batch<T> &swing,
+                             quaternion_batch<T> &twist) {
+  const std::size_t n = pose.size();
+  if (joints.size() != n)
+    return SIZE_ERROR;
+  swing.resize(n);
+  twist.resize(n);
+  parallel_blocks(n, 1, LANE_BLOCK, [&](std::size_t i, std::size_t m) {
+    swing_detail::decompose_block(pose, joints, i, m, swing, twist);
+  });
+  return SUCCESS;
+}
+
+/**
+  \brief clamp_swing_twist for every joint of a pose in one pass. out
+  is resized and may be pose itself. SIZE_ERROR if pose and joints
+  differ in size.
+ */
+template <class T>
+QUATERNION_FLAGS clamp_swing_twist(const quaternion_batch<T> &pose,
+                                   const joint_limits<T> &joints,
+                                   quaternion_batch<T> &out) {
+  const std::size_t n = pose.size();
+  if (joints.size() != n)
+    return SIZE_ERROR;
+  out.resize(n);
+  parallel_blocks(n, 1, LANE_BLOCK, [&](std::size_t i, std::size_t m) {
+    swing_detail::clamp_block(pose, joints, i, m, out);
+  });
+  return SUCCESS;
+}
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,230 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_TABLE_HPP
+#define QUATERNION_TABLE_HPP
+#include "quaternion_allocator.hpp"
+#include "quaternion_unit.hpp"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace quat11 {
+
+/**
+  \brief Precomputed rotations about one axis for a set of angles.
+
+  Entries are stored as four contiguous coefficients in a cache line
+  aligned buffer, an entry never straddles two lines. nearest is a
+  plain load, slerp moves from the nearest entry by the remaining
+  angle with short polynomials for sin and cos of at most a quarter
+  of the step, so neither calls into trigonometric functions. slerp
+  is only as exact as those polynomials, see its error bound.
+
+  Tables are built either from a uniform grid or from a sorted set
+  of angles, all entries share the axis.
+ */
+template <class T> class rotation_table {
+public:
+  rotation_table()
+      : unit_axis{static_cast<T>(0), static_cast<T>(0), static_cast<T>(0)},
+        inv_step(static_cast<T>(0)), short_series(false) {}
+
+  /**
+    n angles spread evenly over [first, last], ARG_ERROR for a zero
+    axis, less than two angles or an empty range
+   */
+  static QUATERNION_FLAGS from_grid(const T axis[3], T first, T last,
+                                    std::size_t n, rotation_table &out) {
+    if (n < 2 || !(last > first))
+      return ARG_ERROR;
+    std::vector<T> angles(n);
+    T step = (last - first) / static_cast<T>(n - 1);
+    for (std::size_t k = 0; k < n - 1; k++)
+      angles[k] = first + static_cast<T>(k) * step;
+    angles[n - 1] = last;
+    auto res = from_angles(axis, angles, out);
+    if (res != SUCCESS)
+      return res;
+    out.inv_step = static_cast<T>(1) / step;
+    return SUCCESS;
+  }
+  /** angles have to be strictly increasing, ARG_ERROR otherwise*/
+  static QUATERNION_FLAGS from_angles(const T axis[3],
+                                      const std::vector<T> &angles,
+                                      rotation_table &out) {
+    if (angles.empty())
+      return ARG_ERROR;
+    for (std::size_t k = 1; k < angles.size(); k++)
+      if (!(angles[k] > angles[k - 1]))
+        return ARG_ERROR;
+    using std::sqrt;
+    T n2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (n2 == static_cast<T>(0))
+      return ARG_ERROR;
+    T inv_n = static_cast<T>(1) / sqrt(n2);
+    rotation_table t;
+    t.unit_axis[0] = axis[0] * inv_n;
+    t.unit_axis[1] = axis[1] * inv_n;
+    t.unit_axis[2] = axis[2] * inv_n;
+    t.angles = angles;
+    // the short series drops x^7 / 7!, keep it below the epsilon
+    T widest = static_cast<T>(0);
+    for (std::size_t k = 1; k < angles.size(); k++)
+      if (angles[k] - angles[k - 1] > widest)
+        widest = angles[k] - angles[k - 1];
+    T x = widest * static_cast<T>(0.25);
+    T x7 = x * x * x * x * x * x * x;
+    t.short_series =
+        x7 <= static_cast<T>(5040) * std::numeric_limits<T>::epsilon();
+    t.entries.resize(4 * angles.size());
+    for (std::size_t k = 0; k < angles.size(); k++) {
+      unit_quaternion<T> u;
+      auto res = unit_quaternion<T>::from_axis_angle(axis, angles[k], u);
+      if (res != SUCCESS)
+        return res;
+      T *e = t.entries.data() + 4 * k;
+      u.scalar(e[0]);
+      u.vector(e + 1);
+    }
+    out = t;
+    return SUCCESS;
+  }
+
+  std::size_t size() const { return angles.size(); }
+  T angle(std::size_t i) const { return angles[i]; }
+  /** four coefficients per entry, aligned to QUATERNION_CACHE_LINE*/
+  const T *data() const { return entries.data(); }
+
+  QUATERNION_FLAGS get(std::size_t i, quaternion<T> &out) const {
+    if (i >= size())
+      return INDEX_ERROR;
+    out = quaternion<T>(entries.data() + 4 * i);
+    return SUCCESS;
+  }
+  /** entry closest to angle, ARG_ERROR outside the table range*/
+  QUATERNION_FLAGS nearest(T angle, quaternion<T> &out) const {
+    std::size_t i = 0;
+    auto res = locate(angle, i);
+    if (res != SUCCESS)
+      return res;
+    return get(i, out);
+  }
+  /**
+    rotation by angle, the slerp between the two neighbouring entries.
+    The series are truncated, for a widest step h every coefficient is
+    off by about (h/4)^10 / 10! on top of rounding: 2.5e-5 for h = 2 pi,
+    2.5e-8 for h = pi, below the float epsilon from h = pi / 2 and below
+    the double epsilon from h = pi / 8. In float it costs about as much
+    as unit_quaternion::from_axis_angle, only in double is it faster.
+    ARG_ERROR outside the table range.
+   */
+  QUATERNION_FLAGS slerp(T angle, quaternion<T> &out) const {
+    std::size_t i = 0;
+    auto res = locate(angle, i);
+    if (res != SUCCESS)
+      return res;
+    T x = (angle - angles[i]) * static_cast<T>(0.5);
+    T x2 = x * x;
+    // Taylor series of sin and cos, |x| is at most a quarter of the
+    // widest step. Fine tables get by with the short series.
+    T s, c;
+    if (short_series) {
+      s = x * (static_cast<T>(1) +
+               x2 * (static_cast<T>(-1.0 / 6) +
+                     x2 * static_cast<T>(1.0 / 120)));
+      c = static_cast<T>(1) +
+          x2 * (static_cast<T>(-1.0 / 2) +
+                x2 * (static_cast<T>(1.0 / 24) +
+                      x2 * static_cast<T>(-1.0 / 720)));
+    } else {
+      s = x * (static_cast<T>(1) +
+               x2 * (static_cast<T>(-1.0 / 6) +
+                     x2 * (static_cast<T>(1.0 / 120) +
+                           x2 * (static_cast<T>(-1.0 / 5040) +
+                                 x2 * static_cast<T>(1.0 / 362880)))));
+      c = static_cast<T>(1) +
+          x2 * (static_cast<T>(-1.0 / 2) +
+                x2 * (static_cast<T>(1.0 / 24) +
+                      x2 * (static_cast<T>(-1.0 / 720) +
+                            x2 * static_cast<T>(1.0 / 40320))));
+    }
+    // e r for e and r about the same axis u: the cross product
+    // vanishes and e_v \cdot u is the sine part of e
+    const T *e = entries.data() + 4 * i;
+    T se = e[1] * unit_axis[0] + e[2] * unit_axis[1] + e[3] * unit_axis[2];
+    T ce = e[0] * s;
+    out = quaternion<T>(e[0] * c - se * s, e[1] * c + unit_axis[0] * ce,
+                        e[2] * c + unit_axis[1] * ce,
+                        e[3] * c + unit_axis[2] * ce);
+    return SUCCESS;
+  }
+
+private:
+  /** index of the entry closest to angle*/
+  QUATERNION_FLAGS locate(T angle, std::size_t &i) const {
+    const std::size_t n = size();
+    if (n == 0 || angle < angles[0] || angle > angles[n - 1])
+      return ARG_ERROR;
+    if (inv_step != static_cast<T>(0)) {
+      T u = (angle - angles[0]) * inv_step + static_cast<T>(0.5);
+      i = static_cast<std::size_t>(u);
+      if (i > n - 1)
+        i = n - 1;
+      return SUCCESS;
+    }
+    std::size_t hi = static_cast<std::size_t>(
+        std::upper_bound(angles.begin(), angles.end(), angle) - angles.begin());
+    if (hi == n) {
+      i = n - 1;
+      return SUCCESS;
+    }
+    i = angle - angles[hi - 1] < angles[hi] - angle ? hi - 1 : hi;
+    return SUCCESS;
+  }
+
+  std::vector<T, aligned_allocator<T>> entries;
+  std::vector<T> angles;
+  T unit_axis[3];
+  /** one over the grid step, zero for tables built from a set*/
+  T inv_step;
+  bool short_series;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,371 @@
+/*
+MIT License
+
+Copyright (c) 2021 Viva Lambda email
+<76657254+Viva-Lambda@users.noreply.github.com>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy
+of this software and associated documentation files (the
+"Software"), to deal
+in the Software without restriction, including without
+limitation the rights
+to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall
+be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUATERNION_UNIT_HPP
+#define QUATERNION_UNIT_HPP
+// include quaternion.h before this file if you use the
+// declaration/implementation split
+#ifndef QUATERNION_H
+#include "quaternion.hpp"
+#endif
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace quat11 {
+
+/**
+  Pull a nearly unit quaternion back onto the unit sphere with one
+  Newton step of the reciprocal square root around one. If
+  \f[|q|^2 = 1 + e\f] the result is off by at most \f[e^2\f].
+ */
+template <class T>
+QUATERNION_FLAGS reproject(const quaternion<T> &q, quaternion<T> &out) {
+  T c[4];
+  auto res = q.scalar(c[0]);
+  if (res != SUCCESS)
+    return res;
+  res = q.vector(c + 1);
+  if (res != SUCCESS)
+    return res;
+  T d = c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+  T f = (static_cast<T>(3) - d) * static_cast<T>(0.5);
+  out = quaternion<T>(c[0] * f, c[1] * f, c[2] * f, c[3] * f);
+  return SUCCESS;
+}
+
+namespace unit_detail {
+
+/**
+  a vector perpendicular to a, without branches: a crossed with x or
+  with z, whichever is further from a. Zero only for a zero a.
+ */
+template <class T> inline void orthogonal(const T a[3], T out[3]) {
+  using std::fabs;
+  std::int32_t x_larger = fabs(a[0]) > fabs(a[2]);
+  T k = static_cast<T>(x_larger);
+  out[0] = -k * a[1];
+  out[1] = k * a[0] - (static_cast<T>(1) - k) * a[2];
+  out[2] = (static_cast<T>(1) - k) * a[1];
+}
+
+/**
+  shortest arc from a to b given s = |a| |b|, unnormalized
+  \f[(s + a \cdot b, a \times b)\f], Bloom - Shortest arc
+  quaternion. Nearly opposite vectors blend in a half turn about a
+  vector perpendicular to a, a zero s gives the identity. Returns the
+  squared norm.
+
+  Rounding in s and a . b leaves w up to about 8 eps s off, while
+  a x b may come out exactly zero. Below 16 eps s the arc is within
+  rounding, so the half turn is taken. It turns a at most about
+  sqrt(32 eps) away from b, where the arc would err as much.
+ */
+template <class T>
+inline T two_vectors_lane(const T a[3], const T b[3], T s, T c[4]) {
+  const T eps = std::numeric_limits<T>::epsilon();
+  T w = s + a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  T v[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+  T o[3];
+  orthogonal(a, o);
+  std::int32_t near = w <= static_cast<T>(16) * eps * s;
+  std::int32_t zero = s == static_cast<T>(0);
+  T opposite = static_cast<T>(near * (1 - zero));
+  T keep = static_cast<T>(1 - near);
+  T none = static_cast<T>(zero);
+  c[0] = keep * w + none;
+  c[1] = keep * v[0] + opposite * o[0];
+  c[2] = keep * v[1] + opposite * o[1];
+  c[3] = keep * v[2] + opposite * o[2];
+  return c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+}
+
+/**
+  side axis up x f of a look at frame for a unit f, a vector
+  perpendicular to f if up is zero or parallel to f. Returns its
+  squared norm.
+ */
+template <class T>
+inline T look_at_side(const T f[3], const T up[3], T r[3]) {
+  const T eps = std::numeric_limits<T>::epsilon();
+  T x[3] = {up[1] * f[2] - up[2] * f[1], up[2] * f[0] - up[0] * f[2],
+            up[0] * f[1] - up[1] * f[0]};
+  T o[3];
+  orthogonal(f, o);
+  T up2 = up[0] * up[0] + up[1] * up[1] + up[2] * up[2];
+  T x2 = x[0] * x[0] + x[1] * x[1] + x[2] * x[2];
+  std::int32_t degenerate = x2 <= eps * up2;
+  T parallel = static_cast<T>(degenerate);
+  T keep = static_cast<T>(1 - degenerate);
+  for (unsigned int k = 0; k < 3; k++)
+    r[k] = keep * x[k] + parallel * o[k];
+  return r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+}
+
+/**
+  for the rotation with unit columns r, f x r and f, Shepperd 1978 -
+  Quaternion from rotation matrix: mask selects, without branches,
+  which of w x y z has the largest square, and that square times four
+  is returned. It is at least one.
+ */
+template <class T>
+inline T look_at_radicand(const T f[3], const T r[3], T mask[4]) {
+  const T one = static_cast<T>(1);
+  T u1 = f[2] * r[0] - f[0] * r[2];
+  // diagonal r[0], u1, f[2]
+  T t[4] = {one + r[0] + u1 + f[2], one + r[0] - u1 - f[2],
+            one - r[0] + u1 - f[2], one - r[0] - u1 + f[2]};
+  // running maximum, a later case replaces all earlier ones
+  std::int32_t g1 = t[1] > t[0];
+  T best = t[0] + static_cast<T>(g1) * (t[1] - t[0]);
+  std::int32_t g2 = t[2] > best;
+  best += static_cast<T>(g2) * (t[2] - best);
+  std::int32_t g3 = t[3] > best;
+  best += static_cast<T>(g3) * (t[3] - best);
+  T below2 = one - static_cast<T>(g3);
+  T below1 = below2 * (one - static_cast<T>(g2));
+  mask[0] = below1 * (one - static_cast<T>(g1));
+  mask[1] = below1 * static_cast<T>(g1);
+  mask[2] = below2 * static_cast<T>(g2);
+  mask[3] = static_cast<T>(g3);
+  return best;
+}
+
+/** coefficients from the selected case and the root of its radicand*/
+template <class T>
+inline void look_at_combine(const T f[3], const T r[3], const T mask[4], T root,
+                     T c[4]) {
+  const T half = static_cast<T>(0.5);
+  T u[3] = {f[1] * r[2] - f[2] * r[1], f[2] * r[0] - f[0] * r[2],
+            f[0] * r[1] - f[1] * r[0]};
+  // m = [r u f]: m21 - m12, m02 - m20, m10 - m01 and the sums
+  T d0 = u[2] - f[1], d1 = f[0] - r[2], d2 = r[1] - u[0];
+  T s01 = r[1] + u[0], s02 = r[2] + f[0], s12 = u[2] + f[1];
+  T h = half * root;
+  T g = half / root;
+  c[0] = mask[0] * h + g * (mask[1] * d0 + mask[2] * d1 + mask[3] * d2);
+  c[1] = mask[1] * h + g * (mask[0] * d0 + mask[2] * s01 + mask[3] * s02);
+  c[2] = mask[2] * h + g * (mask[0] * d1 + mask[1] * s01 + mask[3] * s12);
+  c[3] = mask[3] * h + g * (mask[0] * d2 + mask[1] * s02 + mask[2] * s12);
+}
+
+} // namespace unit_detail
+
+/**
+  \brief Quaternion of unit norm.
+
+  Most quaternions are rotations. Knowing that the norm is one, the
+  inverse is the conjugate, rotation needs no scaling and
+  normalization is at most a cheap re-projection. Conversion from a
+  general quaternion is explicit and only checked in debug builds,
+  use from_quaternion to normalize instead.
+ */
+template <class T> class unit_quaternion {
+public:
+  /** identity rotation*/
+  unit_quaternion()
+      : q(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0),
+          static_cast<T>(0)) {}
+
+  /** q has to be of unit norm, which is asserted in debug builds*/
+  explicit unit_quaternion(const quaternion<T> &p) : q(p) {
+#ifndef NDEBUG
+    T d = static_cast<T>(0);
+    q.det(d);
+    T e = d - static_cast<T>(1);
+    assert(e <= tolerance() && -e <= tolerance());
+#endif
+  }
+
+  /** largest deviation of the squared norm from one we accept*/
+  static T tolerance() { return static_cast<T>(1e-3); }
+
+  /** normalize a general quaternion*/
+  static QUATERNION_FLAGS from_quaternion(const quaternion<T> &p,
+                                          unit_quaternion &out) {
+    quaternion<T> n;
+    auto res = p.normalized(n);
+    if (res != SUCCESS)
+      return res;
+    out.q = n;
+    return SUCCESS;
+  }
+
+  /**
+    \brief rotation of angle radians around axis, from Vince 2011 -
+    Quaternions for Computer Graphics p. 83. The axis does not need
+    to be normalized.
+   */
+  static QUATERNION_FLAGS from_axis_angle(const T axis[3], T angle,
+                                          unit_quaternion &out) {
+    using std::cos;
+    using std::sin;
+    using std::sqrt;
+    T n2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (n2 == static_cast<T>(0))
+      return ARG_ERROR;
+    T half = angle * static_cast<T>(0.5);
+    T s = sin(half) / sqrt(n2);
+    out.q = quaternion<T>(cos(half), axis[0] * s, axis[1] * s, axis[2] * s);
+    return SUCCESS;
+  }
+
+  /**
+    \brief shortest rotation taking the direction of a onto the
+    direction of b. Opposite vectors give a half turn about some axis
+    perpendicular to a, chosen without branches. ARG_ERROR if a or b
+    is zero.
+   */
+  static QUATERNION_FLAGS from_two_vectors(const T a[3], const T b[3],
+                                           unit_quaternion &out) {
+    using std::sqrt;
+    T s = sqrt((a[0] * a[0] + a[1] * a[1] + a[2] * a[2]) *
+               (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]));
+    if (s == static_cast<T>(0))
+      return ARG_ERROR;
+    T c[4];
+    T inv = static_cast<T>(1) / sqrt(unit_detail::two_vectors_lane(a, b, s, c));
+    out.q = quaternion<T>(c[0] * inv, c[1] * inv, c[2] * inv, c[3] * inv);
+    return SUCCESS;
+  }
+
+  /**
+    \brief rotation taking the local z axis onto forward and the local
+    y axis onto the part of up perpendicular to forward, so local x is
+    up x forward. If up is zero or parallel to forward some
+    perpendicular up is used. ARG_ERROR for a zero forward.
+   */
+  static QUATERNION_FLAGS look_at(const T forward[3], const T up[3],
+                                  unit_quaternion &out) {
+    using std::sqrt;
+    T f2 = forward[0] * forward[0] + forward[1] * forward[1] +
+           forward[2] * forward[2];
+    if (f2 == static_cast<T>(0))
+      return ARG_ERROR;
+    T inv = static_cast<T>(1) / sqrt(f2);
+    T f[3] = {forward[0] * inv, forward[1] * inv, forward[2] * inv};
+    T r[3];
+    inv = static_cast<T>(1) / sqrt(unit_detail::look_at_side(f, up, r));
+    for (unsigned int k = 0; k < 3; k++)
+      r[k] *= inv;
+    T mask[4], c[4];
+    T root = sqrt(unit_detail::look_at_radicand(f, r, mask));
+    unit_detail::look_at_combine(f, r, mask, root, c);
+    out.q = quaternion<T>(c[0], c[1], c[2], c[3]);
+    return SUCCESS;
+  }
+
+  const quaternion<T> &get() const { return q; }
+  operator const quaternion<T> &() const { return q; }
+
+  QUATERNION_FLAGS scalar(T &out) const { return q.scalar(out); }
+  QUATERNION_FLAGS vector(T v[3]) const { return q.vector(v); }
+
+  /** product of two unit quaternions is a unit quaternion*/
+  QUATERNION_FLAGS hamilton_product(const unit_quaternion &p,
+                                    unit_quaternion &out) const {
+    return q.hamilton_product(p.q, out.q);
+  }
+  QUATERNION_FLAGS conjugate(unit_quaternion &out) const {
+    return q.conjugate(out.q);
+  }
+  /** the inverse of a unit quaternion is its conjugate*/
+  QUATERNION_FLAGS inversed(unit_quaternion &out) const {
+    return q.conjugate(out.q);
+  }
+  /**
+    Re-project onto the unit sphere after rounding drift with one
+    Newton step of the reciprocal square root around one, so there
+    is no sqrt and no division.
+   */
+  QUATERNION_FLAGS normalized(unit_quaternion &out) const {
+    return reproject(q, out.q);
+  }
+  /**
+    Rotate a vector without the scaling of quaternion::rotate, with
+    \f[v + 2 s (u \times v) + 2 u \times (u \times v)\f]
+   */
+  QUATERNION_FLAGS rotate(const T v[3], T out[3]) const {
+    T s = static_cast<T>(0);
+    auto res = q.scalar(s);
+    if (res != SUCCESS)
+      return res;
+    T u[3];
+    res = q.vector(u);
+    if (res != SUCCESS)
+      return res;
+    T t[3];
+    t[0] = static_cast<T>(2) * (u[1] * v[2] - u[2] * v[1]);
+    t[1] = static_cast<T>(2) * (u[2] * v[0] - u[0] * v[2]);
+    t[2] = static_cast<T>(2) * (u[0] * v[1] - u[1] * v[0]);
+    T r[3];
+    r[0] = v[0] + s * t[0] + (u[1] * t[2] - u[2] * t[1]);
+    r[1] = v[1] + s * t[1] + (u[2] * t[0] - u[0] * t[2]);
+    r[2] = v[2] + s * t[2] + (u[0] * t[1] - u[1] * t[0]);
+    out[0] = r[0];
+    out[1] = r[1];
+    out[2] = r[2];
+    return SUCCESS;
+  }
+
+  /** value returning api*/
+  unit_quaternion operator*(const unit_quaternion &p) const noexcept {
+    unit_quaternion out;
+    out.q = q * p.q;
+    return out;
+  }
+  unit_quaternion conjugate() const noexcept {
+    unit_quaternion out;
+    out.q = q.conjugate();
+    return out;
+  }
+  unit_quaternion inverse() const noexcept { return conjugate(); }
+  unit_quaternion normalize() const noexcept {
+    unit_quaternion out;
+    normalized(out);
+    return out;
+  }
+
+private:
+  quaternion<T> q;
+};
+
+} // namespace quat11
+
+#endif
@@ -0,0 +1,3 @@
+// the batch tests again in C++17, which also runs the execution policy
+// test of the batch iterators
+#include "test_quaternion_batch.cpp"
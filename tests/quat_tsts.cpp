@@ -668,6 +668,50 @@ CTEST(suite, test_inversed) {
   ASSERT_EQUAL(vec[1], static_cast<real>(static_cast<real>(1.0 / 33) * -3));
   ASSERT_EQUAL(vec[2], static_cast<real>(static_cast<real>(1.0 / 33) * 4));
 }
+CTEST(suite, test_inversed_1) {
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> inv;
+  q_a.inversed(inv);
+
+  quaternion<real> q_id;
+  q_a.hamilton_product(inv, q_id);
+
+  real s = static_cast<real>(0);
+  real vec[3];
+  q_id.scalar(s);
+  q_id.vector(vec);
+
+  ASSERT_DBL_NEAR(1.0, s);
+  ASSERT_DBL_NEAR(0.0, vec[0]);
+  ASSERT_DBL_NEAR(0.0, vec[1]);
+  ASSERT_DBL_NEAR(0.0, vec[2]);
+}
+/*! @} */
+
+/*! @{ Test rotation of a vector by quaternion, Vince 2011, p. 104 */
+CTEST(suite, test_rotate_0) {
+  // 90 degrees around z axis
+  real h = static_cast<real>(sqrt(0.5));
+  quaternion<real> q(h, 0, 0, h);
+  real v[3] = {1, 0, 0};
+  real out[3] = {0, 0, 0};
+  auto res = q.rotate(v, out);
+  ASSERT_EQUAL(res, SUCCESS);
+  ASSERT_DBL_NEAR(0.0, out[0]);
+  ASSERT_DBL_NEAR(1.0, out[1]);
+  ASSERT_DBL_NEAR(0.0, out[2]);
+}
+CTEST(suite, test_rotate_1) {
+  // scaling the quaternion does not change the rotation
+  quaternion<real> q(2, 0, 0, 2);
+  real v[3] = {1, 2, 3};
+  real out[3] = {0, 0, 0};
+  auto res = q.rotate(v, out);
+  ASSERT_EQUAL(res, SUCCESS);
+  ASSERT_DBL_NEAR(-2.0, out[0]);
+  ASSERT_DBL_NEAR(1.0, out[1]);
+  ASSERT_DBL_NEAR(3.0, out[2]);
+}
 /*! @} */
 
 /*! @{ Test normalization method of quaternion */
@@ -693,3 +737,80 @@ CTEST(suite, test_normalized) {
                static_cast<real>(static_cast<real>(1.0 / sqrt(33)) * -4));
 }
 /*! @} */
+
+/*! @{ Test value returning operators */
+CTEST(suite, test_value_product) {
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> q_b(1, -2, 5, -6);
+  quaternion<real> q_out = q_a * q_b;
+
+  real s = static_cast<real>(0);
+  real v[3];
+  q_out.scalar(s);
+  q_out.vector(v);
+  ASSERT_EQUAL(s, static_cast<real>(-41));
+  ASSERT_EQUAL(v[0], static_cast<real>(-4));
+  ASSERT_EQUAL(v[1], static_cast<real>(9));
+  ASSERT_EQUAL(v[2], static_cast<real>(-20));
+}
+CTEST(suite, test_value_add_subtract) {
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> q_b(1, -2, 5, -6);
+  quaternion<real> q_sum = q_a + q_b;
+  quaternion<real> q_diff = q_a - q_b;
+
+  real s = static_cast<real>(0);
+  real v[3];
+  q_sum.scalar(s);
+  q_sum.vector(v);
+  ASSERT_EQUAL(s, 3);
+  ASSERT_EQUAL(v[0], -4);
+  ASSERT_EQUAL(v[1], 8);
+  ASSERT_EQUAL(v[2], -10);
+
+  q_diff.scalar(s);
+  q_diff.vector(v);
+  ASSERT_EQUAL(s, 1);
+  ASSERT_EQUAL(v[0], 0);
+  ASSERT_EQUAL(v[1], -2);
+  ASSERT_EQUAL(v[2], 2);
+}
+CTEST(suite, test_value_negate_conjugate) {
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> q_neg = -q_a;
+  quaternion<real> q_conj = q_a.conjugate();
+
+  real s = static_cast<real>(0);
+  real v[3];
+  q_neg.scalar(s);
+  q_neg.vector(v);
+  ASSERT_EQUAL(s, -2);
+  ASSERT_EQUAL(v[0], 2);
+  ASSERT_EQUAL(v[1], -3);
+  ASSERT_EQUAL(v[2], 4);
+
+  q_conj.scalar(s);
+  q_conj.vector(v);
+  ASSERT_EQUAL(s, 2);
+  ASSERT_EQUAL(v[0], 2);
+  ASSERT_EQUAL(v[1], -3);
+  ASSERT_EQUAL(v[2], 4);
+}
+CTEST(suite, test_value_normalize_inverse) {
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> n = q_a.normalize();
+  real d = static_cast<real>(0);
+  n.det(d);
+  ASSERT_DBL_NEAR(1.0, d);
+
+  quaternion<real> q_id = q_a * q_a.inverse();
+  real s = static_cast<real>(0);
+  real v[3];
+  q_id.scalar(s);
+  q_id.vector(v);
+  ASSERT_DBL_NEAR(1.0, s);
+  ASSERT_DBL_NEAR(0.0, v[0]);
+  ASSERT_DBL_NEAR(0.0, v[1]);
+  ASSERT_DBL_NEAR(0.0, v[2]);
+}
+/*! @} */
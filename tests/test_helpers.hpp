@@ -0,0 +1,15 @@
+// helpers shared by the test files
+#ifndef QUATERNION_TEST_HELPERS_HPP
+#define QUATERNION_TEST_HELPERS_HPP
+#ifndef QUATERNION_H
+#include "../quaternion.hpp"
+#endif
+
+/** the four coefficients of q, scalar first*/
+template <class T>
+inline void coefficients(const quat11::quaternion<T> &q, T c[4]) {
+  q.scalar(c[0]);
+  q.vector(c + 1);
+}
+
+#endif
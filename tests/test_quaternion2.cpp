@@ -1,7 +1,6 @@
-
-#include "../quaternion.cpp"
+#include "../quaternion.h"
 
 typedef float real;
-template class quaternion<real>;
 
+// quaternion<float> comes from the quaternion library
 #include "quat_tsts.cpp"
@@ -0,0 +1,79 @@
+// test file for the aligned and arena allocators
+#include "../quaternion_allocator.hpp"
+#include "../quaternion_batch.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef float real;
+
+static bool line_aligned(const void *p) {
+  return reinterpret_cast<std::uintptr_t>(p) % QUATERNION_CACHE_LINE == 0;
+}
+
+CTEST(allocator, test_aligned_vector) {
+  std::vector<real, aligned_allocator<real>> v(13);
+  ASSERT_TRUE(line_aligned(v.data()));
+  v.resize(1000);
+  ASSERT_TRUE(line_aligned(v.data()));
+}
+CTEST(allocator, test_arena_bump_and_reset) {
+  quaternion_arena arena(1024);
+  ASSERT_EQUAL(arena.capacity(), 1024);
+  void *a = arena.allocate(10);
+  void *b = arena.allocate(100);
+  ASSERT_TRUE(line_aligned(a));
+  ASSERT_TRUE(line_aligned(b));
+  ASSERT_EQUAL(static_cast<unsigned char *>(b) -
+                   static_cast<unsigned char *>(a),
+               64);
+  ASSERT_EQUAL(arena.used(), 64 + 128);
+  arena.reset();
+  ASSERT_EQUAL(arena.used(), 0);
+  // the same memory again after reset
+  ASSERT_TRUE(arena.allocate(10) == a);
+}
+CTEST(allocator, test_arena_overflow_grows) {
+  quaternion_arena arena(256);
+  void *a = arena.allocate(200);
+  void *b = arena.allocate(1000);
+  ASSERT_TRUE(line_aligned(b));
+  ASSERT_TRUE(a != b);
+  ASSERT_EQUAL(arena.used(), 256 + 1024);
+  ASSERT_EQUAL(arena.capacity(), 256);
+  arena.reset();
+  // the next frame of the same size fits without overflow
+  ASSERT_EQUAL(arena.capacity(), 256 + 1024);
+  arena.allocate(200);
+  arena.allocate(1000);
+  ASSERT_EQUAL(arena.capacity(), 256 + 1024);
+  // an empty arena grows on the first reset too
+  quaternion_arena empty;
+  empty.allocate(1);
+  empty.reset();
+  ASSERT_EQUAL(empty.capacity(), 64);
+}
+CTEST(allocator, test_arena_batch) {
+  quaternion_arena arena(1 << 16);
+  typedef quaternion_batch<real, arena_allocator<real>> arena_batch;
+  for (int frame = 0; frame < 3; frame++) {
+    {
+      arena_allocator<real> alloc(arena);
+      arena_batch a(100, alloc), out(alloc);
+      out.reserve(100);
+      for (std::size_t i = 0; i < a.size(); i++)
+        a.set(i, quaternion<real>(1, 2, 3, static_cast<real>(i)));
+      ASSERT_EQUAL(a.hamilton_product(a, out), SUCCESS);
+      quaternion<real> q;
+      out.get(7, q);
+      real s = 0;
+      q.scalar(s);
+      ASSERT_DBL_NEAR(s, 1 - 4 - 9 - 49);
+      for (unsigned int k = 0; k < 4; k++)
+        ASSERT_TRUE(line_aligned(a.data(k)));
+      ASSERT_TRUE(a.get_allocator() == alloc);
+    }
+    ASSERT_EQUAL(arena.used(), 8 * 448);
+    arena.reset();
+  }
+  ASSERT_EQUAL(arena.capacity(), 1 << 16);
+}
@@ -0,0 +1,170 @@
+// test file for structure of arrays batches
+#include "../quaternion_batch.hpp"
+#include <algorithm>
+#include <ctest.h>
+#include <numeric>
+#if __cplusplus >= 201703L
+#include <execution>
+#endif
+
+using namespace quat11;
+typedef float real;
+
+static quaternion_batch<real> make_batch() {
+  quaternion_batch<real> b;
+  b.push_back(quaternion<real>(2, -2, 3, -4));
+  b.push_back(quaternion<real>(1, -2, 5, -6));
+  b.push_back(quaternion<real>(0.5f, 0.5f, 0.5f, 0.5f));
+  return b;
+}
+
+CTEST(batch, test_get_set) {
+  quaternion_batch<real> b = make_batch();
+  ASSERT_EQUAL(b.size(), 3);
+  quaternion<real> q;
+  ASSERT_EQUAL(b.get(3, q), INDEX_ERROR);
+  ASSERT_EQUAL(b.set(1, quaternion<real>(9, 8, 7, 6)), SUCCESS);
+  ASSERT_EQUAL(b.get(1, q), SUCCESS);
+  real s = 0;
+  q.scalar(s);
+  ASSERT_DBL_NEAR(s, 9);
+  ASSERT_DBL_NEAR(b.data(3)[1], 6);
+}
+CTEST(batch, test_inversed) {
+  quaternion_batch<real> b = make_batch();
+  quaternion_batch<real> inv;
+  ASSERT_EQUAL(b.inversed(inv), SUCCESS);
+  for (std::size_t i = 0; i < b.size(); i++) {
+    quaternion<real> q, qi, expected;
+    b.get(i, q);
+    inv.get(i, qi);
+    q.inversed(expected);
+    real e[4], a[4];
+    expected.scalar(e[0]);
+    expected.vector(e + 1);
+    qi.scalar(a[0]);
+    qi.vector(a + 1);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(e[k], a[k], 1e-6);
+  }
+}
+CTEST(batch, test_inversed_in_place) {
+  quaternion_batch<real> b = make_batch();
+  b.inversed(b);
+  b.inversed(b);
+  quaternion_batch<real> ref = make_batch();
+  for (unsigned int k = 0; k < 4; k++)
+    for (std::size_t i = 0; i < b.size(); i++)
+      ASSERT_DBL_NEAR_TOL(ref.data(k)[i], b.data(k)[i], 1e-5);
+}
+CTEST(batch, test_hamilton_product) {
+  quaternion_batch<real> a = make_batch();
+  quaternion_batch<real> b = make_batch();
+  b.conjugate(b);
+  quaternion_batch<real> out;
+  ASSERT_EQUAL(a.hamilton_product(b, out), SUCCESS);
+  for (std::size_t i = 0; i < a.size(); i++) {
+    quaternion<real> qa, qb, expected;
+    a.get(i, qa);
+    b.get(i, qb);
+    qa.hamilton_product(qb, expected);
+    real e = 0;
+    expected.scalar(e);
+    ASSERT_DBL_NEAR(e, out.data(0)[i]);
+  }
+  quaternion_batch<real> shorter(2);
+  ASSERT_EQUAL(a.hamilton_product(shorter, out), SIZE_ERROR);
+}
+CTEST(batch, test_relative) {
+  quaternion_batch<real> a = make_batch();
+  quaternion_batch<real> out;
+  ASSERT_EQUAL(a.relative(a, out), SUCCESS);
+  // a^{-1} a is the identity
+  for (std::size_t i = 0; i < a.size(); i++) {
+    ASSERT_DBL_NEAR_TOL(out.data(0)[i], 1, 1e-6);
+    ASSERT_DBL_NEAR_TOL(out.data(1)[i], 0, 1e-6);
+    ASSERT_DBL_NEAR_TOL(out.data(2)[i], 0, 1e-6);
+    ASSERT_DBL_NEAR_TOL(out.data(3)[i], 0, 1e-6);
+  }
+}
+CTEST(batch, test_iterators) {
+  quaternion_batch<real> b = make_batch();
+  ASSERT_EQUAL(b.end() - b.begin(), 3);
+  quaternion<real> q = b[1];
+  real s = 0;
+  q.scalar(s);
+  ASSERT_DBL_NEAR(s, 1);
+  b[2] = quaternion<real>(4, 3, 2, 1);
+  ASSERT_DBL_NEAR(b.data(1)[2], 3);
+  // elementwise products with a standard algorithm
+  quaternion_batch<real> out(b.size());
+  std::transform(b.cbegin(), b.cend(), b.begin(), out.begin(),
+                 [](const quaternion<real> &x, const quaternion<real> &y) {
+                   return x * y;
+                 });
+  quaternion_batch<real> expected;
+  b.hamilton_product(b, expected);
+  for (unsigned int k = 0; k < 4; k++)
+    for (std::size_t i = 0; i < b.size(); i++)
+      ASSERT_DBL_NEAR(out.data(k)[i], expected.data(k)[i]);
+  // proxies swap values
+  std::reverse(b.begin(), b.end());
+  ASSERT_DBL_NEAR(b.data(0)[0], 4);
+  ASSERT_DBL_NEAR(b.data(0)[2], 2);
+  quaternion_batch<real>::const_iterator it = b.begin();
+  it += 2;
+  ASSERT_TRUE(it == b.cend() - 1);
+  ASSERT_TRUE(b.cbegin() < it);
+}
+CTEST(batch, test_reduce_product) {
+  quaternion_batch<real> b;
+  quaternion<real> p;
+  ASSERT_EQUAL(b.reduce_product(p), SUCCESS);
+  real s = 0;
+  p.scalar(s);
+  ASSERT_DBL_NEAR(s, 1);
+  // over two trees of 1024 with a ragged tail, the order matters
+  for (std::size_t i = 0; i < 2500; i++) {
+    real a = 0.01f * static_cast<real>(i % 13);
+    b.push_back(quaternion<real>(1, a, -a * 0.5f, 0.02f).normalize());
+  }
+  quaternion<real> expected = std::accumulate(
+      b.begin(), b.end(), quaternion<real>(1, 0, 0, 0),
+      hamilton_multiplies<real>());
+  real e[4], a[4];
+  expected.scalar(e[0]);
+  expected.vector(e + 1);
+  // one run, fewer runs than blocks, one per block, more than blocks
+  // and hardware_concurrency
+  const unsigned int threads[5] = {1, 2, 3, 7, 0};
+  for (unsigned int t = 0; t < 5; t++) {
+    ASSERT_EQUAL(b.reduce_product(p, threads[t]), SUCCESS);
+    p.scalar(a[0]);
+    p.vector(a + 1);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(e[k], a[k], 1e-4);
+  }
+}
+#if __cplusplus >= 201703L
+CTEST(batch, test_parallel_algorithms) {
+  quaternion_batch<real> b;
+  for (std::size_t i = 0; i < 1000; i++)
+    b.push_back(quaternion<real>(1, 0.001f * static_cast<real>(i), 0, 0));
+  quaternion_batch<real> out(b.size());
+  std::transform(std::execution::par_unseq, b.begin(), b.end(), out.begin(),
+                 [](const quaternion<real> &q) { return q.conjugate(); });
+  for (std::size_t i = 0; i < b.size(); i++)
+    ASSERT_DBL_NEAR(out.data(1)[i], -b.data(1)[i]);
+  // prefix products only need associativity, the initial value
+  // keeps the scan on quaternion<T> instead of the proxy
+  std::inclusive_scan(std::execution::par, b.begin(), b.end(), out.begin(),
+                      hamilton_multiplies<real>(),
+                      quaternion<real>(1, 0, 0, 0));
+  quaternion<real> last = out[b.size() - 1], p;
+  b.reduce_product(p);
+  real e = 0, a = 0;
+  p.scalar(e);
+  last.scalar(a);
+  ASSERT_DBL_NEAR_TOL(e, a, 1e-3);
+}
+#endif
@@ -0,0 +1,94 @@
+// test file for point cloud rotation over memory mapped files
+#include "../quaternion_cloud.hpp"
+#include <ctest.h>
+#include <cstdio>
+#include <vector>
+
+using namespace quat11;
+typedef float real;
+
+/** a new empty temporary file, its path in name*/
+static void temporary(char name[32]) {
+  std::snprintf(name, 32, "/tmp/quat11_cloudXXXXXX");
+  int fd = mkstemp(name);
+  close(fd);
+}
+static void write_file(const char *name, const std::vector<real> &v) {
+  FILE *f = std::fopen(name, "wb");
+  std::fwrite(v.data(), sizeof(real), v.size(), f);
+  std::fclose(f);
+}
+static std::vector<real> read_file(const char *name) {
+  std::vector<real> v;
+  FILE *f = std::fopen(name, "rb");
+  real x;
+  while (std::fread(&x, sizeof(real), 1, f) == 1)
+    v.push_back(x);
+  std::fclose(f);
+  return v;
+}
+
+CTEST(cloud, test_rotate_points) {
+  // a quarter turn about z, not normalized
+  quaternion<real> q(2, 0, 0, 2);
+  const real p[6] = {1, 0, 0, 0, 2, 3}, t[3] = {10, 20, 30};
+  real o[6];
+  ASSERT_EQUAL(rotate_points(q, t, p, 2, o), SUCCESS);
+  const real e[6] = {10, 21, 30, 8, 20, 33};
+  for (unsigned int k = 0; k < 6; k++)
+    ASSERT_DBL_NEAR_TOL(o[k], e[k], 1e-5);
+  // in place without translation matches quaternion::rotate
+  real v[6] = {0.3f, -1.0f, 2.0f, 5.0f, 0.25f, -4.0f};
+  quaternion<real> r(0.9f, -0.2f, 0.3f, 0.1f);
+  ASSERT_EQUAL(rotate_points(r, static_cast<const real *>(nullptr), v, 2, v),
+               SUCCESS);
+  real a[3] = {0.3f, -1.0f, 2.0f}, b[3];
+  r.rotate(a, b);
+  for (unsigned int k = 0; k < 3; k++)
+    ASSERT_DBL_NEAR_TOL(v[k], b[k], 1e-5);
+  quaternion<real> zero(0, 0, 0, 0);
+  ASSERT_EQUAL(rotate_points(zero, t, p, 2, o), ARG_ERROR);
+}
+CTEST(cloud, test_rotate_file) {
+  // several chunks and a partial one, through both write paths
+  const std::size_t N = 5000;
+  std::vector<real> v(3 * N);
+  for (std::size_t i = 0; i < v.size(); i++)
+    v[i] = std::sin(0.01f * static_cast<real>(i));
+  char in[32], out[32];
+  temporary(in);
+  temporary(out);
+  write_file(in, v);
+  quaternion<real> q(0.5f, 0.5f, -0.5f, 0.5f);
+  const real t[3] = {1, -2, 0.5f};
+  std::vector<real> e(3 * N);
+  rotate_points(q, t, v.data(), N, e.data());
+  cloud_options options;
+  options.threads = 3;
+  options.chunk_points = 1500;
+  for (unsigned int direct = 0; direct < 2; direct++) {
+    options.direct = direct == 1;
+    int error = -1;
+    QUATERNION_FLAGS res = rotate_cloud_file(in, out, q, t, options, error);
+    // O_DIRECT is refused by some file systems such as tmpfs
+    if (options.direct && res == ARG_ERROR && error == EINVAL)
+      continue;
+    ASSERT_EQUAL(res, SUCCESS);
+    ASSERT_EQUAL(error, 0);
+    std::vector<real> r = read_file(out);
+    ASSERT_EQUAL(r.size(), e.size());
+    for (std::size_t i = 0; i < r.size(); i++)
+      ASSERT_DBL_NEAR_TOL(r[i], e[i], 1e-6);
+  }
+  int error = 0;
+  ASSERT_EQUAL(rotate_cloud_file(in, in, q, t, options, error), ARG_ERROR);
+  ASSERT_EQUAL(rotate_cloud_file("/nonexistent/cloud", out, q, t, options,
+                                 error),
+               ARG_ERROR);
+  ASSERT_EQUAL(error, ENOENT);
+  v.push_back(1);
+  write_file(in, v);
+  ASSERT_EQUAL(rotate_cloud_file(in, out, q, t, options, error), SIZE_ERROR);
+  std::remove(in);
+  std::remove(out);
+}
@@ -0,0 +1,80 @@
+// test file for compensated products and sums
+#include "../quaternion_compensated.hpp"
+#include <ctest.h>
+#include <vector>
+
+using namespace quat11;
+
+static double max_error(const quaternion<double> &a,
+                        const quaternion<double> &b) {
+  double ca[4], cb[4];
+  a.scalar(ca[0]);
+  a.vector(ca + 1);
+  b.scalar(cb[0]);
+  b.vector(cb + 1);
+  double e = 0;
+  for (unsigned int k = 0; k < 4; k++)
+    e = fabs(ca[k] - cb[k]) > e ? fabs(ca[k] - cb[k]) : e;
+  return e;
+}
+static quaternion<double> widen(const quaternion<float> &q) {
+  float c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  return quaternion<double>(c[0], c[1], c[2], c[3]);
+}
+
+CTEST(compensated, test_two_prod) {
+  float a = 1.0f + 1.0f / 4096;
+  float p, e;
+  compensated_detail::two_prod(a, a, p, e);
+  // (1 + 2^-12)^2 = 1 + 2^-11 + 2^-24, the last bit is lost in p
+  ASSERT_DBL_NEAR(static_cast<double>(p) + e,
+                  (1.0 + 1.0 / 4096) * (1.0 + 1.0 / 4096));
+  ASSERT_TRUE(e != 0.0f);
+}
+CTEST(compensated, test_product_chain) {
+  quaternion<float> step(0.99995f, 0.00577f, -0.00577f, 0.00577f);
+  quaternion<double> step_d = widen(step);
+  quaternion<float> plain(1, 0, 0, 0);
+  quaternion<double> ref(1, 0, 0, 0);
+  compensated_quaternion<float> comp(plain);
+  compensated_quaternion<float> comp_step(step);
+  for (unsigned int i = 0; i < 100000; i++) {
+    plain.hamilton_product(step, plain);
+    ref.hamilton_product(step_d, ref);
+    comp.hamilton_product(comp_step, comp);
+  }
+  quaternion<double> comp_d;
+  comp.widened(comp_d);
+  double plain_err = max_error(widen(plain), ref);
+  double comp_err = max_error(comp_d, ref);
+  ASSERT_TRUE(comp_err * 1000 < plain_err);
+  ASSERT_TRUE(comp_err < 1e-9);
+}
+CTEST(compensated, test_product_once) {
+  quaternion<float> a(1.1f, -2.3f, 3.7f, 0.3f);
+  quaternion<float> b(-0.7f, 1.9f, 2.9f, -4.1f);
+  quaternion<float> out;
+  ASSERT_EQUAL(compensated_product(a, b, out), SUCCESS);
+  quaternion<double> ref;
+  widen(a).hamilton_product(widen(b), ref);
+  // correctly rounded to float
+  ASSERT_TRUE(max_error(widen(out), ref) <= 8 * 6e-8);
+}
+CTEST(compensated, test_sum) {
+  std::vector<quaternion<float>> qs;
+  qs.push_back(quaternion<float>(1e8f, 1, -1e8f, 0));
+  for (unsigned int i = 0; i < 1000; i++)
+    qs.push_back(quaternion<float>(1, 0.001f, 1, 0.5f));
+  qs.push_back(quaternion<float>(-1e8f, 0, 1e8f, 0));
+  quaternion<float> out;
+  ASSERT_EQUAL(compensated_sum(qs.data(), qs.size(), out), SUCCESS);
+  float c[4];
+  out.scalar(c[0]);
+  out.vector(c + 1);
+  ASSERT_DBL_NEAR_TOL(c[0], 1000, 1e-3);
+  ASSERT_DBL_NEAR_TOL(c[1], 1 + 1000 * 0.001f, 1e-3);
+  ASSERT_DBL_NEAR_TOL(c[2], 1000, 1e-3);
+  ASSERT_DBL_NEAR_TOL(c[3], 500, 1e-3);
+}
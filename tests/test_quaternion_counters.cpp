@@ -0,0 +1,73 @@
+// test file for operation counters
+#define QUATERNION_ENABLE_COUNTERS
+#define QUATERNION_COUNT_CYCLES
+#include "../quaternion.hpp"
+#include <ctest.h>
+#include <thread>
+
+using namespace quat11;
+typedef float real;
+
+CTEST(counters, test_calls) {
+  counters::reset();
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> q_b(1, -2, 5, -6);
+  quaternion<real> q_out;
+  q_a.hamilton_product(q_b, q_out);
+  q_a.hamilton_product(q_b, q_out);
+  q_a.conjugate(q_out);
+
+  counters::snapshot s;
+  counters::collect(s);
+  ASSERT_EQUAL(s.calls[counters::OP_HAMILTON_PRODUCT], 2);
+  ASSERT_EQUAL(s.calls[counters::OP_CONJUGATE], 1);
+  ASSERT_TRUE(s.cycles[counters::OP_HAMILTON_PRODUCT] > 0);
+}
+CTEST(counters, test_nested_calls) {
+  counters::reset();
+  quaternion<real> q_a(2, -2, 3, -4);
+  quaternion<real> n;
+  // normalized calls norm, which calls det, and vector_multiplication.
+  // Only the outer call is counted.
+  q_a.normalized(n);
+
+  counters::snapshot s;
+  counters::collect(s);
+  ASSERT_EQUAL(s.calls[counters::OP_NORMALIZED], 1);
+  ASSERT_EQUAL(s.calls[counters::OP_NORM], 0);
+  ASSERT_EQUAL(s.calls[counters::OP_VECTOR_MULTIPLICATION], 0);
+}
+CTEST(counters, test_failures) {
+  counters::reset();
+  quaternion<real> q(2, 3, 3, 3);
+  quat_c<real> comp;
+  q.get_component(4, comp);
+  q.get_component(1, comp);
+  real out[3];
+  q.vector_division(static_cast<real>(0), out);
+
+  counters::snapshot s;
+  counters::collect(s);
+  ASSERT_EQUAL(s.calls[counters::OP_GET_COMPONENT], 2);
+  ASSERT_EQUAL(s.failures[counters::OP_GET_COMPONENT][ARG_ERROR], 1);
+  ASSERT_EQUAL(s.failures[counters::OP_VECTOR_DIVISION][ARG_ERROR], 1);
+}
+CTEST(counters, test_threads) {
+  counters::reset();
+  std::thread workers[4];
+  for (unsigned int i = 0; i < 4; i++) {
+    workers[i] = std::thread([]() {
+      quaternion<real> q(2, -2, 3, -4);
+      quaternion<real> n;
+      for (unsigned int j = 0; j < 100; j++)
+        q.normalized(n);
+    });
+  }
+  for (unsigned int i = 0; i < 4; i++)
+    workers[i].join();
+
+  // finished threads are kept in the merged totals
+  counters::snapshot s;
+  counters::collect(s);
+  ASSERT_EQUAL(s.calls[counters::OP_NORMALIZED], 400);
+}
@@ -0,0 +1,80 @@
+// test file for batched rotations from directions
+#include "../quaternion_direction.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef float real;
+
+CTEST(direction, test_batches_match_scalar) {
+  const std::size_t N = 203;
+  std::vector<real> a[3], b[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    a[k].resize(N);
+    b[k].resize(N);
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    real t = 0.37f * static_cast<real>(i);
+    a[0][i] = std::cos(t);
+    a[1][i] = std::sin(2 * t);
+    a[2][i] = 0.5f - 0.01f * static_cast<real>(i % 50);
+    // some opposite and some parallel pairs
+    real f = i % 5 == 0 ? -2.0f : i % 7 == 0 ? 3.0f : 0.0f;
+    b[0][i] = f != 0 ? f * a[0][i] : std::sin(t);
+    b[1][i] = f != 0 ? f * a[1][i] : 0.3f;
+    b[2][i] = f != 0 ? f * a[2][i] : std::cos(3 * t);
+  }
+  const real *ap[3] = {a[0].data(), a[1].data(), a[2].data()};
+  const real *bp[3] = {b[0].data(), b[1].data(), b[2].data()};
+  const real up[3] = {0, 0, 1};
+  quaternion_batch<real> arcs, looks;
+  ASSERT_EQUAL(from_two_vectors(ap, bp, N, arcs, 3), SUCCESS);
+  ASSERT_EQUAL(look_at(ap, up, N, looks, 2), SUCCESS);
+  ASSERT_EQUAL(arcs.size(), N);
+  for (std::size_t i = 0; i < N; i++) {
+    real u[3] = {a[0][i], a[1][i], a[2][i]};
+    real v[3] = {b[0][i], b[1][i], b[2][i]};
+    unit_quaternion<real> e;
+    unit_quaternion<real>::from_two_vectors(u, v, e);
+    quaternion<real> q;
+    arcs.get(i, q);
+    real x[4], y[4];
+    coefficients(e.get(), x);
+    coefficients(q, y);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(x[k], y[k], 1e-6);
+    unit_quaternion<real>::look_at(u, up, e);
+    looks.get(i, q);
+    coefficients(e.get(), x);
+    coefficients(q, y);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(x[k], y[k], 1e-6);
+  }
+}
+CTEST(direction, test_zero_vectors) {
+  real x[3] = {1, 0, 0}, y[3] = {0, 0, 2}, z[3] = {0, 1, 0};
+  const real *a[3] = {x, y, z};
+  real zx[3] = {1, 0, 1}, zy[3] = {0, 0, 0}, zz[3] = {0, 0, 0};
+  const real *b[3] = {zx, zy, zz};
+  quaternion_batch<real> out;
+  ASSERT_EQUAL(from_two_vectors(a, b, 3, out), ARG_ERROR);
+  // the zero lane is the identity, the others are still computed
+  ASSERT_DBL_NEAR(out.data(0)[1], 1);
+  ASSERT_DBL_NEAR(out.data(3)[1], 0);
+  real r[3];
+  quaternion<real> q;
+  out.get(2, q);
+  const real v[3] = {0, 1, 0};
+  unit_quaternion<real>(q).rotate(v, r);
+  ASSERT_DBL_NEAR_TOL(r[0], 1, 1e-6);
+  const real up[3] = {0, 1, 0};
+  ASSERT_EQUAL(look_at(b, up, 3, out), ARG_ERROR);
+  ASSERT_DBL_NEAR(out.data(0)[1], 1);
+  // the identity for any up vector
+  const real side[3] = {1, 0, 0};
+  ASSERT_EQUAL(look_at(b, side, 3, out), ARG_ERROR);
+  ASSERT_DBL_NEAR(out.data(0)[1], 1);
+  for (unsigned int k = 1; k < 4; k++)
+    ASSERT_DBL_NEAR(out.data(k)[1], 0);
+  ASSERT_EQUAL(look_at(a, up, 3, out), SUCCESS);
+}
@@ -0,0 +1,116 @@
+// test file for batched rotation distances and top-k search
+#include "../quaternion_distance.hpp"
+#include "../quaternion_random.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+// reference through conjugate, hamilton_product and the scalar part
+static real reference_angle(const quaternion<real> &p,
+                            const quaternion<real> &q) {
+  quaternion<real> conj, r;
+  p.conjugate(conj);
+  conj.hamilton_product(q, r);
+  real s = 0;
+  r.scalar(s);
+  s = fabs(s) > 1 ? 1 : fabs(s);
+  return 2 * acos(s);
+}
+
+CTEST(distance, test_one_vs_many) {
+  random_rotations<real> gen(3);
+  quaternion_batch<real> set;
+  gen.generate(1000, set);
+  quaternion<real> q;
+  gen.generate(5000, q);
+  std::vector<real> geo, chord, cosine;
+  ASSERT_EQUAL(distances(q, set, METRIC_GEODESIC, geo), SUCCESS);
+  ASSERT_EQUAL(distances(q, set, METRIC_CHORDAL, chord), SUCCESS);
+  ASSERT_EQUAL(distances(q * quaternion<real>(3, 0, 0, 0), set,
+                         METRIC_COSINE, cosine),
+               SUCCESS);
+  ASSERT_EQUAL(geo.size(), 1000);
+  for (std::size_t i = 0; i < set.size(); i++) {
+    quaternion<real> p;
+    set.get(i, p);
+    real angle = reference_angle(p, q);
+    ASSERT_DBL_NEAR_TOL(geo[i], angle, 1e-6);
+    ASSERT_DBL_NEAR_TOL(chord[i], 2 * sin(angle / 4), 1e-9);
+    ASSERT_DBL_NEAR_TOL(cosine[i], 1 - cos(angle / 2), 1e-9);
+  }
+  // -q is the same rotation
+  std::vector<real> neg;
+  distances(-q, set, METRIC_GEODESIC, neg);
+  for (std::size_t i = 0; i < set.size(); i++)
+    ASSERT_DBL_NEAR_TOL(neg[i], geo[i], 1e-12);
+  ASSERT_EQUAL(distances(quaternion<real>(0, 0, 0, 0), set, METRIC_GEODESIC,
+                         geo),
+               ARG_ERROR);
+}
+CTEST(distance, test_many_vs_many) {
+  random_rotations<real> gen(4);
+  quaternion_batch<real> a, b;
+  gen.generate(37, a);
+  gen.generate(1500, b, 100);
+  std::vector<real> one, many, threaded;
+  ASSERT_EQUAL(distances(a, b, METRIC_CHORDAL, many), SUCCESS);
+  ASSERT_EQUAL(distances(a, b, METRIC_CHORDAL, threaded, 4), SUCCESS);
+  ASSERT_EQUAL(many.size(), 37 * 1500);
+  for (std::size_t i = 0; i < a.size(); i++) {
+    quaternion<real> q;
+    a.get(i, q);
+    distances(q, b, METRIC_CHORDAL, one);
+    for (std::size_t j = 0; j < b.size(); j++) {
+      ASSERT_DBL_NEAR_TOL(many[i * b.size() + j], one[j], 1e-12);
+      ASSERT_DBL_NEAR_TOL(threaded[i * b.size() + j], one[j], 1e-12);
+    }
+  }
+}
+CTEST(distance, test_nearest_k) {
+  random_rotations<real> gen(5);
+  quaternion_batch<real> set;
+  gen.generate(3000, set);
+  quaternion<real> q;
+  gen.generate(9000, q);
+  std::vector<real> geo;
+  distances(q, set, METRIC_GEODESIC, geo);
+  std::vector<real> sorted = geo;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<orientation_neighbor<real>> out;
+  ASSERT_EQUAL(nearest_k(q, set, 10, out), SUCCESS);
+  ASSERT_EQUAL(out.size(), 10);
+  for (std::size_t j = 0; j < out.size(); j++) {
+    ASSERT_DBL_NEAR_TOL(out[j].angle, sorted[j], 1e-9);
+    ASSERT_DBL_NEAR_TOL(geo[out[j].index], sorted[j], 1e-9);
+  }
+  // k past the size returns everything, k of zero nothing
+  quaternion_batch<real> small;
+  gen.generate(3, small);
+  ASSERT_EQUAL(nearest_k(q, small, 10, out), SUCCESS);
+  ASSERT_EQUAL(out.size(), 3);
+  ASSERT_EQUAL(nearest_k(q, small, 0, out), SUCCESS);
+  ASSERT_EQUAL(out.size(), 0);
+}
+CTEST(distance, test_nearest_k_batch) {
+  random_rotations<real> gen(6);
+  quaternion_batch<real> set, queries;
+  gen.generate(2000, set);
+  gen.generate(50, queries, 10000);
+  std::vector<std::vector<orientation_neighbor<real>>> out;
+  ASSERT_EQUAL(nearest_k(queries, set, 5, out, 3), SUCCESS);
+  ASSERT_EQUAL(out.size(), 50);
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    quaternion<real> q;
+    queries.get(i, q);
+    std::vector<orientation_neighbor<real>> one;
+    nearest_k(q, set, 5, one);
+    ASSERT_EQUAL(out[i].size(), 5);
+    for (std::size_t j = 0; j < 5; j++)
+      ASSERT_EQUAL(out[i][j].index, one[j].index);
+  }
+  queries.set(7, quaternion<real>(0, 0, 0, 0));
+  ASSERT_EQUAL(nearest_k(queries, set, 5, out, 3), ARG_ERROR);
+  ASSERT_EQUAL(out[7].size(), 0);
+  ASSERT_EQUAL(out[8].size(), 5);
+}
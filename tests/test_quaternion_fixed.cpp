@@ -0,0 +1,170 @@
+// test file for fixed point quaternion
+#include "../quaternion_fixed.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+
+/*! @{ Test Q1.30 scalar arithmetic */
+CTEST(fixed, test_conversion) {
+  q1_30 a(1);
+  ASSERT_EQUAL(a.raw, 1 << 30);
+  q1_30 b(-0.5);
+  ASSERT_EQUAL(b.raw, -(1 << 29));
+  ASSERT_DBL_NEAR(-0.5, b.to_double());
+}
+CTEST(fixed, test_arithmetic) {
+  q1_30 a(0.75);
+  q1_30 b(0.5);
+  ASSERT_DBL_NEAR(1.25, (a + b).to_double());
+  ASSERT_DBL_NEAR(0.25, (a - b).to_double());
+  ASSERT_DBL_NEAR(0.375, (a * b).to_double());
+  ASSERT_DBL_NEAR(1.5, (a / b).to_double());
+  ASSERT_TRUE(-a == q1_30(-0.75));
+}
+CTEST(fixed, test_product_rounding) {
+  // 3 * 2^-30 times 0.5 is 1.5 * 2^-30 which rounds up
+  q1_30 a = q1_30::from_raw(3);
+  q1_30 b(0.5);
+  ASSERT_EQUAL((a * b).raw, 2);
+}
+CTEST(fixed, test_division_by_zero) {
+  q1_30 a(-0.25);
+  ASSERT_EQUAL((a / q1_30(0)).raw, INT32_MIN);
+}
+CTEST(fixed, test_sqrt) {
+  ASSERT_DBL_NEAR(0.5, sqrt(q1_30(0.25)).to_double());
+  ASSERT_DBL_NEAR(4.0 / 3.0, rsqrt(q1_30(0.5625)).to_double());
+  ASSERT_DBL_NEAR(1.0, rsqrt(q1_30(1)).to_double());
+}
+/*! @} */
+
+/*! @{ Test quaternion operations on Q1.30 */
+CTEST(fixed, test_hamilton_product) {
+  quaternion<q1_30> q_a(q1_30(0.5), q1_30(-0.5), q1_30(0.25), q1_30(-0.125));
+  quaternion<q1_30> q_b(q1_30(0.25), q1_30(0.5), q1_30(-0.75), q1_30(0.5));
+  quaternion<q1_30> q_out;
+  auto res = q_a.hamilton_product(q_b, q_out);
+  ASSERT_EQUAL(res, SUCCESS);
+
+  quaternion<double> d_a(0.5, -0.5, 0.25, -0.125);
+  quaternion<double> d_b(0.25, 0.5, -0.75, 0.5);
+  quaternion<double> d_out;
+  d_a.hamilton_product(d_b, d_out);
+
+  q1_30 s;
+  q1_30 v[3];
+  q_out.scalar(s);
+  q_out.vector(v);
+  double ds = 0;
+  double dv[3];
+  d_out.scalar(ds);
+  d_out.vector(dv);
+  // all inputs are dyadic so the result is exact
+  ASSERT_TRUE(s == q1_30(ds));
+  ASSERT_TRUE(v[0] == q1_30(dv[0]));
+  ASSERT_TRUE(v[1] == q1_30(dv[1]));
+  ASSERT_TRUE(v[2] == q1_30(dv[2]));
+}
+CTEST(fixed, test_value_product) {
+  quaternion<q1_30> q_a(q1_30(0.3), q1_30(-0.1), q1_30(0.7), q1_30(-0.2));
+  quaternion<q1_30> q_b(q1_30(0.6), q1_30(0.4), q1_30(-0.3), q1_30(0.1));
+  quaternion<q1_30> q_flags;
+  q_a.hamilton_product(q_b, q_flags);
+  quaternion<q1_30> q_value = q_a * q_b;
+
+  q1_30 f[3];
+  q1_30 v[3];
+  q_flags.vector(f);
+  q_value.vector(v);
+  // both apis use the same fused kernel
+  ASSERT_EQUAL(f[0].raw, v[0].raw);
+  ASSERT_EQUAL(f[1].raw, v[1].raw);
+  ASSERT_EQUAL(f[2].raw, v[2].raw);
+}
+CTEST(fixed, test_normalized) {
+  quaternion<q1_30> q(q1_30(0.02), q1_30(-0.02), q1_30(0.03), q1_30(-0.04));
+  quaternion<q1_30> n;
+  auto res = q.normalized(n);
+  ASSERT_EQUAL(res, SUCCESS);
+
+  q1_30 s;
+  q1_30 v[3];
+  n.scalar(s);
+  n.vector(v);
+  double inv = 1.0 / sqrt(33.0);
+  ASSERT_DBL_NEAR_TOL(2 * inv, s.to_double(), 1e-8);
+  ASSERT_DBL_NEAR_TOL(-2 * inv, v[0].to_double(), 1e-8);
+  ASSERT_DBL_NEAR_TOL(3 * inv, v[1].to_double(), 1e-8);
+  ASSERT_DBL_NEAR_TOL(-4 * inv, v[2].to_double(), 1e-8);
+}
+CTEST(fixed, test_normalized_large) {
+  // the squares sum to 2^64 in Q60
+  quaternion<q1_30> q(q1_30(-2), q1_30(-2), q1_30(-2), q1_30(-2));
+  quaternion<q1_30> n;
+  ASSERT_EQUAL(q.normalized(n), SUCCESS);
+  q1_30 s;
+  q1_30 v[3];
+  n.scalar(s);
+  n.vector(v);
+  ASSERT_DBL_NEAR_TOL(-0.5, s.to_double(), 1e-8);
+  for (unsigned int i = 0; i < 3; i++)
+    ASSERT_DBL_NEAR_TOL(-0.5, v[i].to_double(), 1e-8);
+  // just below, still in Q60
+  q1_30 m = q1_30::from_raw(INT32_MIN + 1);
+  quaternion<q1_30> p(m, m, m, m);
+  ASSERT_EQUAL(p.normalized(n), SUCCESS);
+  n.scalar(s);
+  ASSERT_DBL_NEAR_TOL(-0.5, s.to_double(), 1e-8);
+  // tiny components keep the low bits
+  q1_30 one = q1_30::from_raw(1);
+  quaternion<q1_30> t(one, q1_30(), q1_30(), q1_30());
+  ASSERT_EQUAL(t.normalized(n), SUCCESS);
+  n.scalar(s);
+  ASSERT_DBL_NEAR_TOL(1.0, s.to_double(), 1e-8);
+}
+CTEST(fixed, test_normalized_zero) {
+  quaternion<q1_30> q(q1_30(0), q1_30(0), q1_30(0), q1_30(0));
+  quaternion<q1_30> n;
+  ASSERT_EQUAL(q.normalized(n), ARG_ERROR);
+}
+CTEST(fixed, test_rotate) {
+  // 90 degrees around z axis
+  q1_30 h(sqrt(0.5));
+  quaternion<q1_30> q(h, q1_30(0), q1_30(0), h);
+  q1_30 v[3] = {q1_30(0.5), q1_30(0.25), q1_30(0)};
+  q1_30 out[3];
+  auto res = q.rotate(v, out);
+  ASSERT_EQUAL(res, SUCCESS);
+  ASSERT_DBL_NEAR_TOL(-0.25, out[0].to_double(), 1e-8);
+  ASSERT_DBL_NEAR_TOL(0.5, out[1].to_double(), 1e-8);
+  ASSERT_DBL_NEAR_TOL(0.0, out[2].to_double(), 1e-8);
+}
+CTEST(fixed, test_determinism) {
+  // long product chains are reproducible bit by bit
+  q1_30 h(sqrt(0.5));
+  quaternion<q1_30> step(q1_30(0.99), q1_30(0.1), q1_30(0.05), q1_30(0.02));
+  step.normalized(step);
+  quaternion<q1_30> acc1(h, q1_30(0), h, q1_30(0));
+  quaternion<q1_30> acc2 = acc1;
+  for (unsigned int i = 0; i < 1000; i++) {
+    acc1.hamilton_product(step, acc1);
+    acc1.normalized(acc1);
+    acc2.hamilton_product(step, acc2);
+    acc2.normalized(acc2);
+  }
+  q1_30 s1;
+  q1_30 c1[3];
+  q1_30 c2[3];
+  acc1.scalar(s1);
+  acc1.vector(c1);
+  acc2.vector(c2);
+  ASSERT_EQUAL(c1[0].raw, c2[0].raw);
+  ASSERT_EQUAL(c1[1].raw, c2[1].raw);
+  ASSERT_EQUAL(c1[2].raw, c2[2].raw);
+  // integer only arithmetic, the same bits on every platform
+  ASSERT_EQUAL(s1.raw, 22738412);
+  ASSERT_EQUAL(c1[0].raw, 725050387);
+  ASSERT_EQUAL(c1[1].raw, 626947135);
+  ASSERT_EQUAL(c1[2].raw, -483367042);
+}
+/*! @} */
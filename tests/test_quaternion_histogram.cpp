@@ -0,0 +1,114 @@
+// test file for orientation histograms
+#include "../quaternion_histogram.hpp"
+#include "../quaternion_random.hpp"
+#include <ctest.h>
+#include <thread>
+
+using namespace quat11;
+typedef float real;
+
+CTEST(histogram, test_grid) {
+  so3_grid<real> g;
+  ASSERT_EQUAL(so3_grid<real>::from_resolution(0, g), ARG_ERROR);
+  ASSERT_EQUAL(so3_grid<real>::from_resolution(1024, g), ARG_ERROR);
+  ASSERT_EQUAL(so3_grid<real>::from_resolution(5, g), SUCCESS);
+  ASSERT_EQUAL(g.size(), 500);
+  std::uint32_t b = 0, nb = 0;
+  ASSERT_EQUAL(g.bin(quaternion<real>(0.3f, -0.5f, 0.7f, 0.1f), b), SUCCESS);
+  // q and -q are the same rotation
+  ASSERT_EQUAL(g.bin(quaternion<real>(-0.3f, 0.5f, -0.7f, -0.1f), nb), SUCCESS);
+  ASSERT_EQUAL(b, nb);
+  // scale does not matter
+  ASSERT_EQUAL(g.bin(quaternion<real>(3, -5, 7, 1), nb), SUCCESS);
+  ASSERT_EQUAL(b, nb);
+  ASSERT_EQUAL(g.bin(quaternion<real>(0, 0, 0, 0), nb), ARG_ERROR);
+}
+CTEST(histogram, test_centers) {
+  so3_grid<real> g;
+  so3_grid<real>::from_resolution(6, g);
+  for (std::uint32_t b = 0; b < g.size(); b++) {
+    quaternion<real> c;
+    ASSERT_EQUAL(g.center(b, c), SUCCESS);
+    std::uint32_t back = 0;
+    g.bin(c, back);
+    ASSERT_EQUAL(back, b);
+  }
+  quaternion<real> c;
+  ASSERT_EQUAL(g.center(static_cast<std::uint32_t>(g.size()), c), INDEX_ERROR);
+}
+CTEST(histogram, test_max_resolution) {
+  // 4 n^3 passes 2^31, bins must not wrap
+  so3_grid<real> g;
+  ASSERT_EQUAL(so3_grid<real>::from_resolution(so3_grid<real>::MAX_RESOLUTION,
+                                               g),
+               SUCCESS);
+  quaternion_batch<real> b;
+  for (unsigned int i = 0; i < 200; i++) {
+    real t = 0.37f * static_cast<real>(i);
+    b.push_back(quaternion<real>(std::cos(t), std::sin(3 * t), 0.2f,
+                                 std::cos(2 * t) * 3));
+  }
+  b.push_back(quaternion<real>(0.01f, 0.02f, 0.03f, 1));
+  b.push_back(quaternion<real>(-0.99f, 0.98f, 0.97f, 1));
+  std::vector<std::uint32_t> bins;
+  ASSERT_EQUAL(g.bin(b, bins), SUCCESS);
+  bool high = false;
+  for (std::size_t i = 0; i < bins.size(); i++) {
+    ASSERT_TRUE(bins[i] < g.size());
+    high = high || bins[i] >= 0x80000000u;
+  }
+  ASSERT_TRUE(high);
+  std::uint32_t last = static_cast<std::uint32_t>(g.size() - 1), back = 0;
+  quaternion<real> c;
+  ASSERT_EQUAL(g.center(last, c), SUCCESS);
+  g.bin(c, back);
+  ASSERT_EQUAL(back, last);
+  ASSERT_EQUAL(g.bin(quaternion<real>(0, 0, 0, 0), back), ARG_ERROR);
+  ASSERT_EQUAL(back, static_cast<std::uint32_t>(g.size()));
+}
+CTEST(histogram, test_near_uniform) {
+  so3_grid<real> g;
+  so3_grid<real>::from_resolution(4, g);
+  random_rotations<real> gen(9);
+  quaternion_batch<real> b;
+  gen.generate(1000000, b);
+  so3_histogram h(g.size());
+  ASSERT_EQUAL(h.add(g, b), SUCCESS);
+  std::uint64_t lo = h.values()[0], hi = h.values()[0], total = 0;
+  for (std::size_t i = 0; i < h.size(); i++) {
+    lo = h.values()[i] < lo ? h.values()[i] : lo;
+    hi = h.values()[i] > hi ? h.values()[i] : hi;
+    total += h.values()[i];
+  }
+  ASSERT_EQUAL(total, 1000000);
+  ASSERT_TRUE(hi < 2 * lo);
+}
+CTEST(histogram, test_threads_merge) {
+  so3_grid<real> g;
+  so3_grid<real>::from_resolution(3, g);
+  random_rotations<real> gen(10);
+  quaternion_batch<real> all;
+  gen.generate(40000, all);
+  so3_histogram serial(g.size());
+  serial.add(g, all);
+
+  shared_so3_histogram total(g.size());
+  std::thread workers[4];
+  for (unsigned int t = 0; t < 4; t++) {
+    workers[t] = std::thread([&, t]() {
+      quaternion_batch<real> part;
+      gen.generate(10000, part, 10000 * t);
+      so3_histogram local(g.size());
+      local.add(g, part);
+      local.merge_into(total);
+    });
+  }
+  for (unsigned int t = 0; t < 4; t++)
+    workers[t].join();
+  std::vector<std::uint64_t> merged;
+  total.snapshot(merged);
+  for (std::size_t i = 0; i < g.size(); i++)
+    ASSERT_EQUAL(merged[i], serial.values()[i]);
+  so3_histogram wrong(7);
+  ASSERT_EQUAL(wrong.merge_into(total), SIZE_ERROR);
+}
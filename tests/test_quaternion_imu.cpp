@@ -0,0 +1,129 @@
+// test file for the Madgwick and Mahony filters
+#include "../quaternion_imu.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+/** gravity direction in the sensor frame the orientation predicts*/
+static void predicted_up(const quaternion<real> &q, real up[3]) {
+  real c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  up[0] = 2 * (c[1] * c[3] - c[0] * c[2]);
+  up[1] = 2 * (c[0] * c[1] + c[2] * c[3]);
+  up[2] = c[0] * c[0] - c[1] * c[1] - c[2] * c[2] + c[3] * c[3];
+}
+
+CTEST(imu, test_madgwick_converges_to_gravity) {
+  madgwick_filter<real> f(0.5);
+  real gyro[3] = {0, 0, 0};
+  // the sensor is tilted, gravity shows up partly on y
+  real accel[3] = {0, 4.9, 8.5};
+  for (int i = 0; i < 2000; i++)
+    ASSERT_EQUAL(f.update(gyro, accel, 0.01), SUCCESS);
+  real up[3];
+  predicted_up(f.orientation(), up);
+  real n =
+      sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+  // the normalized gradient step keeps moving by about beta dt
+  for (unsigned int k = 0; k < 3; k++)
+    ASSERT_DBL_NEAR_TOL(up[k], accel[k] / n, 1e-2);
+}
+CTEST(imu, test_mahony_converges_and_learns_bias) {
+  mahony_filter<real> f(2, 0.5);
+  real gyro[3] = {0.02, -0.01, 0};
+  real accel[3] = {-3, 0, 9};
+  for (int i = 0; i < 20000; i++)
+    ASSERT_EQUAL(f.update(gyro, accel, 0.01), SUCCESS);
+  real up[3];
+  predicted_up(f.orientation(), up);
+  real n =
+      sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+  for (unsigned int k = 0; k < 3; k++)
+    ASSERT_DBL_NEAR_TOL(up[k], accel[k] / n, 1e-3);
+  // the integral cancels the rate that gravity can observe
+  real bias[3];
+  f.bias_correction(bias);
+  real along = (gyro[0] + bias[0]) * accel[0] / n +
+               (gyro[2] + bias[2]) * accel[2] / n;
+  ASSERT_DBL_NEAR_TOL(gyro[1] + bias[1], 0, 1e-3);
+  ASSERT_DBL_NEAR_TOL(gyro[0] + bias[0] - along * accel[0] / n, 0, 1e-3);
+}
+CTEST(imu, test_gyro_only) {
+  // no accel, one second at pi/2 rad/s about z is a quarter turn
+  madgwick_filter<real> mg;
+  mahony_filter<real> mh;
+  real gyro[3] = {0, 0, 1.5707963267948966};
+  real accel[3] = {0, 0, 0};
+  for (int i = 0; i < 1000; i++) {
+    mg.update(gyro, accel, 0.001);
+    mh.update(gyro, accel, 0.001);
+  }
+  real w = 0;
+  mg.orientation().scalar(w);
+  ASSERT_DBL_NEAR_TOL(w, cos(3.14159265358979 / 4), 1e-5);
+  mh.orientation().scalar(w);
+  ASSERT_DBL_NEAR_TOL(w, cos(3.14159265358979 / 4), 1e-5);
+}
+CTEST(imu, test_batches_match_scalar) {
+  const std::size_t N = 150;
+  madgwick_batch<real> mb(N, 0.2);
+  mahony_batch<real> hb(N, 1.5, 0.1);
+  std::vector<madgwick_filter<real>> ms(N, madgwick_filter<real>(0.2));
+  std::vector<mahony_filter<real>> hs(N, mahony_filter<real>(1.5, 0.1));
+  std::vector<real> g[3], a[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    g[k].resize(N);
+    a[k].resize(N);
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> q0(1, 0.01 * static_cast<real>(i % 7), -0.2, 0.1);
+    ASSERT_EQUAL(mb.set_orientation(i, q0), SUCCESS);
+    hb.set_orientation(i, q0);
+    ms[i].set_orientation(q0);
+    hs[i].set_orientation(q0);
+  }
+  ASSERT_EQUAL(mb.set_orientation(N, quaternion<real>(1, 0, 0, 0)),
+               INDEX_ERROR);
+  for (int step = 0; step < 50; step++) {
+    for (std::size_t i = 0; i < N; i++) {
+      real t = static_cast<real>(step) * 0.01 + static_cast<real>(i) * 0.001;
+      g[0][i] = 0.3 * sin(t);
+      g[1][i] = -0.2;
+      g[2][i] = 0.1 * cos(3 * t);
+      // every tenth lane has no accel reading
+      a[0][i] = i % 10 == 0 ? 0 : 0.5;
+      a[1][i] = i % 10 == 0 ? 0 : -1.0 + t;
+      a[2][i] = i % 10 == 0 ? 0 : 9.7;
+    }
+    const real *gp[3] = {g[0].data(), g[1].data(), g[2].data()};
+    const real *ap[3] = {a[0].data(), a[1].data(), a[2].data()};
+    ASSERT_EQUAL(mb.update(gp, ap, 0.01, step % 2 ? 3 : 1), SUCCESS);
+    ASSERT_EQUAL(hb.update(gp, ap, 0.01, 2), SUCCESS);
+    for (std::size_t i = 0; i < N; i++) {
+      real gi[3] = {g[0][i], g[1][i], g[2][i]};
+      real ai[3] = {a[0][i], a[1][i], a[2][i]};
+      ms[i].update(gi, ai, 0.01);
+      hs[i].update(gi, ai, 0.01);
+    }
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> bq, hq;
+    mb.orientations().get(i, bq);
+    hb.orientations().get(i, hq);
+    real b[4], s[4], h[4], t[4];
+    bq.scalar(b[0]);
+    bq.vector(b + 1);
+    ms[i].orientation().scalar(s[0]);
+    ms[i].orientation().vector(s + 1);
+    hq.scalar(h[0]);
+    hq.vector(h + 1);
+    hs[i].orientation().scalar(t[0]);
+    hs[i].orientation().vector(t + 1);
+    for (unsigned int k = 0; k < 4; k++) {
+      ASSERT_DBL_NEAR_TOL(b[k], s[k], 1e-12);
+      ASSERT_DBL_NEAR_TOL(h[k], t[k], 1e-12);
+    }
+  }
+}
@@ -0,0 +1,113 @@
+// test file for the orientation nearest neighbor index
+#include "../quaternion_index.hpp"
+#include "../quaternion_random.hpp"
+#include <ctest.h>
+#include <thread>
+
+using namespace quat11;
+typedef double real;
+
+static real angle_between(const quaternion_batch<real> &b, std::size_t i,
+                          const quaternion<real> &q) {
+  real c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  real d = 0;
+  for (unsigned int k = 0; k < 4; k++)
+    d += b.data(k)[i] * c[k];
+  d = fabs(d) > 1 ? 1 : fabs(d);
+  return 2 * acos(d);
+}
+static std::size_t brute_nearest(const quaternion_batch<real> &b,
+                                 const quaternion<real> &q) {
+  std::size_t best = 0;
+  for (std::size_t i = 1; i < b.size(); i++)
+    if (angle_between(b, i, q) < angle_between(b, best, q))
+      best = i;
+  return best;
+}
+
+CTEST(index, test_nearest_matches_scan) {
+  random_rotations<real> gen(1);
+  quaternion_batch<real> set;
+  gen.generate(2000, set);
+  orientation_index<real> idx;
+  ASSERT_EQUAL(idx.build(set), SUCCESS);
+  ASSERT_EQUAL(idx.size(), 2000);
+  for (std::uint64_t i = 0; i < 200; i++) {
+    quaternion<real> q;
+    gen.generate(100000 + i, q);
+    orientation_neighbor<real> nb = {0, 0};
+    ASSERT_EQUAL(idx.nearest(q, nb), SUCCESS);
+    std::size_t expected = brute_nearest(set, q);
+    ASSERT_EQUAL(nb.index, expected);
+    ASSERT_DBL_NEAR_TOL(nb.angle, angle_between(set, expected, q), 1e-6);
+  }
+}
+CTEST(index, test_antipodal) {
+  quaternion_batch<real> set;
+  set.push_back(quaternion<real>(1, 0, 0, 0));
+  set.push_back(quaternion<real>(0, 1, 0, 0));
+  orientation_index<real> idx;
+  idx.build(set);
+  orientation_neighbor<real> nb = {0, 0};
+  // -identity is the identity
+  ASSERT_EQUAL(idx.nearest(quaternion<real>(-1, 0, 0, 0.01), nb), SUCCESS);
+  ASSERT_EQUAL(nb.index, 0);
+  ASSERT_DBL_NEAR_TOL(nb.angle, 0.02, 1e-4);
+  ASSERT_EQUAL(idx.nearest(quaternion<real>(0, 0, 0, 0), nb), ARG_ERROR);
+}
+CTEST(index, test_knn_and_radius) {
+  random_rotations<real> gen(2);
+  quaternion_batch<real> set;
+  gen.generate(3000, set);
+  orientation_index<real> idx;
+  idx.build(set);
+  quaternion<real> q;
+  gen.generate(424242, q);
+  std::vector<orientation_neighbor<real>> knn;
+  ASSERT_EQUAL(idx.knn(q, 10, knn), SUCCESS);
+  ASSERT_EQUAL(knn.size(), 10);
+  for (std::size_t i = 1; i < knn.size(); i++)
+    ASSERT_TRUE(knn[i - 1].angle <= knn[i].angle);
+  // nothing outside the result is closer than the last one
+  std::size_t closer = 0;
+  for (std::size_t i = 0; i < set.size(); i++)
+    if (angle_between(set, i, q) < knn.back().angle - 1e-9)
+      closer++;
+  ASSERT_EQUAL(closer, 9);
+
+  std::vector<orientation_neighbor<real>> within;
+  real r = 0.5;
+  ASSERT_EQUAL(idx.radius(q, r, within), SUCCESS);
+  std::size_t expected = 0;
+  for (std::size_t i = 0; i < set.size(); i++)
+    if (angle_between(set, i, q) <= r)
+      expected++;
+  ASSERT_EQUAL(within.size(), expected);
+  for (std::size_t i = 0; i < within.size(); i++)
+    ASSERT_TRUE(within[i].angle <= r + 1e-9);
+}
+CTEST(index, test_concurrent_queries) {
+  random_rotations<real> gen(3);
+  quaternion_batch<real> set;
+  gen.generate(5000, set);
+  orientation_index<real> idx;
+  idx.build(set);
+  std::size_t found[4] = {0, 0, 0, 0};
+  std::thread workers[4];
+  for (unsigned int t = 0; t < 4; t++) {
+    workers[t] = std::thread([&, t]() {
+      quaternion<real> q;
+      gen.generate(t, q);
+      orientation_neighbor<real> nb = {0, 0};
+      idx.nearest(q, nb);
+      found[t] = nb.index;
+    });
+  }
+  for (unsigned int t = 0; t < 4; t++)
+    workers[t].join();
+  // the first rotations of the sequence are in the set
+  for (unsigned int t = 0; t < 4; t++)
+    ASSERT_EQUAL(found[t], t);
+}
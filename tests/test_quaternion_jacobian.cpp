@@ -0,0 +1,174 @@
+// test file for the analytic jacobians and automatic differentiation
+#include "../quaternion_jacobian.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+namespace ad {
+/** forward mode dual number, its math functions are found by adl*/
+struct dual {
+  real v, d;
+  dual() : v(0), d(0) {}
+  explicit dual(real a, real b = 0) : v(a), d(b) {}
+};
+inline dual operator+(dual a, dual b) { return dual(a.v + b.v, a.d + b.d); }
+inline dual operator-(dual a, dual b) { return dual(a.v - b.v, a.d - b.d); }
+inline dual operator-(dual a) { return dual(-a.v, -a.d); }
+inline dual operator*(dual a, dual b) {
+  return dual(a.v * b.v, a.d * b.v + a.v * b.d);
+}
+inline dual operator/(dual a, dual b) {
+  return dual(a.v / b.v, (a.d * b.v - a.v * b.d) / (b.v * b.v));
+}
+inline bool operator==(dual a, dual b) { return a.v == b.v; }
+inline bool operator<(dual a, dual b) { return a.v < b.v; }
+inline dual sqrt(dual a) {
+  real s = std::sqrt(a.v);
+  return dual(s, a.d / (2 * s));
+}
+inline dual log(dual a) { return dual(std::log(a.v), a.d / a.v); }
+inline dual atan2(dual y, dual x) {
+  return dual(std::atan2(y.v, x.v),
+              (x.v * y.d - y.v * x.d) / (x.v * x.v + y.v * y.v));
+}
+} // namespace ad
+
+/** q with a unit derivative on coefficient j*/
+static quaternion<ad::dual> seeded(const real c[4], unsigned int j) {
+  ad::dual d[4];
+  for (unsigned int k = 0; k < 4; k++)
+    d[k] = ad::dual(c[k], k == j ? 1 : 0);
+  return quaternion<ad::dual>(d);
+}
+static void derivatives(const quaternion<ad::dual> &q, real v[4],
+                        real d[4]) {
+  ad::dual c[4];
+  q.scalar(c[0]);
+  q.vector(c + 1);
+  for (unsigned int k = 0; k < 4; k++) {
+    v[k] = c[k].v;
+    d[k] = c[k].d;
+  }
+}
+
+static const real P[4] = {0.3, -1.2, 0.5, 2.0};
+static const real Q[4] = {-0.7, 0.4, 1.1, -0.2};
+
+CTEST(jacobian, test_hamilton_product) {
+  quaternion<real> a(P), b(Q), out;
+  real da[16], db[16], c[4];
+  ASSERT_EQUAL(hamilton_product_jacobian(a, b, out, da, db), SUCCESS);
+  coefficients(a * b, c);
+  real o[4];
+  coefficients(out, o);
+  for (unsigned int k = 0; k < 4; k++)
+    ASSERT_DBL_NEAR(o[k], c[k]);
+  for (unsigned int j = 0; j < 4; j++) {
+    real v[4], d[4];
+    derivatives(seeded(P, j) * seeded(Q, 4), v, d);
+    for (unsigned int i = 0; i < 4; i++)
+      ASSERT_DBL_NEAR(da[4 * i + j], d[i]);
+    quaternion<ad::dual> p = seeded(P, 4), r;
+    p.hamilton_product(seeded(Q, j), r);
+    derivatives(r, v, d);
+    for (unsigned int i = 0; i < 4; i++)
+      ASSERT_DBL_NEAR(db[4 * i + j], d[i]);
+  }
+}
+CTEST(jacobian, test_rotate) {
+  quaternion<real> q(P);
+  real v[3] = {0.9, -0.4, 1.3}, out[3], dq[12], dv[9], e[3];
+  ASSERT_EQUAL(rotate_jacobian(q, v, out, dq, dv), SUCCESS);
+  q.rotate(v, e);
+  for (unsigned int i = 0; i < 3; i++)
+    ASSERT_DBL_NEAR_TOL(out[i], e[i], 1e-14);
+  ad::dual w[3] = {ad::dual(v[0]), ad::dual(v[1]), ad::dual(v[2])}, o[3];
+  for (unsigned int j = 0; j < 4; j++) {
+    ASSERT_EQUAL(seeded(P, j).rotate(w, o), SUCCESS);
+    for (unsigned int i = 0; i < 3; i++)
+      ASSERT_DBL_NEAR_TOL(dq[4 * i + j], o[i].d, 1e-14);
+  }
+  for (unsigned int j = 0; j < 3; j++) {
+    ad::dual u[3] = {ad::dual(v[0], j == 0), ad::dual(v[1], j == 1),
+                     ad::dual(v[2], j == 2)};
+    seeded(P, 4).rotate(u, o);
+    for (unsigned int i = 0; i < 3; i++)
+      ASSERT_DBL_NEAR_TOL(dv[3 * i + j], o[i].d, 1e-14);
+  }
+  quaternion<real> zero(0, 0, 0, 0);
+  ASSERT_EQUAL(rotate_jacobian(zero, v, out, dq, dv), ARG_ERROR);
+}
+CTEST(jacobian, test_normalized) {
+  quaternion<real> q(P), out;
+  real dq[16];
+  ASSERT_EQUAL(normalized_jacobian(q, out, dq), SUCCESS);
+  for (unsigned int j = 0; j < 4; j++) {
+    quaternion<ad::dual> n;
+    ASSERT_EQUAL(seeded(P, j).normalized(n), SUCCESS);
+    real v[4], d[4], o[4];
+    derivatives(n, v, d);
+    coefficients(out, o);
+    for (unsigned int i = 0; i < 4; i++) {
+      ASSERT_DBL_NEAR_TOL(o[i], v[i], 1e-15);
+      ASSERT_DBL_NEAR_TOL(dq[4 * i + j], d[i], 1e-15);
+    }
+  }
+}
+CTEST(jacobian, test_log) {
+  // general, small vector part and pure real
+  const real cases[3][4] = {
+      {P[0], P[1], P[2], P[3]}, {2.0, 1e-5, -3e-5, 2e-5}, {1.5, 0, 0, 0}};
+  for (unsigned int c = 0; c < 3; c++) {
+    quaternion<real> q(cases[c]), out;
+    real dq[16];
+    ASSERT_EQUAL(log_jacobian(q, out, dq), SUCCESS);
+    for (unsigned int j = 0; j < 4; j++) {
+      quaternion<ad::dual> l;
+      ASSERT_EQUAL(seeded(cases[c], j).log(l), SUCCESS);
+      real v[4], d[4], o[4];
+      derivatives(l, v, d);
+      coefficients(out, o);
+      for (unsigned int i = 0; i < 4; i++) {
+        ASSERT_DBL_NEAR_TOL(o[i], v[i], 1e-15);
+        // automatic differentiation misses the limit for pure reals
+        if (c < 2 || j == 0)
+          ASSERT_DBL_NEAR_TOL(dq[4 * i + j], d[i], 1e-12);
+      }
+    }
+  }
+  // exp of the log recovers a unit quaternion
+  quaternion<real> q(0.8, 0.0, 0.6, 0.0), l;
+  ASSERT_EQUAL(q.log(l), SUCCESS);
+  real c[4];
+  coefficients(l, c);
+  ASSERT_DBL_NEAR_TOL(c[0], 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(c[2], std::atan2(0.6, 0.8), 1e-15);
+  // exp(w + v) = e^w (cos |v| + sin |v| v / |v|)
+  real angle = sqrt(c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+  real scale = exp(c[0]) * sin(angle) / angle;
+  ASSERT_DBL_NEAR_TOL(exp(c[0]) * cos(angle), 0.8, 1e-15);
+  ASSERT_DBL_NEAR_TOL(scale * c[1], 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(scale * c[2], 0.6, 1e-15);
+  ASSERT_DBL_NEAR_TOL(scale * c[3], 0.0, 1e-15);
+  quaternion<real> negative(-2, 0, 0, 0), zero(0, 0, 0, 0);
+  ASSERT_EQUAL(negative.log(l), ARG_ERROR);
+  ASSERT_EQUAL(zero.log(l), ARG_ERROR);
+}
+CTEST(jacobian, test_generic_scalar) {
+  // scalar operations and the callable of apply with an ad type
+  quaternion<ad::dual> q = seeded(P, 1);
+  ad::dual n, out[3];
+  ASSERT_EQUAL(q.norm(n), SUCCESS);
+  ASSERT_DBL_NEAR(n.d, P[1] / n.v);
+  ASSERT_EQUAL(q.vector_division(ad::dual(2), out), SUCCESS);
+  ASSERT_DBL_NEAR(out[0].d, 0.5);
+  ASSERT_EQUAL(q.vector_division(ad::dual(0), out), ARG_ERROR);
+  quaternion<ad::dual> r;
+  ASSERT_EQUAL(q.apply(q, [](ad::dual a, ad::dual b) { return a * b; }, r),
+               SUCCESS);
+  real v[4], d[4];
+  derivatives(r, v, d);
+  ASSERT_DBL_NEAR(d[1], 2 * P[1]);
+}
@@ -0,0 +1,87 @@
+// test file for lazily renormalized unit quaternions
+#include "../quaternion_lazy.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef float real;
+
+static real norm_error(const quaternion<real> &q) {
+  double c[4];
+  real s = static_cast<real>(0);
+  real v[3];
+  q.scalar(s);
+  q.vector(v);
+  c[0] = s;
+  c[1] = v[0];
+  c[2] = v[1];
+  c[3] = v[2];
+  double d = c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3];
+  return static_cast<real>(fabs(d - 1.0));
+}
+
+CTEST(lazy, test_bound_holds) {
+  real axis[3] = {1, 2, 3};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_axis_angle(axis, 0.1f, u);
+  // large tolerance, no renormalization happens
+  lazy_unit_quaternion<real> step(u, 1e-3f);
+  lazy_unit_quaternion<real> acc(unit_quaternion<real>(), 1e-3f);
+  for (unsigned int i = 0; i < 1000; i++) {
+    acc = acc * step;
+    ASSERT_TRUE(norm_error(acc.get()) <= acc.drift_bound());
+  }
+}
+CTEST(lazy, test_bound_starts_from_drift) {
+  // within the unit_quaternion tolerance, but not exactly unit
+  unit_quaternion<real> off(quaternion<real>(1.0002f, 0, 0, 0));
+  unit_quaternion<real> u;
+  real axis[3] = {0, 0, 1};
+  unit_quaternion<real>::from_axis_angle(axis, 0.2f, u);
+  lazy_unit_quaternion<real> step(u, 1e-3f);
+  lazy_unit_quaternion<real> acc(off, 1e-3f);
+  ASSERT_TRUE(norm_error(acc.get()) <= acc.drift_bound());
+  for (unsigned int i = 0; i < 100; i++) {
+    acc = acc * step;
+    ASSERT_TRUE(norm_error(acc.get()) <= acc.drift_bound());
+  }
+}
+CTEST(lazy, test_renormalizes_lazily) {
+  real axis[3] = {1, -1, 2};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_axis_angle(axis, 0.37f, u);
+  lazy_unit_quaternion<real> step(u);
+  lazy_unit_quaternion<real> acc;
+  unsigned int renormalizations = 0;
+  real last = acc.drift_bound();
+  for (unsigned int i = 0; i < 100000; i++) {
+    acc = acc * step;
+    if (acc.drift_bound() < last)
+      renormalizations++;
+    last = acc.drift_bound();
+    ASSERT_TRUE(acc.drift_bound() <= acc.tolerance());
+  }
+  ASSERT_TRUE(renormalizations > 0);
+  // one renormalization per ~100 products for float
+  ASSERT_TRUE(renormalizations < 100000 / 50);
+  ASSERT_TRUE(norm_error(acc.get()) <= acc.tolerance());
+}
+CTEST(lazy, test_matches_eager) {
+  real axis[3] = {0, 1, 0};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_axis_angle(axis, 0.01f, u);
+  lazy_unit_quaternion<real> step(u);
+  lazy_unit_quaternion<real> lazy(unit_quaternion<real>(), 1e-4f);
+  quaternion<real> eager(1, 0, 0, 0);
+  for (unsigned int i = 0; i < 10000; i++) {
+    lazy = lazy * step;
+    eager = (eager * u.get()).normalize();
+  }
+  real v[3] = {1, 0, 0};
+  real a[3] = {0, 0, 0};
+  real b[3] = {0, 0, 0};
+  lazy.rotate(v, a);
+  eager.rotate(v, b);
+  ASSERT_DBL_NEAR_TOL(b[0], a[0], 1e-3);
+  ASSERT_DBL_NEAR_TOL(b[1], a[1], 1e-3);
+  ASSERT_DBL_NEAR_TOL(b[2], a[2], 1e-3);
+}
@@ -0,0 +1,140 @@
+// test file for the multiplicative extended Kalman filter
+#include "../quaternion_mekf.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+/** what a body with orientation q measures of the direction ref*/
+static void measure(const quaternion<real> &q, const real ref[3], real out[3]) {
+  q.conjugate().rotate(ref, out);
+}
+
+CTEST(mekf, test_converges_to_truth) {
+  quaternion<real> truth = quaternion<real>(0.9, 0.2, -0.3, 0.25).normalize();
+  // seeded about 0.14 rad off, as after a coarse alignment
+  mekf<real> f(0.001, 0.1);
+  f.set_orientation(truth * quaternion<real>(1, 0.05, -0.03, 0.04));
+  const real up[3] = {0, 0, 1};
+  const real north[3] = {0.4, 0, -0.9};
+  const real still[3] = {0, 0, 0};
+  ASSERT_EQUAL(f.update(still, up, 0.01), ARG_ERROR);
+  for (int i = 0; i < 200; i++) {
+    real b[3];
+    ASSERT_EQUAL(f.predict(still, 0.01), SUCCESS);
+    measure(truth, up, b);
+    ASSERT_EQUAL(f.update(b, up, 0.01), SUCCESS);
+    measure(truth, north, b);
+    ASSERT_EQUAL(f.update(b, north, 0.01), SUCCESS);
+  }
+  real e[4], a[4];
+  coefficients(truth, e);
+  coefficients(f.orientation(), a);
+  real dot = fabs(e[0] * a[0] + e[1] * a[1] + e[2] * a[2] + e[3] * a[3]);
+  real angle = 2 * acos(dot > 1 ? 1 : dot);
+  ASSERT_TRUE(angle < 1e-3);
+  // two directions observe every axis, the covariance is small and
+  // symmetric
+  real p[9];
+  f.covariance(p);
+  for (unsigned int i = 0; i < 3; i++) {
+    ASSERT_TRUE(p[4 * i] > 0);
+    ASSERT_TRUE(p[4 * i] < 1e-5);
+    // and consistent with the remaining error
+    ASSERT_TRUE(angle < 3 * sqrt(p[4 * i]));
+    for (unsigned int j = 0; j < 3; j++)
+      ASSERT_DBL_NEAR_TOL(p[3 * i + j], p[3 * j + i], 1e-15);
+  }
+}
+CTEST(mekf, test_single_direction_leaves_heading_open) {
+  mekf<real> f(0.001, 1);
+  const real up[3] = {0, 0, 1};
+  const real still[3] = {0, 0, 0};
+  for (int i = 0; i < 100; i++) {
+    f.predict(still, 0.01);
+    f.update(up, up, 0.01);
+  }
+  real p[9];
+  f.covariance(p);
+  // roll and pitch are known, rotation about gravity is not
+  ASSERT_TRUE(p[0] < 1e-3);
+  ASSERT_TRUE(p[4] < 1e-3);
+  ASSERT_TRUE(p[8] > 0.5);
+}
+CTEST(mekf, test_predict_integrates_rate) {
+  mekf<real> f(0.01, 0.1);
+  const real gyro[3] = {0, 1.5707963267948966, 0};
+  for (int i = 0; i < 100; i++)
+    f.predict(gyro, 0.01);
+  // a quarter turn about y
+  real c[4];
+  coefficients(f.orientation(), c);
+  ASSERT_DBL_NEAR_TOL(c[0], sqrt(0.5), 1e-12);
+  ASSERT_DBL_NEAR_TOL(c[2], sqrt(0.5), 1e-12);
+  // the noise grows the covariance by gyro variance times time
+  real p[9];
+  f.covariance(p);
+  ASSERT_DBL_NEAR_TOL(p[0] + p[4] + p[8], 3 * (0.01 + 1e-4), 1e-12);
+}
+CTEST(mekf, test_batch_matches_scalar) {
+  const std::size_t N = 150;
+  mekf_batch<real> batch(N, 0.02, 0.5);
+  std::vector<mekf<real>> single(N, mekf<real>(0.02, 0.5));
+  std::vector<real> g[3], b[3];
+  for (unsigned int k = 0; k < 3; k++) {
+    g[k].resize(N);
+    b[k].resize(N);
+  }
+  const real up[3] = {0, 0, 2};
+  const real none[3] = {0, 0, 0};
+  ASSERT_EQUAL(batch.update(nullptr, none, 0.1), ARG_ERROR);
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> q0(1, 0.01 * static_cast<real>(i % 9), 0.3, -0.1);
+    ASSERT_EQUAL(batch.set_orientation(i, q0), SUCCESS);
+    single[i].set_orientation(q0);
+  }
+  for (int step = 0; step < 40; step++) {
+    for (std::size_t i = 0; i < N; i++) {
+      real t = static_cast<real>(step) * 0.01 + static_cast<real>(i) * 0.002;
+      g[0][i] = 0.4 * sin(t);
+      g[1][i] = i % 7 == 0 ? 0 : -0.3;
+      g[2][i] = i % 7 == 0 ? 0 : cos(2 * t);
+      // every tenth lane has no measurement
+      b[0][i] = i % 10 == 0 ? 0 : 0.1 * t;
+      b[1][i] = i % 10 == 0 ? 0 : -0.2;
+      b[2][i] = i % 10 == 0 ? 0 : 9.8;
+    }
+    const real *gp[3] = {g[0].data(), g[1].data(), g[2].data()};
+    const real *bp[3] = {b[0].data(), b[1].data(), b[2].data()};
+    ASSERT_EQUAL(batch.predict(gp, 0.01, step % 2 ? 3 : 1), SUCCESS);
+    // the lanes without measurement report like the scalar filter
+    ASSERT_EQUAL(batch.update(bp, up, 0.05, 2), ARG_ERROR);
+    for (std::size_t i = 0; i < N; i++) {
+      real gi[3] = {g[0][i], g[1][i], g[2][i]};
+      real bi[3] = {b[0][i], b[1][i], b[2][i]};
+      single[i].predict(gi, 0.01);
+      ASSERT_EQUAL(single[i].update(bi, up, 0.05),
+                   i % 10 == 0 ? ARG_ERROR : SUCCESS);
+    }
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> bq;
+    batch.orientations().get(i, bq);
+    real e[4], a[4], pe[9], pa[9];
+    coefficients(single[i].orientation(), e);
+    coefficients(bq, a);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(e[k], a[k], 1e-12);
+    single[i].covariance(pe);
+    ASSERT_EQUAL(batch.covariance(i, pa), SUCCESS);
+    for (unsigned int k = 0; k < 9; k++)
+      ASSERT_DBL_NEAR_TOL(pe[k], pa[k], 1e-12);
+  }
+  real p[9];
+  ASSERT_EQUAL(batch.covariance(N, p), INDEX_ERROR);
+  for (std::size_t i = 0; i < N; i++)
+    b[2][i] = 9.8;
+  const real *bp[3] = {b[0].data(), b[1].data(), b[2].data()};
+  ASSERT_EQUAL(batch.update(bp, up, 0.05, 2), SUCCESS);
+}
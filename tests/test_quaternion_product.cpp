@@ -0,0 +1,65 @@
+// test file for the product matrices and the many by many products
+#include "../quaternion_product.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+CTEST(product, test_left_right_matrices) {
+  quaternion<real> p(0.3, -1.2, 0.5, 2.0), q(-0.7, 0.4, 1.1, -0.2);
+  real l[16], r[16], a[4], b[4], pq[4];
+  ASSERT_EQUAL(p.left_matrix(l), SUCCESS);
+  ASSERT_EQUAL(q.right_matrix(r), SUCCESS);
+  coefficients(p, a);
+  coefficients(q, b);
+  coefficients(p * q, pq);
+  for (unsigned int i = 0; i < 4; i++) {
+    real x = 0, y = 0;
+    for (unsigned int j = 0; j < 4; j++) {
+      x += l[4 * i + j] * b[j];
+      y += r[4 * i + j] * a[j];
+    }
+    ASSERT_DBL_NEAR_TOL(x, pq[i], 1e-15);
+    ASSERT_DBL_NEAR_TOL(y, pq[i], 1e-15);
+  }
+}
+CTEST(product, test_all_pairs) {
+  // b spans more than one tile and ends in a partial one
+  const std::size_t M = 7, N = 300;
+  quaternion_batch<real> a, b, prod, rel;
+  for (std::size_t i = 0; i < M; i++) {
+    real t = 0.9 * static_cast<real>(i);
+    a.push_back(quaternion<real>(std::cos(t), 0.5, std::sin(t), -0.3 * t));
+  }
+  for (std::size_t j = 0; j < N; j++) {
+    real t = 0.13 * static_cast<real>(j);
+    b.push_back(quaternion<real>(std::sin(t), std::cos(2 * t), 0.2, t));
+  }
+  ASSERT_EQUAL(all_pairs_product(a, b, prod, 3), SUCCESS);
+  ASSERT_EQUAL(all_pairs_relative(a, b, rel), SUCCESS);
+  ASSERT_EQUAL(prod.size(), M * N);
+  ASSERT_EQUAL(rel.size(), M * N);
+  for (std::size_t i = 0; i < M; i++)
+    for (std::size_t j = 0; j < N; j++) {
+      quaternion<real> p, q, x, y;
+      a.get(i, p);
+      b.get(j, q);
+      prod.get(i * N + j, x);
+      rel.get(i * N + j, y);
+      real e[4], f[4], g[4], h[4];
+      coefficients(p * q, e);
+      coefficients(p.inverse() * q, f);
+      coefficients(x, g);
+      coefficients(y, h);
+      for (unsigned int k = 0; k < 4; k++) {
+        ASSERT_DBL_NEAR_TOL(g[k], e[k], 1e-13);
+        ASSERT_DBL_NEAR_TOL(h[k], f[k], 1e-13);
+      }
+    }
+  quaternion_batch<real> empty;
+  ASSERT_EQUAL(all_pairs_product(empty, b, prod), SUCCESS);
+  ASSERT_EQUAL(prod.size(), static_cast<std::size_t>(0));
+  ASSERT_EQUAL(all_pairs_product(a, b, b), ARG_ERROR);
+  ASSERT_EQUAL(all_pairs_relative(a, b, a), ARG_ERROR);
+}
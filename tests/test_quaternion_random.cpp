@@ -0,0 +1,90 @@
+// test file for random rotations
+#include "../quaternion_random.hpp"
+#include <ctest.h>
+#include <thread>
+
+using namespace quat11;
+
+CTEST(random, test_philox_known_answers) {
+  // known answer vectors of the Random123 distribution
+  const std::uint32_t ctr0[4] = {0, 0, 0, 0};
+  const std::uint32_t key0[2] = {0, 0};
+  std::uint32_t out[4];
+  random_detail::philox4x32(ctr0, key0, out);
+  ASSERT_EQUAL(out[0], 0x6627e8d5u);
+  ASSERT_EQUAL(out[1], 0xe169c58du);
+  ASSERT_EQUAL(out[2], 0xbc57ac4cu);
+  ASSERT_EQUAL(out[3], 0x9b00dbd8u);
+  const std::uint32_t ctr1[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu,
+                                 0x03707344u};
+  const std::uint32_t key1[2] = {0xa4093822u, 0x299f31d0u};
+  random_detail::philox4x32(ctr1, key1, out);
+  ASSERT_EQUAL(out[0], 0xd16cfe09u);
+  ASSERT_EQUAL(out[1], 0x94fdccebu);
+  ASSERT_EQUAL(out[2], 0x5001e420u);
+  ASSERT_EQUAL(out[3], 0x24126ea1u);
+}
+CTEST(random, test_sincos_turn) {
+  for (std::uint64_t x = 0; x < 0x100000000ull; x += 0x01234567ull) {
+    double s, c;
+    random_detail::sincos_turn(static_cast<std::uint32_t>(x), s, c);
+    double t = 2 * M_PI * static_cast<double>(x) / 4294967296.0;
+    ASSERT_DBL_NEAR_TOL(sin(t), s, 1e-15);
+    ASSERT_DBL_NEAR_TOL(cos(t), c, 1e-15);
+  }
+}
+CTEST(random, test_unit_and_uniform) {
+  random_rotations<double> gen(42);
+  quaternion_batch<double> b;
+  const std::size_t n = 100000;
+  gen.generate(n, b);
+  ASSERT_EQUAL(b.size(), n);
+  // unit norm, and each component has mean 0 and mean square 1/4
+  double mean[4] = {0, 0, 0, 0};
+  double sq[4] = {0, 0, 0, 0};
+  for (std::size_t i = 0; i < n; i++) {
+    double d = 0;
+    for (unsigned int k = 0; k < 4; k++) {
+      double v = b.data(k)[i];
+      d += v * v;
+      mean[k] += v;
+      sq[k] += v * v;
+    }
+    ASSERT_DBL_NEAR_TOL(d, 1, 1e-14);
+  }
+  for (unsigned int k = 0; k < 4; k++) {
+    ASSERT_DBL_NEAR_TOL(mean[k] / n, 0, 0.01);
+    ASSERT_DBL_NEAR_TOL(sq[k] / n, 0.25, 0.01);
+  }
+}
+CTEST(random, test_reproducible_split) {
+  random_rotations<float> gen(7, 3);
+  quaternion_batch<float> serial;
+  gen.generate(1000, serial);
+  // two threads fill the halves of one batch
+  quaternion_batch<float> split(1000);
+  std::thread workers[2];
+  for (unsigned int t = 0; t < 2; t++) {
+    workers[t] = std::thread([&, t]() {
+      float *dst[4];
+      for (unsigned int k = 0; k < 4; k++)
+        dst[k] = split.data(k) + 500 * t;
+      gen.fill(500 * t, 500, dst);
+    });
+  }
+  for (unsigned int t = 0; t < 2; t++)
+    workers[t].join();
+  for (unsigned int k = 0; k < 4; k++)
+    for (std::size_t i = 0; i < 1000; i++)
+      ASSERT_TRUE(serial.data(k)[i] == split.data(k)[i]);
+  quaternion<float> q;
+  gen.generate(999, q);
+  float w = 0;
+  q.scalar(w);
+  ASSERT_TRUE(w == serial.data(0)[999]);
+  // another stream gives other rotations
+  random_rotations<float> other(7, 4);
+  other.generate(999, q);
+  q.scalar(w);
+  ASSERT_TRUE(w != serial.data(0)[999]);
+}
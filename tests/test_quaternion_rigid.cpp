@@ -0,0 +1,121 @@
+// test file for the RK4 rigid body integrator
+#include "../quaternion_rigid.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+/** world frame angular momentum and kinetic energy*/
+static void invariants(const quaternion<real> &q, const real w[3],
+                       const real inertia[3], real l[3], real &energy) {
+  real b[3] = {inertia[0] * w[0], inertia[1] * w[1], inertia[2] * w[2]};
+  q.rotate(b, l);
+  energy = 0.5 * (b[0] * w[0] + b[1] * w[1] + b[2] * w[2]);
+}
+
+CTEST(rigid, test_principal_axis_spin) {
+  quaternion<real> q(1, 0, 0, 0);
+  real w[3] = {0, 0, 2};
+  const real inertia[3] = {1, 2, 3};
+  const real tau[3] = {0, 0, 0};
+  for (int i = 0; i < 100; i++)
+    ASSERT_EQUAL(rk4_step(q, w, inertia, tau, 0.01), SUCCESS);
+  // two radians about z, a steady spin, up to the RK4 truncation
+  real c[4];
+  coefficients(q, c);
+  ASSERT_DBL_NEAR_TOL(c[0], cos(1.0), 1e-9);
+  ASSERT_DBL_NEAR_TOL(c[3], sin(1.0), 1e-9);
+  ASSERT_DBL_NEAR_TOL(w[2], 2, 1e-15);
+  const real bad[3] = {1, 0, 1};
+  ASSERT_EQUAL(rk4_step(q, w, bad, tau, 0.01), ARG_ERROR);
+}
+CTEST(rigid, test_torque_free_invariants) {
+  // tumbling near the unstable middle axis
+  quaternion<real> q = quaternion<real>(1, 0.2, -0.1, 0.3).normalize();
+  real w[3] = {0.05, 3, 0.1};
+  const real inertia[3] = {1, 2, 3};
+  const real tau[3] = {0, 0, 0};
+  real l0[3], e0, l1[3], e1;
+  invariants(q, w, inertia, l0, e0);
+  for (int i = 0; i < 2000; i++)
+    rk4_step(q, w, inertia, tau, 0.001);
+  invariants(q, w, inertia, l1, e1);
+  ASSERT_DBL_NEAR_TOL(e1, e0, 1e-8);
+  for (unsigned int k = 0; k < 3; k++)
+    ASSERT_DBL_NEAR_TOL(l1[k], l0[k], 1e-8);
+}
+CTEST(rigid, test_fourth_order) {
+  const real inertia[3] = {1, 1.5, 2.5};
+  const real tau[3] = {0.3, -0.2, 0.1};
+  real err[2];
+  for (int r = 0; r < 2; r++) {
+    // the same second with dt and dt / 2 against a fine reference
+    int n = 50 << r;
+    quaternion<real> q(1, 0, 0, 0), f(1, 0, 0, 0);
+    real w[3] = {1, 0.5, -0.7}, wf[3] = {1, 0.5, -0.7};
+    for (int i = 0; i < n; i++)
+      rk4_step(q, w, inertia, tau, 1.0 / n);
+    for (int i = 0; i < 3200; i++)
+      rk4_step(f, wf, inertia, tau, 1.0 / 3200);
+    real a[4], b[4];
+    coefficients(q, a);
+    coefficients(f, b);
+    err[r] = 0;
+    for (unsigned int k = 0; k < 4; k++)
+      err[r] += fabs(a[k] - b[k]);
+  }
+  // halving the step cuts the error by about 2^4
+  ASSERT_TRUE(err[0] / err[1] > 12);
+  ASSERT_TRUE(err[0] / err[1] < 20);
+}
+CTEST(rigid, test_batch_matches_scalar) {
+  const std::size_t N = 150;
+  rigid_body_batch<real> batch(N);
+  std::vector<quaternion<real>> qs(N);
+  std::vector<real> ws(3 * N), is(3 * N);
+  std::vector<real> tau[3];
+  for (unsigned int k = 0; k < 3; k++)
+    tau[k].resize(N);
+  for (std::size_t i = 0; i < N; i++) {
+    real s = static_cast<real>(i);
+    qs[i] = quaternion<real>(1, 0.01 * s, -0.3, 0.2).normalize();
+    real w[3] = {0.1 * sin(s), 2 - 0.01 * s, 0.5};
+    real in[3] = {1 + 0.01 * s, 2, 1.5};
+    ASSERT_EQUAL(batch.set_body(i, qs[i], w, in), SUCCESS);
+    for (unsigned int k = 0; k < 3; k++) {
+      ws[3 * i + k] = w[k];
+      is[3 * i + k] = in[k];
+      tau[k][i] = 0.05 * static_cast<real>(k + 1) * cos(s);
+    }
+  }
+  const real w0[3] = {0, 0, 0}, flat[3] = {1, 0, 1};
+  ASSERT_EQUAL(batch.set_body(N, qs[0], w0, is.data()), INDEX_ERROR);
+  ASSERT_EQUAL(batch.set_body(0, qs[0], w0, flat), ARG_ERROR);
+  const real *tp[3] = {tau[0].data(), tau[1].data(), tau[2].data()};
+  for (int step = 0; step < 30; step++) {
+    bool torque_free = step % 3 == 2;
+    if (torque_free)
+      ASSERT_EQUAL(batch.step(0.01, 2), SUCCESS);
+    else
+      ASSERT_EQUAL(batch.step(tp, 0.01, step % 2 ? 3 : 1), SUCCESS);
+    for (std::size_t i = 0; i < N; i++) {
+      real t[3] = {0, 0, 0};
+      if (!torque_free)
+        for (unsigned int k = 0; k < 3; k++)
+          t[k] = tau[k][i];
+      rk4_step(qs[i], &ws[3 * i], &is[3 * i], t, 0.01);
+    }
+  }
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> bq;
+    batch.orientations().get(i, bq);
+    real e[4], a[4];
+    coefficients(qs[i], e);
+    coefficients(bq, a);
+    for (unsigned int k = 0; k < 4; k++)
+      ASSERT_DBL_NEAR_TOL(e[k], a[k], 1e-12);
+    for (unsigned int k = 0; k < 3; k++)
+      ASSERT_DBL_NEAR_TOL(batch.angular_velocity(k)[i], ws[3 * i + k], 1e-12);
+  }
+}
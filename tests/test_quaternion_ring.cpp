@@ -0,0 +1,125 @@
+// test file for the lock-free orientation rings
+#include "../quaternion_ring.hpp"
+#include <ctest.h>
+#include <thread>
+
+using namespace quat11;
+typedef float real;
+
+static orientation_sample<real> sample(std::uint64_t t) {
+  orientation_sample<real> s;
+  s.timestamp = t;
+  s.q = quaternion<real>(1, static_cast<real>(t % 100), 0, 0);
+  return s;
+}
+
+CTEST(ring, test_spsc_single_thread) {
+  spsc_ring<real> r(5);
+  ASSERT_EQUAL(r.capacity(), 8);
+  orientation_sample<real> out = sample(99);
+  ASSERT_FALSE(r.pop(out));
+  for (std::uint64_t i = 0; i < 8; i++)
+    ASSERT_TRUE(r.push(sample(i)));
+  ASSERT_FALSE(r.push(sample(8)));
+  ASSERT_EQUAL(r.size(), 8);
+  ASSERT_TRUE(r.pop(out));
+  ASSERT_EQUAL(out.timestamp, 0);
+  // batches wrap around the end of the buffer
+  orientation_sample<real> in[4] = {sample(8), sample(9), sample(10),
+                                    sample(11)};
+  ASSERT_EQUAL(r.push(in, 4), 1);
+  orientation_sample<real> outs[16];
+  ASSERT_EQUAL(r.pop(outs, 16), 8);
+  for (std::uint64_t i = 0; i < 8; i++)
+    ASSERT_EQUAL(outs[i].timestamp, i + 1);
+  ASSERT_EQUAL(r.push(in + 1, 3), 3);
+  ASSERT_EQUAL(r.pop(outs, 2), 2);
+  ASSERT_EQUAL(outs[1].timestamp, 10);
+  real x = 0;
+  real v[3];
+  outs[1].q.vector(v);
+  x = v[0];
+  ASSERT_DBL_NEAR(x, 10);
+}
+CTEST(ring, test_spsc_threads) {
+  spsc_ring<real> r(64);
+  const std::uint64_t N = 200000;
+  std::thread producer([&r, N]() {
+    orientation_sample<real> batch[7];
+    std::uint64_t next = 0;
+    while (next < N) {
+      std::size_t m = 0;
+      for (; m < 7 && next + m < N; m++)
+        batch[m] = sample(next + m);
+      std::size_t done = 0;
+      while (done < m) {
+        std::size_t k = r.push(batch + done, m - done);
+        if (k == 0)
+          std::this_thread::yield();
+        done += k;
+      }
+      next += m;
+    }
+  });
+  std::uint64_t expected = 0;
+  bool in_order = true;
+  orientation_sample<real> out[5];
+  while (expected < N) {
+    std::size_t k = r.pop(out, 5);
+    if (k == 0)
+      std::this_thread::yield();
+    for (std::size_t j = 0; j < k; j++)
+      in_order = in_order && out[j].timestamp == expected++;
+  }
+  producer.join();
+  ASSERT_TRUE(in_order);
+  ASSERT_EQUAL(r.size(), 0);
+}
+CTEST(ring, test_mpsc_threads) {
+  mpsc_ring<real> r(32);
+  ASSERT_EQUAL(r.capacity(), 32);
+  const unsigned int P = 4;
+  const std::uint64_t N = 50000;
+  std::thread producers[P];
+  for (unsigned int p = 0; p < P; p++)
+    producers[p] = std::thread([&r, p, N]() {
+      // the producer in the top bits, its own counter below
+      orientation_sample<real> batch[3];
+      for (std::uint64_t i = 0; i < N; i += 3) {
+        std::size_t m = 0;
+        for (; m < 3 && i + m < N; m++)
+          batch[m] = sample((static_cast<std::uint64_t>(p) << 32) | (i + m));
+        std::size_t done = 0;
+        while (done < m) {
+          std::size_t k = r.push(batch + done, m - done);
+          if (k == 0)
+            std::this_thread::yield();
+          done += k;
+        }
+      }
+    });
+  std::uint64_t next[P] = {0, 0, 0, 0};
+  bool in_order = true;
+  std::uint64_t total = 0;
+  orientation_sample<real> out[8];
+  while (total < P * N) {
+    std::size_t k = r.pop(out, 8);
+    if (k == 0)
+      std::this_thread::yield();
+    for (std::size_t j = 0; j < k; j++) {
+      std::uint64_t p = out[j].timestamp >> 32;
+      in_order = in_order && p < P &&
+                 (out[j].timestamp & 0xffffffffu) == next[p];
+      if (p < P)
+        next[p]++;
+    }
+    total += k;
+  }
+  for (unsigned int p = 0; p < P; p++)
+    producers[p].join();
+  ASSERT_TRUE(in_order);
+  orientation_sample<real> extra;
+  ASSERT_FALSE(r.pop(extra));
+  for (unsigned int p = 0; p < P; p++)
+    ASSERT_EQUAL(next[p], N);
+}
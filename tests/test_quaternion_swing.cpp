@@ -0,0 +1,137 @@
+// test file for the swing-twist decomposition
+#include "../quaternion_swing.hpp"
+#include "../quaternion_unit.hpp"
+#include "test_helpers.hpp"
+#include <ctest.h>
+
+using namespace quat11;
+typedef double real;
+
+static quaternion<real> rotation(real x, real y, real z, real angle) {
+  const real axis[3] = {x, y, z};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_axis_angle(axis, angle, u);
+  return u.get();
+}
+/** rotation angle in [0, pi]*/
+static real angle(const quaternion<real> &q) {
+  real c[4];
+  coefficients(q, c);
+  real v = std::sqrt(c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+  return 2 * std::atan2(v, std::fabs(c[0]));
+}
+/** |<p, q>| is 1 for the same rotation*/
+static real overlap(const quaternion<real> &p, const quaternion<real> &q) {
+  real a[4], b[4];
+  coefficients(p, a);
+  coefficients(q, b);
+  return std::fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+}
+
+CTEST(swing_twist, test_decomposition) {
+  const real axis[3] = {0, 0, 2};
+  quaternion<real> q = rotation(1, 0, 0, 0.4) * rotation(0, 0, 1, -0.9);
+  quaternion<real> swing, twist;
+  ASSERT_EQUAL(swing_twist(q, axis, swing, twist), SUCCESS);
+  real s[4], t[4], a[4], b[4];
+  coefficients(swing, s);
+  coefficients(twist, t);
+  // twist about the axis, swing about a perpendicular one
+  ASSERT_DBL_NEAR_TOL(t[1], 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(t[2], 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(s[3], 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(angle(twist), 0.9, 1e-14);
+  ASSERT_DBL_NEAR_TOL(angle(swing), 0.4, 1e-14);
+  coefficients(swing * twist, a);
+  coefficients(q, b);
+  for (unsigned int k = 0; k < 4; k++)
+    ASSERT_DBL_NEAR_TOL(a[k], b[k], 1e-15);
+  // a pure twist has no swing
+  ASSERT_EQUAL(swing_twist(rotation(0, 0, -1, 2.5), axis, swing, twist),
+               SUCCESS);
+  ASSERT_DBL_NEAR_TOL(angle(swing), 0.0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(angle(twist), 2.5, 1e-14);
+}
+CTEST(swing_twist, test_half_turn_has_no_twist) {
+  const real axis[3] = {0, 1, 0};
+  quaternion<real> q = rotation(1, 0, 1, 3.14159265358979323846);
+  quaternion<real> swing, twist;
+  ASSERT_EQUAL(swing_twist(q, axis, swing, twist), SUCCESS);
+  real t[4];
+  coefficients(twist, t);
+  ASSERT_DBL_NEAR(t[0], 1.0);
+  ASSERT_DBL_NEAR_TOL(overlap(swing, q), 1.0, 1e-15);
+  const real zero[3] = {0, 0, 0};
+  ASSERT_EQUAL(swing_twist(q, zero, swing, twist), ARG_ERROR);
+}
+CTEST(swing_twist, test_clamp) {
+  joint_limit<real> limit = {{1, 0, 0}, -0.5, 0.25, 0.6};
+  quaternion<real> out, swing, twist;
+  // within the limits nothing changes, the sign is kept
+  quaternion<real> q = rotation(0, 1, 0, 0.3) * rotation(1, 0, 0, 0.2);
+  ASSERT_EQUAL(clamp_swing_twist(-q, limit, out), SUCCESS);
+  real a[4], b[4];
+  coefficients(out, a);
+  coefficients(-q, b);
+  for (unsigned int k = 0; k < 4; k++)
+    ASSERT_DBL_NEAR_TOL(a[k], b[k], 1e-15);
+  // twist past either end, swing past the cone
+  const real twists[3] = {0.8, -1.7, -0.3};
+  const real expected[3] = {0.25, 0.5, 0.3};
+  for (unsigned int j = 0; j < 3; j++) {
+    q = rotation(0, 1, 1, 1.4) * rotation(1, 0, 0, twists[j]);
+    ASSERT_EQUAL(clamp_swing_twist(q, limit, out), SUCCESS);
+    ASSERT_EQUAL(swing_twist(out, limit.axis, swing, twist), SUCCESS);
+    ASSERT_DBL_NEAR_TOL(angle(twist), expected[j], 1e-14);
+    ASSERT_DBL_NEAR_TOL(angle(swing), 0.6, 1e-14);
+    // the swing keeps its axis
+    ASSERT_DBL_NEAR_TOL(overlap(swing, rotation(0, 1, 1, 0.6)), 1.0, 1e-15);
+  }
+  joint_limit<real> bad = {{1, 0, 0}, 0.5, 0.25, 0.6};
+  ASSERT_EQUAL(clamp_swing_twist(q, bad, out), ARG_ERROR);
+  bad.twist_min = -0.5;
+  bad.swing_max = 4;
+  ASSERT_EQUAL(clamp_swing_twist(q, bad, out), ARG_ERROR);
+  joint_limits<real> joints;
+  ASSERT_EQUAL(joints.push_back(bad), ARG_ERROR);
+  ASSERT_EQUAL(joints.size(), static_cast<std::size_t>(0));
+}
+CTEST(swing_twist, test_batch_matches_scalar) {
+  const std::size_t N = 150;
+  joint_limits<real> joints;
+  quaternion_batch<real> pose;
+  std::vector<joint_limit<real> > limits;
+  for (std::size_t i = 0; i < N; i++) {
+    real t = 0.61 * static_cast<real>(i);
+    joint_limit<real> l = {{std::cos(t), std::sin(2 * t), 0.3},
+                           -0.2 - 0.01 * static_cast<real>(i % 40),
+                           0.1 + 0.02 * static_cast<real>(i % 30),
+                           0.05 * static_cast<real>(i % 20)};
+    ASSERT_EQUAL(joints.push_back(l), SUCCESS);
+    limits.push_back(l);
+    pose.push_back(rotation(std::sin(t), 1, std::cos(3 * t), 3 * std::sin(t)));
+  }
+  quaternion_batch<real> swing, twist, out = pose;
+  ASSERT_EQUAL(swing_twist(pose, joints, swing, twist), SUCCESS);
+  ASSERT_EQUAL(clamp_swing_twist(out, joints, out), SUCCESS);
+  for (std::size_t i = 0; i < N; i++) {
+    quaternion<real> q, s, t, c, bs, bt, bc;
+    pose.get(i, q);
+    swing.get(i, bs);
+    twist.get(i, bt);
+    out.get(i, bc);
+    ASSERT_EQUAL(swing_twist(q, limits[i].axis, s, t), SUCCESS);
+    ASSERT_EQUAL(clamp_swing_twist(q, limits[i], c), SUCCESS);
+    real x[4], y[4];
+    const quaternion<real> *e[3] = {&s, &t, &c}, *g[3] = {&bs, &bt, &bc};
+    for (unsigned int j = 0; j < 3; j++) {
+      coefficients(*e[j], x);
+      coefficients(*g[j], y);
+      for (unsigned int k = 0; k < 4; k++)
+        ASSERT_DBL_NEAR_TOL(x[k], y[k], 1e-15);
+    }
+  }
+  joints.push_back(limits[0]);
+  ASSERT_EQUAL(clamp_swing_twist(pose, joints, out), SIZE_ERROR);
+  ASSERT_EQUAL(swing_twist(pose, joints, swing, twist), SIZE_ERROR);
+}
@@ -0,0 +1,107 @@
+// test file for rotation lookup tables
+#include "../quaternion_table.hpp"
+#include <ctest.h>
+#include <stdint.h>
+
+using namespace quat11;
+typedef double real;
+
+static void assert_same(const quaternion<real> &a, const quaternion<real> &b,
+                        real tol) {
+  real ca[4], cb[4];
+  a.scalar(ca[0]);
+  a.vector(ca + 1);
+  b.scalar(cb[0]);
+  b.vector(cb + 1);
+  for (unsigned int k = 0; k < 4; k++)
+    ASSERT_DBL_NEAR_TOL(ca[k], cb[k], tol);
+}
+
+CTEST(table, test_grid) {
+  real axis[3] = {0, 0, 2};
+  rotation_table<real> t;
+  ASSERT_EQUAL(rotation_table<real>::from_grid(axis, 0, M_PI, 9, t), SUCCESS);
+  ASSERT_EQUAL(t.size(), 9);
+  ASSERT_EQUAL(reinterpret_cast<uintptr_t>(t.data()) % QUATERNION_CACHE_LINE,
+               0);
+  quaternion<real> q;
+  ASSERT_EQUAL(t.get(8, q), SUCCESS);
+  // half turn about z
+  assert_same(q, quaternion<real>(0, 0, 0, 1), 1e-12);
+  ASSERT_EQUAL(t.get(9, q), INDEX_ERROR);
+}
+CTEST(table, test_invalid) {
+  real axis[3] = {0, 0, 1};
+  real zero[3] = {0, 0, 0};
+  rotation_table<real> t;
+  ASSERT_EQUAL(rotation_table<real>::from_grid(zero, 0, 1, 4, t), ARG_ERROR);
+  ASSERT_EQUAL(rotation_table<real>::from_grid(axis, 0, 1, 1, t), ARG_ERROR);
+  std::vector<real> unsorted = {0, 0.5, 0.25};
+  ASSERT_EQUAL(rotation_table<real>::from_angles(axis, unsorted, t),
+               ARG_ERROR);
+  ASSERT_EQUAL(rotation_table<real>::from_grid(axis, 0, 1, 4, t), SUCCESS);
+  quaternion<real> q;
+  ASSERT_EQUAL(t.nearest(1.5, q), ARG_ERROR);
+  ASSERT_EQUAL(t.slerp(-0.5, q), ARG_ERROR);
+}
+CTEST(table, test_nearest) {
+  real axis[3] = {1, 1, 0};
+  std::vector<real> angles = {-1, 0, 0.1, 2};
+  rotation_table<real> t;
+  ASSERT_EQUAL(rotation_table<real>::from_angles(axis, angles, t), SUCCESS);
+  quaternion<real> q, e;
+  ASSERT_EQUAL(t.nearest(0.06, q), SUCCESS);
+  t.get(2, e);
+  assert_same(q, e, 0);
+  ASSERT_EQUAL(t.nearest(1.0, q), SUCCESS);
+  t.get(2, e);
+  assert_same(q, e, 0);
+  ASSERT_EQUAL(t.nearest(2, q), SUCCESS);
+  t.get(3, e);
+  assert_same(q, e, 0);
+}
+CTEST(table, test_slerp) {
+  real axis[3] = {1, -2, 3};
+  rotation_table<real> t;
+  rotation_table<real>::from_grid(axis, -M_PI, M_PI, 33, t);
+  for (real a = -3.1; a < 3.1; a += 0.0173) {
+    quaternion<real> q;
+    ASSERT_EQUAL(t.slerp(a, q), SUCCESS);
+    unit_quaternion<real> u;
+    unit_quaternion<real>::from_axis_angle(axis, a, u);
+    assert_same(q, u.get(), 1e-12);
+  }
+}
+CTEST(table, test_slerp_fine) {
+  // fine grid, slerp takes the short series
+  real axis[3] = {0, 1, 0};
+  rotation_table<real> t;
+  rotation_table<real>::from_grid(axis, 0, 1, 2001, t);
+  for (real a = 0.0001; a < 1; a += 0.00731) {
+    quaternion<real> q;
+    ASSERT_EQUAL(t.slerp(a, q), SUCCESS);
+    unit_quaternion<real> u;
+    unit_quaternion<real>::from_axis_angle(axis, a, u);
+    assert_same(q, u.get(), 1e-14);
+  }
+}
+CTEST(table, test_slerp_coarse) {
+  // three entries, a step of pi: within the (h/4)^10 / 10! bound of
+  // 2.5e-8, not exact
+  real axis[3] = {0, 0, 1};
+  rotation_table<real> t;
+  rotation_table<real>::from_grid(axis, -M_PI, M_PI, 3, t);
+  real worst = 0;
+  for (real a = -3.14; a < 3.14; a += 0.0123) {
+    quaternion<real> q;
+    ASSERT_EQUAL(t.slerp(a, q), SUCCESS);
+    unit_quaternion<real> u;
+    unit_quaternion<real>::from_axis_angle(axis, a, u);
+    assert_same(q, u.get(), 2.6e-8);
+    real w, e;
+    q.scalar(w);
+    u.get().scalar(e);
+    worst = std::fabs(w - e) > worst ? std::fabs(w - e) : worst;
+  }
+  ASSERT_TRUE(worst > 1e-9);
+}
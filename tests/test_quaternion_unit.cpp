@@ -0,0 +1,213 @@
+// test file for unit quaternion
+#include "../quaternion_unit.hpp"
+#include <ctest.h>
+#include <random>
+
+using namespace quat11;
+typedef double real;
+
+CTEST(unit, test_identity) {
+  unit_quaternion<real> u;
+  real s = static_cast<real>(0);
+  real v[3];
+  u.scalar(s);
+  u.vector(v);
+  ASSERT_DBL_NEAR(1.0, s);
+  ASSERT_DBL_NEAR(0.0, v[0]);
+  ASSERT_DBL_NEAR(0.0, v[1]);
+  ASSERT_DBL_NEAR(0.0, v[2]);
+}
+CTEST(unit, test_from_quaternion) {
+  quaternion<real> q(2, -2, 3, -4);
+  unit_quaternion<real> u;
+  auto res = unit_quaternion<real>::from_quaternion(q, u);
+  ASSERT_EQUAL(res, SUCCESS);
+  real d = static_cast<real>(0);
+  u.get().det(d);
+  ASSERT_DBL_NEAR(1.0, d);
+}
+CTEST(unit, test_from_axis_angle) {
+  real axis[3] = {0, 0, 2};
+  unit_quaternion<real> u;
+  auto res = unit_quaternion<real>::from_axis_angle(axis, M_PI / 2, u);
+  ASSERT_EQUAL(res, SUCCESS);
+  real s = static_cast<real>(0);
+  real v[3];
+  u.scalar(s);
+  u.vector(v);
+  ASSERT_DBL_NEAR(sqrt(0.5), s);
+  ASSERT_DBL_NEAR(0.0, v[0]);
+  ASSERT_DBL_NEAR(0.0, v[1]);
+  ASSERT_DBL_NEAR(sqrt(0.5), v[2]);
+
+  real zero[3] = {0, 0, 0};
+  ASSERT_EQUAL(unit_quaternion<real>::from_axis_angle(zero, 1, u), ARG_ERROR);
+}
+CTEST(unit, test_inverse_is_conjugate) {
+  quaternion<real> q(2, -2, 3, -4);
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_quaternion(q, u);
+  unit_quaternion<real> inv;
+  u.inversed(inv);
+
+  quaternion<real> general_inv;
+  u.get().inversed(general_inv);
+
+  real s1 = static_cast<real>(0);
+  real s2 = static_cast<real>(0);
+  real v1[3];
+  real v2[3];
+  inv.scalar(s1);
+  inv.vector(v1);
+  general_inv.scalar(s2);
+  general_inv.vector(v2);
+  ASSERT_DBL_NEAR(s2, s1);
+  ASSERT_DBL_NEAR(v2[0], v1[0]);
+  ASSERT_DBL_NEAR(v2[1], v1[1]);
+  ASSERT_DBL_NEAR(v2[2], v1[2]);
+}
+CTEST(unit, test_rotate) {
+  real axis[3] = {1, 1, 1};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_axis_angle(axis, 2 * M_PI / 3, u);
+  real v[3] = {1, 2, 3};
+  real out[3] = {0, 0, 0};
+  auto res = u.rotate(v, out);
+  ASSERT_EQUAL(res, SUCCESS);
+  // a third of a turn around the diagonal cycles the axes
+  ASSERT_DBL_NEAR(3.0, out[0]);
+  ASSERT_DBL_NEAR(1.0, out[1]);
+  ASSERT_DBL_NEAR(2.0, out[2]);
+
+  real g[3] = {0, 0, 0};
+  u.get().rotate(v, g);
+  ASSERT_DBL_NEAR(g[0], out[0]);
+  ASSERT_DBL_NEAR(g[1], out[1]);
+  ASSERT_DBL_NEAR(g[2], out[2]);
+}
+CTEST(unit, test_normalized_reprojection) {
+  // slightly off the unit sphere
+  quaternion<real> q(0.5 * 1.001, 0.5, 0.5, 0.5);
+  unit_quaternion<real> u(q);
+  unit_quaternion<real> n = u.normalize();
+  real d = static_cast<real>(0);
+  n.get().det(d);
+  ASSERT_DBL_NEAR_TOL(1.0, d, 1e-6);
+}
+CTEST(unit, test_product) {
+  real z[3] = {0, 0, 1};
+  unit_quaternion<real> a;
+  unit_quaternion<real>::from_axis_angle(z, M_PI / 4, a);
+  unit_quaternion<real> b = a * a;
+  unit_quaternion<real> c;
+  unit_quaternion<real>::from_axis_angle(z, M_PI / 2, c);
+
+  real s1 = static_cast<real>(0);
+  real s2 = static_cast<real>(0);
+  b.scalar(s1);
+  c.scalar(s2);
+  ASSERT_DBL_NEAR(s2, s1);
+}
+static void unit_of(const real v[3], real out[3]) {
+  real n = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  for (unsigned int k = 0; k < 3; k++)
+    out[k] = v[k] / n;
+}
+CTEST(unit, test_from_two_vectors) {
+  const real cases[][6] = {{1, 2, 3, -2, 0.5, 1},
+                           {0, 0, 1, 0, 0, 5},
+                           {1, -1, 2, -2, 2, -4},
+                           {0, 3, 0, 1e-9, -1, 0},
+                           {4, 0, 0, 0, 0, -1}};
+  for (unsigned int c = 0; c < 5; c++) {
+    const real *a = cases[c], *b = cases[c] + 3;
+    unit_quaternion<real> u;
+    ASSERT_EQUAL(unit_quaternion<real>::from_two_vectors(a, b, u), SUCCESS);
+    real ua[3], ub[3], r[3];
+    unit_of(a, ua);
+    unit_of(b, ub);
+    u.rotate(ua, r);
+    for (unsigned int k = 0; k < 3; k++)
+      ASSERT_DBL_NEAR_TOL(r[k], ub[k], 1e-8);
+    real d = 0;
+    u.get().det(d);
+    ASSERT_DBL_NEAR_TOL(d, 1, 1e-12);
+  }
+  // opposite vectors, a half turn about an axis perpendicular to a
+  const real a[3] = {1, 2, 3}, b[3] = {-2, -4, -6};
+  unit_quaternion<real> u;
+  unit_quaternion<real>::from_two_vectors(a, b, u);
+  real w = 1, v[3];
+  u.scalar(w);
+  u.vector(v);
+  ASSERT_DBL_NEAR_TOL(w, 0, 1e-15);
+  ASSERT_DBL_NEAR_TOL(v[0] * a[0] + v[1] * a[1] + v[2] * a[2], 0, 1e-15);
+  const real zero[3] = {0, 0, 0};
+  ASSERT_EQUAL(unit_quaternion<real>::from_two_vectors(a, zero, u), ARG_ERROR);
+}
+/**
+  failures of from_two_vectors over random b = -k a, where rounding
+  leaves w a few ulps from zero and a x b often exactly zero
+ */
+template <class T> static unsigned int opposite_failures(T tol) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<T> coord(-5, 5), scale(0.1f, 10);
+  unsigned int failures = 0;
+  for (unsigned int i = 0; i < 20000; i++) {
+    T a[3] = {coord(gen), coord(gen), coord(gen)}, k = scale(gen);
+    T b[3] = {-k * a[0], -k * a[1], -k * a[2]};
+    unit_quaternion<T> u;
+    unit_quaternion<T>::from_two_vectors(a, b, u);
+    T r[3], n = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    u.rotate(a, r);
+    // a turns onto -a
+    for (unsigned int j = 0; j < 3; j++)
+      if (std::fabs(r[j] + a[j]) > tol * n) {
+        failures++;
+        break;
+      }
+  }
+  return failures;
+}
+CTEST(unit, test_from_two_vectors_random_opposites) {
+  ASSERT_EQUAL(opposite_failures<float>(1e-5f), 0);
+  ASSERT_EQUAL(opposite_failures<double>(1e-12), 0);
+}
+CTEST(unit, test_look_at) {
+  // every quadrant, including half turns where w is zero
+  const real cases[][6] = {{0, 0, 1, 0, 1, 0},   {0, 0, -1, 0, 1, 0},
+                           {0, 0, -1, 1, -1, 0}, {1, 0, 0, 0, 0, 1},
+                           {-1, 2, 0.5, 0, 0, 1}, {0, -1, 0, 0, 0, -1},
+                           {3, 3, 3, 0, 1, 0},   {0, 1, 0, 0, 2, 0}};
+  for (unsigned int c = 0; c < 8; c++) {
+    const real *f = cases[c], *up = cases[c] + 3;
+    unit_quaternion<real> u;
+    ASSERT_EQUAL(unit_quaternion<real>::look_at(f, up, u), SUCCESS);
+    const real ex[3] = {1, 0, 0}, ey[3] = {0, 1, 0}, ez[3] = {0, 0, 1};
+    real x[3], y[3], z[3], uf[3];
+    u.rotate(ex, x);
+    u.rotate(ey, y);
+    u.rotate(ez, z);
+    unit_of(f, uf);
+    for (unsigned int k = 0; k < 3; k++)
+      ASSERT_DBL_NEAR_TOL(z[k], uf[k], 1e-12);
+    // y is up made perpendicular, x completes a right handed frame
+    real side[3] = {up[1] * uf[2] - up[2] * uf[1],
+                    up[2] * uf[0] - up[0] * uf[2],
+                    up[0] * uf[1] - up[1] * uf[0]};
+    real s2 = side[0] * side[0] + side[1] * side[1] + side[2] * side[2];
+    if (s2 > 1e-6) {
+      unit_of(side, side);
+      for (unsigned int k = 0; k < 3; k++)
+        ASSERT_DBL_NEAR_TOL(x[k], side[k], 1e-12);
+      ASSERT_TRUE(y[0] * up[0] + y[1] * up[1] + y[2] * up[2] > 0);
+    }
+    ASSERT_DBL_NEAR_TOL(y[0] * z[0] + y[1] * z[1] + y[2] * z[2], 0, 1e-12);
+    real d = 0;
+    u.get().det(d);
+    ASSERT_DBL_NEAR_TOL(d, 1, 1e-12);
+  }
+  const real zero[3] = {0, 0, 0}, up[3] = {0, 1, 0};
+  unit_quaternion<real> u;
+  ASSERT_EQUAL(unit_quaternion<real>::look_at(zero, up, u), ARG_ERROR);
+}
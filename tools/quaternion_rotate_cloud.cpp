@@ -0,0 +1,81 @@
+// rotates a raw point cloud file of interleaved x y z values, see
+// usage below
+#include "../quaternion_cloud.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace quat11;
+
+static int usage() {
+  std::cerr << "usage: quaternion_rotate_cloud [--threads n] [--direct]"
+               " [--double]\n"
+               "         input output w x y z [tx ty tz]\n"
+               "rotates the raw float (or double) x y z points of input by"
+               " the\nquaternion w + xi + yj + zk, adds the translation and"
+               " writes\noutput. --direct writes through O_DIRECT.\n";
+  return 2;
+}
+
+template <class T>
+static int run(const char *input, const char *output, const double c[7],
+               bool translate, const cloud_options &options) {
+  quaternion<T> q(static_cast<T>(c[0]), static_cast<T>(c[1]),
+                  static_cast<T>(c[2]), static_cast<T>(c[3]));
+  const T t[3] = {static_cast<T>(c[4]), static_cast<T>(c[5]),
+                  static_cast<T>(c[6])};
+  int error = 0;
+  auto start = std::chrono::steady_clock::now();
+  QUATERNION_FLAGS res = rotate_cloud_file(input, output, q,
+                                           translate ? t : nullptr, options,
+                                           error);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+  if (res == SIZE_ERROR) {
+    std::cerr << input << ": size is not a whole number of points\n";
+    return 1;
+  }
+  if (res != SUCCESS) {
+    if (error != 0)
+      std::cerr << "error: " << std::strerror(error) << "\n";
+    else
+      std::cerr << "error: zero quaternion or input and output are one file\n";
+    return 1;
+  }
+  struct stat st;
+  stat(output, &st);
+  double bytes = static_cast<double>(st.st_size);
+  std::cerr << static_cast<long long>(bytes / (3 * sizeof(T))) << " points in "
+            << s << " s, " << 2 * bytes / s / 1e9 << " GB/s read and write\n";
+  return 0;
+}
+
+int main(int argc, const char *argv[]) {
+  cloud_options options;
+  bool wide = false;
+  int i = 1;
+  for (; i < argc && std::strncmp(argv[i], "--", 2) == 0; i++) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      options.threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+    else if (std::strcmp(argv[i], "--direct") == 0)
+      options.direct = true;
+    else if (std::strcmp(argv[i], "--double") == 0)
+      wide = true;
+    else
+      return usage();
+  }
+  const int rest = argc - i;
+  if (rest != 6 && rest != 9)
+    return usage();
+  double c[7] = {0, 0, 0, 0, 0, 0, 0};
+  for (int k = 0; k < rest - 2; k++) {
+    char *end = nullptr;
+    c[k] = std::strtod(argv[i + 2 + k], &end);
+    if (end == argv[i + 2 + k] || *end != '\0')
+      return usage();
+  }
+  const bool translate = rest == 9;
+  return wide ? run<double>(argv[i], argv[i + 1], c, translate, options)
+              : run<float>(argv[i], argv[i + 1], c, translate, options);
+}